@@ -0,0 +1,76 @@
+#include "libmaglev.h"
+#include <stdio.h>
+
+// Minimal embedding of libmaglev: build a table, route flows, take a
+// backend down, then remove it and count how many flows moved.
+
+#define FLOWS 100000
+
+static int check(libmaglev_status status, const char *what) {
+    if (status != LIBMAGLEV_OK) {
+        fprintf(stderr, "%s: %s\n", what, libmaglev_strerror(status));
+        return 1;
+    }
+    return 0;
+}
+
+int main(void) {
+    static const char *const backends[] = { "10.0.0.1:80", "10.0.0.2:80", "10.0.0.3:80", "10.0.0.4:80" };
+    const uint32_t backend_count = sizeof(backends) / sizeof(backends[0]);
+    static uint32_t before[FLOWS];
+
+    libmaglev_t *lm;
+    if (check(libmaglev_create(65537, &lm), "create")) {
+        return 1;
+    }
+
+    // Ids are ours to choose; here they index the backends array
+    for (uint32_t id = 0; id < backend_count; id++) {
+        if (check(libmaglev_add_backend(lm, id, backends[id]), "add")) {
+            libmaglev_destroy(lm);
+            return 1;
+        }
+    }
+    libmaglev_commit(lm);
+
+    uint32_t per_backend[4] = {0};
+    for (uint64_t flow = 0; flow < FLOWS; flow++) {
+        before[flow] = libmaglev_lookup(lm, libmaglev_hash_key(flow));
+        per_backend[before[flow]]++;
+    }
+    printf("%u flows over %u backends:\n", FLOWS, backend_count);
+    for (uint32_t id = 0; id < backend_count; id++) {
+        printf("  %-12s %u\n", backends[id], per_backend[id]);
+    }
+
+    // A health check failed: redirect now, rebuild later
+    libmaglev_set_down(lm, 2, true);
+    uint32_t redirected = 0;
+    for (uint64_t flow = 0; flow < FLOWS; flow++) {
+        if (libmaglev_lookup(lm, libmaglev_hash_key(flow)) != before[flow]) {
+            redirected++;
+        }
+    }
+    printf("%s down: %u flows redirected without a rebuild\n", backends[2], redirected);
+
+    // Decommission it for good
+    libmaglev_remove_backend(lm, 2);
+    libmaglev_commit(lm);
+    uint32_t moved = 0;
+    for (uint64_t flow = 0; flow < FLOWS; flow++) {
+        uint32_t id = libmaglev_lookup(lm, libmaglev_hash_key(flow));
+        if (id != before[flow] && before[flow] != 2) {
+            moved++;
+        }
+    }
+    printf("%s removed: %u flows of healthy backends moved\n", backends[2], moved);
+
+    libmaglev_info info;
+    libmaglev_get_info(lm, &info);
+    printf("Table: %u slots, %u backends, generation %llu, %.1f KB\n",
+           info.table_size, info.published_backends,
+           (unsigned long long)info.published_generation, info.memory_bytes / 1024.0);
+
+    libmaglev_destroy(lm);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef BOUNDED_LOAD_H
+#define BOUNDED_LOAD_H
+
+#include "keystream.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Consistent hashing with bounded loads on top of the published Maglev
+// table. A lookup whose owner already carries more than (1+epsilon) times
+// the average in-flight load continues along the key's own probe sequence
+// (slot, slot + step, ... with a key-derived step) to the first backend
+// under the bound. In-flight counters are per-backend atomics on separate
+// cache lines and are claimed with compare-and-swap, so no lock is taken.
+
+#define BOUNDED_UNBOUNDED (-1.0)    // Epsilon that disables the bound
+
+typedef struct {
+    uint32_t inflight;
+    char pad[60];
+} __attribute__((aligned(64))) BoundedCounter;
+
+typedef struct {
+    double epsilon;
+    uint32_t node_count;        // Published node snapshot size
+    uint32_t active_count;      // Nodes not marked failed
+    BoundedCounter *load;       // Per-node in-flight requests
+    BoundedCounter total;       // Sum of load[]
+} BoundedLoad;
+
+typedef struct {
+    KeyStreamConfig keys;
+    uint64_t key_count;         // Lookups per epsilon, over all threads
+    uint32_t inflight;          // Requests held in flight per thread
+    uint32_t threads;
+} BoundedSweepConfig;
+
+// Counters for the published table (table lock held while in use)
+bool bounded_load_init(BoundedLoad *bl, double epsilon);
+void bounded_load_free(BoundedLoad *bl);
+
+// Pick a backend for a key and count the request in flight; probes
+// receives the number of slots examined. Returns UINT32_MAX if no node.
+uint32_t bounded_load_acquire(BoundedLoad *bl, uint64_t key_hash, uint32_t *probes);
+
+// Finish a request started with bounded_load_acquire
+void bounded_load_release(BoundedLoad *bl, uint32_t owner);
+
+// Max backend load and lookup cost for a range of epsilon values
+bool bounded_load_sweep(const BoundedSweepConfig *config);
+
+#endif // BOUNDED_LOAD_H
@@ -0,0 +1,40 @@
+#ifndef CHURN_H
+#define CHURN_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Churn macro-benchmark: generate simulator command streams for realistic
+// membership churn, then replay them quietly and report rebuild latency
+// percentiles, CPU time and peak RSS.
+
+typedef enum {
+    CHURN_ROLLING,              // Restart backends one by one (del, add)
+    CHURN_ZONE,                 // Whole zones fail and recover
+    CHURN_STEADY                // Random adds and removes around a steady size
+} ChurnScenario;
+
+typedef struct {
+    ChurnScenario scenario;
+    uint32_t backends;          // Initial backend count
+    uint32_t zones;             // Backends are spread round-robin over zones
+    uint32_t events;            // Restarts, outages or add/remove operations
+    uint32_t table_size;
+    uint64_t seed;
+} ChurnGenConfig;
+
+// Command executor used by the runner (the CLI's command dispatcher)
+typedef void (*ChurnExecuteFn)(char *line);
+
+bool churn_parse_scenario(const char *name, ChurnScenario *scenario);
+void churn_default_config(ChurnGenConfig *config, ChurnScenario scenario);
+
+// Write a command script for the scenario
+bool churn_generate(const char *filename, const ChurnGenConfig *config);
+
+// Replay a command script with success messages off and 'show' commands
+// skipped, pacing commands at rate per second (0 = as fast as possible).
+// Lines starting with "#! measure" reset the statistics, so setup is not counted.
+bool churn_run(const char *filename, double rate, ChurnExecuteFn execute);
+
+#endif // CHURN_H
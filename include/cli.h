@@ -0,0 +1,17 @@
+#ifndef CLI_H
+#define CLI_H
+
+#include "maglev_core.h"
+#include <stdbool.h>
+
+// Simulator front-end state that the Maglev core does not need: whether
+// successful changes are reported, and the display colour of each node.
+
+bool cli_set_verbose(bool verbose);        // Returns the previous setting
+bool cli_is_verbose(void);
+
+// ANSI code of a node's display colour, -1 if none. A node gets a colour
+// not used by other members on first display (table lock held).
+int cli_node_color(Node *node);
+
+#endif // CLI_H
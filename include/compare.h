@@ -0,0 +1,29 @@
+#ifndef COMPARE_H
+#define COMPARE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint32_t node_count;        // Synthetic backends (0 = use current simulator nodes)
+    uint32_t table_size;        // Maglev table size
+    uint32_t key_count;         // Sample keys for lookup, balance and disruption
+    uint32_t threads;           // Most threads for compare threads (0 = all online CPUs)
+} CompareConfig;
+
+// Benchmark every consistent-hash engine on the same node set
+bool compare_engines(const CompareConfig *config);
+
+// Prime versus power-of-two Maglev table sizing: build time, slot and key
+// balance, and lookup cost (modulo versus mask)
+bool compare_sizing(const CompareConfig *config);
+
+// Preference list generation on the worker pool from 1 thread to all
+// online CPUs, with the single-threaded fill for the whole-build speedup
+bool compare_threads(const CompareConfig *config);
+
+// Generic versus size-specialized table kernels (permutation and key to
+// slot reduction) for every size with a specialized kernel
+bool compare_kernels(const CompareConfig *config);
+
+#endif // COMPARE_H
@@ -0,0 +1,27 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "maglev.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Generation-tagged deltas between consecutive lookup tables, for syncing
+// remote LB instances. Slots are compared by owner name, so index shifts
+// caused by removals do not count as changes. Changed slot ranges are
+// varint packed with run-length encoded owners.
+
+// Order-sensitive 64-bit fingerprint of a table and its node names
+uint64_t delta_fingerprint(const uint32_t *table, uint32_t table_size,
+                           const char (*names)[MAX_NODE_NAME_LEN], uint32_t node_count);
+
+// Write a delta from the last exported table to the current table and
+// make the current table the new baseline
+bool delta_export(const char *filename);
+
+// Apply a delta file to the local receiver replica and verify fingerprints
+bool delta_apply(const char *filename);
+
+// Forget the export baseline and the receiver replica
+void delta_reset(void);
+
+#endif // DELTA_H
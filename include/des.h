@@ -0,0 +1,36 @@
+#ifndef DES_H
+#define DES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "maglev_core.h"
+
+// Discrete-event traffic simulation: Poisson request arrivals are routed
+// through a private Maglev table to FIFO backends with exponential service
+// times, while a timeline of add/del/drain/rate events changes membership.
+// Reports per-backend utilisation and latency percentiles per interval.
+//
+// Scenario file format (one directive per line, '#' starts a comment):
+//   duration <seconds>            Simulated time (default 3600)
+//   rate <requests/s>             Arrival rate (default 1000)
+//   service <requests/s>          Default backend capacity (default 400)
+//   queue <requests>              Per-backend queue limit, excess is dropped (default 10000)
+//   report <seconds>              Report interval (default duration / 24)
+//   table <size>                  Maglev table size (default: current table size)
+//   flows <n>                     Distinct flows (default 1000000)
+//   dist <uniform|zipf|hotspot> [param]
+//   seed <n>
+//   backend <name> [capacity]     Initial backend (default: the current nodes)
+//   at <seconds> add <name> [capacity]
+//   at <seconds> del <name>       Remove now, queued requests are lost
+//   at <seconds> drain <name>     Stop routing to it, finish queued requests
+//   at <seconds> rate <requests/s>
+//
+// table_size and nodes are the defaults for 'table' and 'backend' (0 and
+// NULL: DEFAULT_TABLE_SIZE and no backends). The simulation reads no
+// simulator state. Its engine uses prime sizes, so other sizes are rounded
+// up and the report says so.
+bool des_run_scenario(const char *filename, uint32_t table_size,
+                      const char (*nodes)[MAX_NODE_NAME_LEN], uint32_t node_count);
+
+#endif // DES_H
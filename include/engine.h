@@ -0,0 +1,30 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Common interface for consistent-hash engines, used for head-to-head comparisons.
+// Nodes carry a caller-chosen stable id; lookup returns that id (UINT32_MAX if none).
+// add/remove only record the change, commit rebuilds whatever the engine precomputes.
+typedef struct {
+    const char *name;
+    void *(*create)(uint32_t table_size);
+    void (*destroy)(void *state);
+    bool (*add)(void *state, uint32_t id, const char *name);
+    bool (*remove)(void *state, uint32_t id);
+    void (*commit)(void *state);
+    uint32_t (*lookup)(const void *state, uint64_t key_hash);
+    size_t (*memory)(const void *state);
+} EngineOps;
+
+extern const EngineOps maglev_engine;
+extern const EngineOps ring_engine;
+extern const EngineOps rendezvous_engine;
+extern const EngineOps jump_engine;
+
+// All engines, NULL terminated
+extern const EngineOps *const all_engines[];
+
+#endif // ENGINE_H
@@ -0,0 +1,39 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "maglev_core.h"
+
+// Fleet simulation: many LB instances receive the same membership changes,
+// each applying them after its own propagation delay. While a change is
+// propagating, instances on different generations can send the same flow
+// to different backends. A shared key stream is run through the fleet in
+// simulated time and the disagreement is reported per change.
+//
+// Tables depend only on membership, so each generation is built once and
+// every instance that has applied it references the same copy: hundreds of
+// instances cost one table per generation, not one per instance.
+
+typedef struct {
+    uint32_t instances;         // LB instances
+    uint32_t changes;           // Membership changes (random adds and removes)
+    uint32_t table_size;
+    double interval_ms;         // Time between changes at the control plane
+    double delay_ms;            // Propagation delay every instance sees
+    double jitter_ms;           // Extra delay, uniform in [0, jitter_ms) per instance and change
+    uint32_t keys_per_tick;     // Shared key stream sample per 1 ms tick
+    uint32_t threads;           // Workers building tables and simulating ticks
+    uint64_t seed;
+    const char (*backends)[MAX_NODE_NAME_LEN];  // Initial members (synthetic if fewer than 2)
+    uint32_t backend_count;
+} FleetConfig;
+
+void fleet_default_config(FleetConfig *config);
+
+// Run the simulation from config->backends (synthetic backends if there
+// are fewer than 2) and print the per-change report. Uses no simulator
+// state, so callers copy the current nodes and run without the table lock.
+bool fleet_run(const FleetConfig *config);
+
+#endif // FLEET_H
@@ -10,5 +10,12 @@ uint32_t hash_skip(const char *str, uint32_t table_size);
 // General hash functions
 uint32_t djb2_hash(const char *str);
 uint32_t sdbm_hash(const char *str);
+uint32_t fnv1a_hash(const char *str);
+
+// 64-bit name hash (combines DJB2 and FNV-1a, then finalizes)
+uint64_t hash_name64(const char *str);
+
+// Flow key hash (64-bit finalizer, used to map keys onto table slots)
+uint64_t hash_key64(uint64_t key);
 
 #endif // HASH_H
\ No newline at end of file
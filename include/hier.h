@@ -0,0 +1,72 @@
+#ifndef HIER_H
+#define HIER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Hierarchical Maglev: a top-level table picks a pool, and each pool's own
+// smaller table picks a backend, so a change inside a pool rebuilds only
+// that pool. Tables are compact (no preference lists) so 100k+ backends fit.
+
+// Maglev table over members identified by caller ids; entries hold the ids
+typedef struct {
+    uint32_t table_size;
+    uint32_t *table;            // Slot -> member id (UINT32_MAX if empty)
+    uint32_t count;
+    uint32_t capacity;
+    uint32_t *ids;
+    uint32_t *offset;           // Permutation start per member
+    uint32_t *skip;             // Permutation step per member
+} CompactMaglev;
+
+bool compact_maglev_init(CompactMaglev *t, uint32_t table_size, uint32_t capacity);
+void compact_maglev_free(CompactMaglev *t);
+bool compact_maglev_add(CompactMaglev *t, uint32_t id, const char *name);
+bool compact_maglev_remove(CompactMaglev *t, uint32_t id);
+bool compact_maglev_build(CompactMaglev *t);
+size_t compact_maglev_memory(const CompactMaglev *t);
+
+static inline uint32_t compact_maglev_lookup(const CompactMaglev *t, uint64_t key_hash) {
+    return t->table[key_hash % t->table_size];
+}
+
+// Top table over pool ids, one table per pool over backend ids
+typedef struct {
+    CompactMaglev top;
+    CompactMaglev *pools;
+    uint32_t pool_count;
+} HierMaglev;
+
+bool hier_init(HierMaglev *h, uint32_t pools, uint32_t backends_per_pool,
+               uint32_t pool_table_size, uint32_t top_table_size);
+void hier_free(HierMaglev *h);
+size_t hier_memory(const HierMaglev *h);
+
+// Remove a backend from its pool and rebuild only that pool's table
+bool hier_remove_backend(HierMaglev *h, uint32_t pool, uint32_t id);
+
+static inline uint32_t hier_lookup(const HierMaglev *h, uint64_t key_hash) {
+    uint32_t pool = compact_maglev_lookup(&h->top, key_hash);
+    if (pool == UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    // The pool slot comes from the high 32 bits by multiply-shift: no
+    // second division, and independent of the top-level modulo
+    const CompactMaglev *t = &h->pools[pool];
+    return t->table[(uint32_t)(((key_hash >> 32) * t->table_size) >> 32)];
+}
+
+typedef struct {
+    uint32_t pools;
+    uint32_t backends_per_pool;
+    uint32_t pool_table_size;   // 0: about 10 slots per backend
+    uint32_t top_table_size;    // 0: about 100 slots per pool
+    uint64_t keys;              // Sample keys for moved-share and lookup timing
+} HierConfig;
+
+// Build hierarchical and flat tables over the same backends and report
+// build and single-change rebuild time, memory, balance and lookup cost
+bool hier_compare(const HierConfig *config);
+
+#endif // HIER_H
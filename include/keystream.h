@@ -0,0 +1,52 @@
+#ifndef KEYSTREAM_H
+#define KEYSTREAM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Key popularity distributions
+typedef enum {
+    KEYDIST_UNIFORM,            // Every flow equally likely
+    KEYDIST_ZIPF,               // Rank-frequency power law (elephant flows)
+    KEYDIST_HOTSPOT             // Small hot set receives most of the traffic
+} KeyDistribution;
+
+typedef struct {
+    KeyDistribution dist;
+    uint32_t flow_count;        // Number of distinct flows
+    double zipf_s;              // Zipf exponent
+    double hot_key_share;       // Hotspot: share of flows that are hot
+    double hot_traffic_share;   // Hotspot: share of traffic sent to hot flows
+    uint64_t seed;              // RNG seed
+} KeyStreamConfig;
+
+typedef struct {
+    KeyStreamConfig config;
+    uint64_t rng_state;         // xorshift64* state
+    uint32_t *alias_prob;       // Zipf alias table: acceptance threshold (2^32 scale)
+    uint32_t *alias_index;      // Zipf alias table: alias rank
+    uint32_t hot_count;         // Hotspot: number of hot flows
+    uint32_t hot_threshold;     // Hotspot: traffic threshold (2^32 scale)
+    bool borrowed;              // Alias table belongs to the stream this one was forked from
+} KeyStream;
+
+// Parse a distribution name ("uniform", "zipf", "hotspot")
+bool keystream_parse_distribution(const char *name, KeyDistribution *dist);
+const char *keystream_distribution_name(KeyDistribution dist);
+
+// Fill a config with defaults for the given distribution
+void keystream_default_config(KeyStreamConfig *config, KeyDistribution dist);
+
+// Key stream lifecycle
+bool keystream_init(KeyStream *ks, const KeyStreamConfig *config);
+void keystream_free(KeyStream *ks);
+
+// Per-thread stream over the same flow population: shares the base stream's
+// alias table read-only and draws from its own RNG sequence. The base must
+// outlive the fork.
+void keystream_fork(KeyStream *ks, const KeyStream *base, uint32_t stream_id);
+
+// Generate the next batch of flow key hashes
+void keystream_fill(KeyStream *ks, uint64_t *keys, uint32_t count);
+
+#endif // KEYSTREAM_H
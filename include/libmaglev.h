@@ -0,0 +1,91 @@
+#ifndef LIBMAGLEV_H
+#define LIBMAGLEV_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// libmaglev: embeddable Maglev consistent hashing.
+//
+// Every table lives behind its own handle; the library keeps no global
+// state and never writes to stdout/stderr, errors come back as status codes.
+//
+// Threading: control-plane calls (add/remove/set_down/commit) on one handle
+// are serialised internally and may come from any thread. libmaglev_lookup
+// never blocks and never writes shared memory: the published table is
+// double-buffered behind a per-buffer sequence counter, so lookups run
+// concurrently with commits and simply retry if a buffer is rewritten
+// underneath them. A handle must not be destroyed while lookups are running.
+//
+// Backends carry a caller-chosen id (anything but LIBMAGLEV_NO_BACKEND),
+// which is what lookups return. The name seeds the backend's preference
+// list, so the same set of names gives the same table in every process.
+
+#if defined(__GNUC__)
+#define LIBMAGLEV_API __attribute__((visibility("default")))
+#else
+#define LIBMAGLEV_API
+#endif
+
+#define LIBMAGLEV_NO_BACKEND UINT32_MAX
+#define LIBMAGLEV_MAX_BACKENDS 4096
+#define LIBMAGLEV_MAX_NAME_LEN 255
+#define LIBMAGLEV_MAX_TABLE_SIZE (1u << 30)
+
+typedef struct libmaglev libmaglev_t;
+
+typedef enum {
+    LIBMAGLEV_OK = 0,
+    LIBMAGLEV_EINVAL,           // Bad argument (NULL, empty or too long name, reserved id, bad size)
+    LIBMAGLEV_ENOMEM,           // Allocation failed, the handle is unchanged
+    LIBMAGLEV_EEXIST,           // Backend id or name already present
+    LIBMAGLEV_ENOENT,           // No backend with that id
+    LIBMAGLEV_EFULL             // LIBMAGLEV_MAX_BACKENDS reached
+} libmaglev_status;
+
+typedef struct {
+    uint32_t table_size;        // Slots (a prime, or a power of two)
+    uint32_t backends;          // Backends in the pending membership
+    uint32_t published_backends;// Backends in the published table
+    uint32_t down_backends;     // Pending backends marked down
+    uint64_t generation;        // Membership changes so far
+    uint64_t published_generation; // Generation of the published table
+    size_t memory_bytes;        // Tables, snapshots and preference lists
+} libmaglev_info;
+
+LIBMAGLEV_API const char *libmaglev_strerror(libmaglev_status status);
+
+// Create an empty table. table_size is rounded up to the next prime
+// (0 selects the default, 65537; at most LIBMAGLEV_MAX_TABLE_SIZE).
+// Lookups return LIBMAGLEV_NO_BACKEND until the first commit with at least
+// one healthy backend.
+LIBMAGLEV_API libmaglev_status libmaglev_create(uint32_t table_size, libmaglev_t **out);
+
+// Same with table_size rounded up to a power of two (0 selects 65536).
+// Backends get odd skips, so preference lists stay full permutations, and
+// lookups mask the key hash instead of dividing it.
+LIBMAGLEV_API libmaglev_status libmaglev_create_pow2(uint32_t table_size, libmaglev_t **out);
+LIBMAGLEV_API void libmaglev_destroy(libmaglev_t *lm);
+
+// Membership changes are staged; libmaglev_commit rebuilds and publishes them
+// as one new table, so a burst of changes costs one rebuild.
+LIBMAGLEV_API libmaglev_status libmaglev_add_backend(libmaglev_t *lm, uint32_t id, const char *name);
+LIBMAGLEV_API libmaglev_status libmaglev_remove_backend(libmaglev_t *lm, uint32_t id);
+
+// Mark a backend down or up. Going down takes effect immediately: lookups
+// that land on its slots are redirected to each slot's backup owner without
+// a rebuild. The next commit leaves down backends out of the table.
+LIBMAGLEV_API libmaglev_status libmaglev_set_down(libmaglev_t *lm, uint32_t id, bool down);
+
+// Rebuild the table from the staged membership and publish it
+LIBMAGLEV_API libmaglev_status libmaglev_commit(libmaglev_t *lm);
+
+// Map a flow key hash to a backend id (LIBMAGLEV_NO_BACKEND if none).
+// key_hash should be well mixed; libmaglev_hash_key turns raw integer keys
+// such as packed 5-tuples into suitable hashes.
+LIBMAGLEV_API uint32_t libmaglev_lookup(const libmaglev_t *lm, uint64_t key_hash);
+LIBMAGLEV_API uint64_t libmaglev_hash_key(uint64_t key);
+
+LIBMAGLEV_API libmaglev_status libmaglev_get_info(libmaglev_t *lm, libmaglev_info *info);
+
+#endif // LIBMAGLEV_H
@@ -0,0 +1,99 @@
+#ifndef LOAD_STATS_H
+#define LOAD_STATS_H
+
+#include "maglev.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per-backend traffic counters fed by the lookup path. Every lookup thread
+// owns a private shard indexed by the published table_nodes index (index
+// table_node_count collects unassigned slots); shards are cache-line
+// aligned and padded, so counting never shares a line between threads.
+// Shards are folded into per-name totals under the table lock before a new
+// node snapshot is published, and summed on demand by 'show load'.
+//
+// The hot path does a single add per key: hits and bytes are packed into
+// one word (bytes << LOAD_PACK_BITS | hits), and consecutive keys rotate
+// over lanes so repeated hits on one backend do not form a serial chain.
+// Packed words are widened before the hit field can overflow.
+
+#define LOAD_MAX_SHARDS 65
+#define LOAD_LOOKUP_SHARD 64    // maglev_lookup() callers (control thread); lookup threads use 0..63
+#define LOAD_SHARD_COUNTERS (MAX_NODES + 1)
+#define LOAD_LANES 4
+#define LOAD_PACK_BITS 20
+#define LOAD_PACK_LIMIT ((1u << LOAD_PACK_BITS) - 1)
+
+typedef struct {
+    uint64_t hits;
+    uint64_t bytes;
+} LoadCounter;
+
+typedef struct {
+    uint64_t packed[LOAD_LANES][LOAD_SHARD_COUNTERS];
+    LoadCounter wide[LOAD_SHARD_COUNTERS];
+    uint32_t pending;           // Keys counted into packed[] since the last widen
+} LoadShard;
+
+// Enable or disable counting, returns the previous setting
+bool load_stats_set_enabled(bool enabled);
+bool load_stats_enabled(void);
+
+// Counter shard for a lookup thread, or NULL when counting is disabled.
+// A shard must only be written by one thread at a time.
+LoadShard *load_stats_shard(uint32_t shard_id);
+
+// Move packed counts into the wide counters
+void load_stats_widen(LoadShard *shard);
+
+// Synthetic packet size for a flow key (64..1500 bytes)
+static inline uint32_t load_stats_packet_bytes(uint64_t key) {
+    return 64 + (uint32_t)(((key >> 32) * 1437) >> 32);
+}
+
+static inline uint64_t load_stats_pack(uint64_t key) {
+    return ((uint64_t)load_stats_packet_bytes(key) << LOAD_PACK_BITS) | 1;
+}
+
+// Count a batch of resolved owners (lookup path), count <= LOAD_PACK_LIMIT
+static inline void load_stats_count_batch(LoadShard *shard, const uint32_t *owners,
+                                          const uint64_t *keys, uint32_t count) {
+    if (shard->pending + count > LOAD_PACK_LIMIT) {
+        load_stats_widen(shard);
+    }
+    shard->pending += count;
+
+    uint32_t i = 0;
+    for (; i + LOAD_LANES <= count; i += LOAD_LANES) {
+        shard->packed[0][owners[i]] += load_stats_pack(keys[i]);
+        shard->packed[1][owners[i + 1]] += load_stats_pack(keys[i + 1]);
+        shard->packed[2][owners[i + 2]] += load_stats_pack(keys[i + 2]);
+        shard->packed[3][owners[i + 3]] += load_stats_pack(keys[i + 3]);
+    }
+    for (; i < count; i++) {
+        shard->packed[0][owners[i]] += load_stats_pack(keys[i]);
+    }
+}
+
+// Count one resolved owner (table_node_count for an unassigned slot)
+static inline void load_stats_count_one(LoadShard *shard, uint32_t owner, uint64_t key) {
+    if (shard->pending == LOAD_PACK_LIMIT) {
+        load_stats_widen(shard);
+    }
+    shard->pending++;
+    shard->packed[0][owner] += load_stats_pack(key);
+}
+
+// Move shard counts into per-name totals (table lock held, before table_nodes changes)
+void load_stats_fold(void);
+
+// Clear all counters and totals
+void load_stats_reset(void);
+
+// Print per-backend hits and bytes against each backend's slot share
+void load_stats_show(void);
+
+// Lookup throughput with counting off versus on, for 1..max_threads threads
+void load_stats_bench(uint32_t max_threads, uint64_t lookups_per_thread);
+
+#endif // LOAD_STATS_H
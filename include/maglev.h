@@ -1,20 +1,11 @@
 #ifndef MAGLEV_H
 #define MAGLEV_H
 
+#include "maglev_core.h"
+#include "table_kernel.h"
 #include <stdint.h>
 #include <stdbool.h>
-
-#define MAX_NODE_NAME_LEN 256
-#define MAX_NODES 1000
-#define DEFAULT_TABLE_SIZE 65537
-
-typedef struct {
-    char name[MAX_NODE_NAME_LEN];
-    bool is_active;
-    uint32_t *preference_list;  // Preference list
-    uint32_t next_index;        // Next index position to try
-    int color_index;            // Index in color array for display
-} Node;
+#include <pthread.h>
 
 typedef struct {
     Node *nodes[MAX_NODES];     // Node array
@@ -22,29 +13,98 @@ typedef struct {
     uint32_t *lookup_table;     // Lookup table
     uint32_t table_size;        // Lookup table size
     bool is_initialized;        // Whether initialized
+    Node *table_nodes[MAX_NODES];   // Node snapshot the published lookup table indexes into
+    uint32_t table_node_count;      // Node count of that snapshot
+    uint64_t generation;            // Membership generation, bumped on every change
+    uint64_t table_generation;      // Membership generation the lookup table reflects
+    uint32_t *backup_table;         // Next owner of each slot, used while its owner is failed
+    uint8_t table_node_down[MAX_NODES]; // Failure flags, indexed like table_nodes
+    SlotIndex slot_index;           // Slots owned by each table node, built during the fill
+    bool slot_index_stale;          // Left behind by a rollback: use maglev_slot_index()
+    bool pow2;                      // Power-of-two sizing: odd skips and mask lookups
+    const TableKernel *kernel;      // Batch kernels for table_size, chosen at init and resize
 } MaglevTable;
 
 // Global Maglev table instance
 extern MaglevTable g_maglev;
 
-// Core functions
-bool maglev_init(uint32_t table_size);
+// Control-plane results. The core does no terminal output: callers report
+// the status, and what the change did from MaglevChange.
+typedef enum {
+    MAGLEV_OK = 0,
+    MAGLEV_ENOTINIT,            // Table not initialized
+    MAGLEV_EINVAL,              // Empty or too long node name
+    MAGLEV_EEXIST,              // Node already exists
+    MAGLEV_EDUP,                // Node given more than once in a batch
+    MAGLEV_ENOENT,              // No node with that name
+    MAGLEV_EFULL,               // MAX_NODES reached
+    MAGLEV_ENOMEM,              // Allocation failed, the table is unchanged
+    MAGLEV_ENOHISTORY,          // Rollback with table history off
+    MAGLEV_ERANGE,              // Rollback further back than the kept versions
+    MAGLEV_ESIZE                // Rollback to a version with another table size
+} MaglevStatus;
+
+typedef struct {
+    bool unchanged;             // Nothing to do: same size, absent node, node already in that state
+    bool queued;                // Rebuild handed to the background worker
+    uint32_t failed_index;      // Batch add: name the error refers to
+    uint32_t old_table_size;    // Resize
+    uint32_t node_count;        // Nodes added, or in the restored/resized table
+    uint32_t threads;           // Threads that generated preference lists
+    uint32_t recreated;         // Rollback: removed nodes brought back
+    uint64_t lists_ns;          // Preference list generation
+    uint64_t checkout_ns;       // Rollback: taking the kept tables over, or materializing them
+    bool instant;               // Rollback: a kept flat copy was handed over by pointer
+    uint64_t rebuild_ns;        // Inline rebuild, or handing it to the worker
+    uint64_t redirect_ns;       // Fail: flag flip before the rebuild
+    uint64_t restored_generation;   // Rollback
+    double moved;               // Resize: share of sample keys whose owner changed
+    uint32_t sample_keys;       // Resize: keys sampled for moved
+} MaglevChange;
+
+const char *maglev_strerror(MaglevStatus status);
+
+// Core functions; change may be NULL
+MaglevStatus maglev_init(uint32_t table_size, bool pow2);
+MaglevStatus maglev_resize(uint32_t table_size, MaglevChange *change);
 void maglev_cleanup(void);
-bool maglev_add_node(const char *node_name);
-bool maglev_remove_node(const char *node_name);
+MaglevStatus maglev_add_node(const char *node_name);
+MaglevStatus maglev_add_nodes(const char *const *node_names, uint32_t count, MaglevChange *change);
+MaglevStatus maglev_remove_node(const char *node_name, MaglevChange *change);
+MaglevStatus maglev_fail_node(const char *node_name, MaglevChange *change);
+MaglevStatus maglev_recover_node(const char *node_name, MaglevChange *change);
 void maglev_rebuild_table(void);
-void maglev_show_nodes(void);
-void maglev_show_table(void);
-void maglev_show_table_colored(void);
+MaglevStatus maglev_rollback(uint32_t steps, MaglevChange *change);
+void maglev_publish_down_flags(void);
+
+// Slot ownership index of the published table, rebuilt first if a rollback
+// left it stale (lock held)
+const SlotIndex *maglev_slot_index(void);
+
+// Generate preference lists left pending by a rollback (before a fill, without the lock)
+void maglev_generate_pending_lists(Node *const *nodes, uint32_t count);
+
+// Lookup: map a flow key hash to an index into table_nodes (UINT32_MAX if unassigned).
+// Slots owned by a failed node are redirected to their backup owner.
+// Counted in the load statistics while 'load on' is set (one thread at a time).
+uint32_t maglev_lookup(uint64_t key_hash);
+uint32_t maglev_resolve_slot(uint32_t slot);
+
+// Published table lock: held by readers of lookup_table/table_nodes and by
+// writers of the node array, so the background rebuild worker can snapshot
+// membership and swap in a new table consistently
+void maglev_lock(void);
+void maglev_unlock(void);
+void maglev_wait(pthread_cond_t *cond);    // Wait on cond with the lock held
+
+// Publish notification. down_only: only the failure flags of the published
+// table changed.
+typedef void (*MaglevPublishHook)(bool down_only);
+void maglev_set_publish_hook(MaglevPublishHook hook);
+void maglev_notify_published(bool down_only);
 
 // Helper functions
 int find_node_index(const char *node_name);
-bool is_prime(uint32_t n);
-uint32_t next_prime(uint32_t n);
 int get_max_node_name_length(void);
 
-// Color functions
-int assign_unique_color_index(void);
-void print_colored_text(const char *text, int color_index);
-
 #endif // MAGLEV_H
\ No newline at end of file
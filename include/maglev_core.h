@@ -0,0 +1,100 @@
+#ifndef MAGLEV_CORE_H
+#define MAGLEV_CORE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Maglev algorithm core shared by libmaglev and the simulator: preference
+// lists and table fill only, no global state and no terminal output.
+
+#define MAX_NODE_NAME_LEN 256
+#define MAX_NODES 4096
+#define DEFAULT_TABLE_SIZE 65537
+
+typedef struct {
+    char name[MAX_NODE_NAME_LEN];
+    bool is_active;
+    uint32_t *preference_list;  // Preference list
+    bool list_pending;          // Preference list allocated but not generated yet
+    uint32_t next_index;        // Next index position to try
+    int color_index;            // Display colour, assigned by the simulator CLI (-1 until shown)
+} Node;
+
+// Slot ownership index, kept next to a lookup table in CSR form:
+// node i owns slots[start[i] .. start[i + 1]), in the order it claimed them
+// (ascending when rebuilt from a table by slot_index_build)
+typedef struct {
+    uint32_t *start;            // MAX_NODES + 1 entries
+    uint32_t *slots;            // table_size entries
+} SlotIndex;
+
+bool slot_index_alloc(SlotIndex *index, uint32_t table_size);
+void slot_index_free(SlotIndex *index);
+
+// Rebuild an index from an already filled table (slots in ascending order)
+void slot_index_build(SlotIndex *index, const uint32_t *table, uint32_t table_size, uint32_t node_count);
+
+// Fill a lookup table from a node list (entries are indices into nodes,
+// UINT32_MAX if no node is active). If backup is given, each slot also
+// records the node it would most likely go to without its owner. If index
+// is given, it is filled as slots are claimed.
+void maglev_fill_table(uint32_t *table, uint32_t *backup, SlotIndex *index,
+                       uint32_t table_size, Node *const *nodes, uint32_t node_count);
+
+// Same fill without preference lists: each member walks its permutation
+// (offset, offset + skip, ... mod table_size) through a cursor, so members
+// cost 12 bytes instead of 4 * table_size. Entries are member indices; all
+// members are treated as active. cursor is scratch space for count entries.
+void maglev_fill_compact(uint32_t *table, uint32_t table_size, const uint32_t *offset,
+                         const uint32_t *skip, uint32_t count, uint32_t *cursor);
+
+// Table sizing. Prime sizes are the default; a power-of-two size gives
+// every node an odd skip, which still makes each preference list a full
+// permutation, and lets lookups replace the modulo with a mask.
+bool is_prime(uint32_t n);
+uint32_t next_prime(uint32_t n);
+uint32_t next_pow2(uint32_t n);     // Smallest power of two >= n, at most 2^31
+
+static inline bool maglev_is_pow2(uint32_t n) {
+    return n != 0 && (n & (n - 1)) == 0;
+}
+
+// Table slot of a key hash
+static inline uint32_t maglev_slot(uint64_t key_hash, uint32_t table_size) {
+    if (maglev_is_pow2(table_size)) {
+        return (uint32_t)(key_hash & (table_size - 1));
+    }
+    return (uint32_t)(key_hash % table_size);
+}
+
+// Owner of a slot with failed owners redirected: the slot's backup owner
+// first, then the next healthy owner along the table (owner and backup
+// both down, rare). Entries >= node_limit are unassigned (UINT32_MAX).
+// Loads are relaxed atomics, so seqlock readers may resolve against a
+// table that is being rewritten and discard the result afterwards.
+static inline uint32_t maglev_resolve(const uint32_t *table, const uint32_t *backup, const uint8_t *down,
+                                      uint32_t node_limit, uint32_t table_size, uint32_t slot) {
+    uint32_t owner = __atomic_load_n(&table[slot], __ATOMIC_RELAXED);
+    if (owner >= node_limit) {
+        return UINT32_MAX;
+    }
+    if (!__atomic_load_n(&down[owner], __ATOMIC_RELAXED)) {
+        return owner;
+    }
+
+    uint32_t alt = __atomic_load_n(&backup[slot], __ATOMIC_RELAXED);
+    if (alt < node_limit && !__atomic_load_n(&down[alt], __ATOMIC_RELAXED)) {
+        return alt;
+    }
+
+    for (uint32_t k = 1; k < table_size; k++) {
+        uint32_t next = slot + k < table_size ? slot + k : slot + k - table_size;
+        uint32_t candidate = __atomic_load_n(&table[next], __ATOMIC_RELAXED);
+        if (candidate < node_limit && !__atomic_load_n(&down[candidate], __ATOMIC_RELAXED)) {
+            return candidate;
+        }
+    }
+    return UINT32_MAX;
+}
+
+#endif // MAGLEV_CORE_H
@@ -1,12 +1,14 @@
 #ifndef NODE_H
 #define NODE_H
 
-#include "maglev.h"
+#include "maglev_core.h"
 
 // Node management functions
 Node* node_create(const char *name, uint32_t table_size);
+Node* node_alloc(const char *name, uint32_t table_size);   // Preference list left ungenerated
 void node_destroy(Node *node);
 void node_generate_preference_list(Node *node, uint32_t table_size);
+void node_generate_preference_range(Node *node, uint32_t table_size, uint32_t begin, uint32_t end);
 void node_reset_index(Node *node);
 
 #endif // NODE_H
\ No newline at end of file
@@ -0,0 +1,31 @@
+#ifndef OUTBUF_H
+#define OUTBUF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+// Growable output buffer: render once, write with a single large fwrite
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    bool failed;                // Set when an allocation failed; later appends are dropped
+} OutBuf;
+
+void outbuf_init(OutBuf *buf, size_t initial_cap);
+void outbuf_free(OutBuf *buf);
+bool outbuf_reserve(OutBuf *buf, size_t extra);
+
+void outbuf_append(OutBuf *buf, const char *data, size_t len);
+void outbuf_puts(OutBuf *buf, const char *str);
+void outbuf_putc(OutBuf *buf, char c);
+void outbuf_printf(OutBuf *buf, const char *fmt, ...);
+void outbuf_u64(OutBuf *buf, uint64_t value);
+void outbuf_u64_padded(OutBuf *buf, uint64_t value, int width);
+
+// Write the buffered bytes to a stream, returns false on short write or earlier failure
+bool outbuf_write(const OutBuf *buf, FILE *stream);
+
+#endif // OUTBUF_H
@@ -0,0 +1,25 @@
+#ifndef PREFERENCE_POOL_H
+#define PREFERENCE_POOL_H
+
+#include "maglev_core.h"
+#include <stdint.h>
+
+// Parallel preference list generation for many nodes at once. The lists
+// are cut into (node, range) tasks that worker threads claim from a shared
+// counter, so a handful of nodes on a large table spreads as evenly as
+// many nodes on a small one. The table fill stays single-threaded.
+
+#define PREFERENCE_POOL_MAX_THREADS 64
+#define PREFERENCE_POOL_TASK_ENTRIES (1u << 15)     // Entries per (node, range) task
+#define PREFERENCE_POOL_THREAD_ENTRIES (1u << 17)   // Least work worth another thread
+
+// Online CPUs, capped at PREFERENCE_POOL_MAX_THREADS
+uint32_t preference_pool_default_threads(void);
+
+// Generate the preference lists of nodes (allocated with node_alloc) on up
+// to threads threads (0 = preference_pool_default_threads). Small jobs use
+// fewer threads. Returns the number of threads used.
+uint32_t preference_pool_generate(Node *const *nodes, uint32_t count, uint32_t table_size,
+                                  uint32_t threads);
+
+#endif // PREFERENCE_POOL_H
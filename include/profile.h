@@ -0,0 +1,31 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+
+// Hardware counter profiling of one command, split by phase. Counters come
+// from perf_event_open (user space only, inherited by threads the command
+// starts); without them the phases are still timed with software clocks.
+
+typedef enum {
+    PROFILE_PREFERENCE,     // Permutation (preference list) generation
+    PROFILE_FILL,           // Table fill loop
+    PROFILE_LOOKUP,         // Lookup batches (simulate, load bench)
+    PROFILE_PHASES
+} ProfilePhase;
+
+// Start a session: open the counters and clear the phase totals.
+// Returns false if a session is already running.
+bool profile_begin(void);
+
+// Stop the session and print the per-phase report for the command
+void profile_end(const char *command);
+
+bool profile_is_active(void);
+
+// Phase markers. No-ops outside a session and on threads other than the
+// one that started it, whose counters the session cannot read.
+void profile_phase_begin(ProfilePhase phase);
+void profile_phase_end(ProfilePhase phase);
+
+#endif // PROFILE_H
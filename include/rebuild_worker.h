@@ -0,0 +1,48 @@
+#ifndef REBUILD_WORKER_H
+#define REBUILD_WORKER_H
+
+#include "maglev.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint64_t changes;           // Membership changes handed to the worker
+    uint64_t rebuilds;          // Rebuilds actually run
+    uint64_t latency_count;     // Changes with a recorded change-to-publish latency
+    uint64_t latency_total_ns;  // Sum of change-to-publish latencies
+    uint64_t latency_max_ns;    // Worst change-to-publish latency
+    uint64_t rebuild_total_ns;  // Time spent filling tables
+    uint64_t failed;            // Rebuilds abandoned for lack of memory
+} RebuildStats;
+
+// Worker lifecycle
+bool rebuild_worker_start(void);
+void rebuild_worker_stop(void);
+bool rebuild_worker_is_running(void);
+
+// Timestamp a membership generation for latency accounting (table lock held)
+void rebuild_worker_note_change(uint64_t generation);
+
+// Signal that membership changed; changes that arrive mid-rebuild are
+// coalesced into one follow-up rebuild
+void rebuild_worker_request(void);
+
+// Wait until the published table reflects the latest membership generation.
+// Returns false if the worker could not rebuild it (out of memory).
+bool rebuild_worker_sync(void);
+
+// Wait for idle and free retired nodes (used before tearing down the table)
+void rebuild_worker_drain(void);
+
+// Defer freeing a removed node until no published or in-flight table references it
+void rebuild_worker_retire_node(Node *node);
+
+// Statistics
+void rebuild_worker_get_stats(RebuildStats *stats);
+void rebuild_worker_reset_stats(void);
+
+// Copy up to max recent change-to-publish latencies (the latest 65536 are
+// kept, in no particular order); returns the number copied
+uint64_t rebuild_worker_latency_samples(uint64_t *samples, uint64_t max);
+
+#endif // REBUILD_WORKER_H
@@ -0,0 +1,25 @@
+#ifndef SHM_PUBLISH_H
+#define SHM_PUBLISH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    uint64_t publishes;         // Tables written to shared memory
+    uint64_t total_ns;          // Time spent publishing
+    uint64_t max_ns;            // Slowest publish
+    uint64_t flag_updates;      // Publishes that only rewrote failure flags
+    uint64_t grow_failures;     // Tables not published because the segment could not grow
+} ShmPublishStats;
+
+// Mirror every published table into a POSIX shared-memory segment
+bool shm_publish_start(const char *name);
+void shm_publish_stop(void);
+bool shm_publish_is_active(void);
+void shm_publish_get_stats(ShmPublishStats *stats);
+void shm_publish_show_status(void);
+
+// Fork a reader process that hammers the segment while this process churns membership
+bool shm_publish_bench(double seconds);
+
+#endif // SHM_PUBLISH_H
@@ -0,0 +1,67 @@
+#ifndef SHM_TABLE_H
+#define SHM_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+// Shared-memory layout of a published lookup table. The writer keeps two
+// slots and always fills the one readers are not pointed at; each slot has
+// its own sequence counter (odd while being written), so a reader can do a
+// lookup straight out of the mapping and retry if the counter moved.
+//
+// Failover is resolved by the reader: each slot carries the backup owner
+// of every table entry and a failure flag per node, so marking a node
+// failed only rewrites its flag in the active slot under the seqlock.
+
+#define SHM_TABLE_MAGIC 0x564c474du  // "MGLV"
+#define SHM_TABLE_VERSION 2
+#define SHM_NAME_LEN 256
+
+typedef struct {
+    uint64_t seq;               // Odd while the writer updates this slot
+    uint64_t generation;        // Membership generation of the table
+    uint32_t table_size;
+    uint32_t node_count;
+    uint64_t table_offset;      // Byte offset of the uint32 table from segment start
+    uint64_t backup_offset;     // Byte offset of the uint32 backup owner table
+    uint64_t names_offset;      // Byte offset of node_count names of SHM_NAME_LEN bytes
+    uint64_t down_offset;       // Byte offset of node_count failure flags (1 = failed)
+    uint8_t pad[8];
+} ShmTableSlot;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t segment_size;
+    uint32_t table_capacity;    // Max table size per slot
+    uint32_t node_capacity;     // Max nodes per slot
+    uint32_t active;            // Slot readers should use
+    uint32_t retired;           // Set once the writer replaced this segment
+    uint64_t publish_count;
+    uint8_t pad[24];
+    ShmTableSlot slots[2];
+} ShmTableHeader;
+
+// Bytes needed for a segment with the given capacities
+size_t shm_table_segment_size(uint32_t table_capacity, uint32_t node_capacity);
+
+// Zero-copy reader
+typedef struct {
+    char name[SHM_NAME_LEN];
+    ShmTableHeader *header;
+    size_t size;
+} ShmReader;
+
+bool shm_reader_open(ShmReader *reader, const char *name);
+void shm_reader_close(ShmReader *reader);
+
+// Consistent lookup without syscalls: returns the node index (UINT32_MAX if
+// none), with failed owners redirected like maglev_resolve_slot; optionally
+// copies the node name and reports the table generation.
+// Reattaches automatically if the writer replaced the segment; until the
+// replacement can be opened, lookups use the last table mapped.
+uint32_t shm_reader_lookup(ShmReader *reader, uint64_t key_hash, char *name_out,
+                           uint64_t *generation, uint32_t *retries);
+
+#endif // SHM_TABLE_H
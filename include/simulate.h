@@ -0,0 +1,17 @@
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+#include "keystream.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+    KeyStreamConfig keys;       // Key popularity model
+    uint64_t key_count;         // Total keys to push through the table
+    uint32_t threads;           // Generator/lookup threads
+} SimulateConfig;
+
+// Push a generated key stream through the current Maglev table and report per-node load
+bool simulate_run(const SimulateConfig *config);
+
+#endif // SIMULATE_H
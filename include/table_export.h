@@ -0,0 +1,23 @@
+#ifndef TABLE_EXPORT_H
+#define TABLE_EXPORT_H
+
+#include "outbuf.h"
+#include <stdbool.h>
+
+typedef enum {
+    EXPORT_CSV,
+    EXPORT_JSON
+} ExportFormat;
+
+bool table_export_parse_format(const char *name, ExportFormat *format);
+
+// Render the full table as run-length encoded owner ranges
+void table_render_runs(OutBuf *buf, bool colored);
+void table_render_csv(OutBuf *buf);
+void table_render_json(OutBuf *buf);
+
+// Print the full table to stdout / write it to a file
+void table_show_all(bool colored);
+bool table_export(const char *filename, ExportFormat format);
+
+#endif // TABLE_EXPORT_H
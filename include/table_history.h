@@ -0,0 +1,90 @@
+#ifndef TABLE_HISTORY_H
+#define TABLE_HISTORY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "maglev_core.h"
+
+// Copy-on-write history of the last published tables. Each version splits
+// its owner and backup tables into fixed-size chunks; a chunk identical to
+// the one at the same position in the version it was derived from is
+// shared by reference count, so a version costs only the chunks its change
+// touched. Entries hold stable member ids rather than node indices, so a
+// removal shifting every later index does not unshare the whole table.
+//
+// Recording is off by default: it walks the whole table on every rebuild.
+//
+// The newest TABLE_HISTORY_FLAT_VERSIONS versions also keep a flat copy of
+// both tables in member order, so rolling back one step hands a ready
+// table over by pointer; older versions are materialized from their chunks.
+
+#define TABLE_HISTORY_CHUNK_SLOTS 16
+#define TABLE_HISTORY_DEFAULT_DEPTH 0
+#define TABLE_HISTORY_MAX_DEPTH 64
+#define TABLE_HISTORY_FLAT_VERSIONS 2   // The published table and the one before it
+
+typedef struct {
+    uint32_t refs;
+    uint32_t slots[TABLE_HISTORY_CHUNK_SLOTS];    // Member ids (UINT32_MAX if unassigned)
+} TableChunk;
+
+typedef struct {
+    uint64_t generation;        // Membership generation the table reflects
+    uint64_t published_ns;
+    uint32_t table_size;
+    uint32_t node_count;
+    char **names;               // Members in table order
+    uint32_t *ids;              // Stable id of each member
+    uint8_t *down;              // Failure flag of each member
+    uint32_t chunk_count;
+    TableChunk **owner;
+    TableChunk **backup;
+    uint32_t new_chunks;        // Chunks not shared with the version it was derived from
+    uint32_t *flat_owner;       // Flat owner table in member order (newest versions only, else NULL)
+    uint32_t *flat_backup;      // Flat backup table, kept along with flat_owner
+} TableVersion;
+
+// A rebuilt table as recorded: entries index into nodes
+typedef struct {
+    uint64_t generation;
+    uint32_t table_size;
+    const uint32_t *table;
+    const uint32_t *backup;
+    Node *const *nodes;
+    const uint8_t *down;        // Failure flag of each node
+    uint32_t node_count;
+} TableSnapshot;
+
+// Record a rebuilt table as the newest version. Called from the rebuild
+// path without the table lock: the snapshot must not change meanwhile.
+void table_history_record(const TableSnapshot *snapshot);
+
+// Drop every version
+void table_history_clear(void);
+
+// Number of versions kept; 0 stops recording. Returns false if out of range.
+bool table_history_set_depth(uint32_t depth);
+uint32_t table_history_depth(void);
+uint32_t table_history_count(void);
+
+// Version steps back from the newest (0 is the published table), NULL if not kept
+const TableVersion *table_history_get(uint32_t steps);
+
+// Owner and backup tables of the version steps back, as indices into its
+// member list, in buffers the caller takes over. A version with a flat copy
+// hands it over (*instant set); otherwise the tables are materialized from
+// its chunks. Runs without the table lock. Returns false if out of memory.
+bool table_history_checkout(uint32_t steps, uint32_t **table, uint32_t **backup, bool *instant);
+
+// Derive the next recorded version from this one instead of the newest,
+// so republishing an old version shares all of its chunks
+void table_history_set_base(const TableVersion *version);
+
+// Memory held by kept versions, and what full per-version copies would take
+size_t table_history_memory(void);
+size_t table_history_full_copy_memory(void);
+
+void table_history_show(void);
+
+#endif // TABLE_HISTORY_H
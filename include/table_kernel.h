@@ -0,0 +1,30 @@
+#ifndef TABLE_KERNEL_H
+#define TABLE_KERNEL_H
+
+#include <stdint.h>
+
+// Table-size-specialized kernels. Common table sizes are instantiated from
+// one macro body with the size as a compile-time constant, so key % size
+// compiles to a multiply and shift instead of a division. Other sizes run
+// the same body with the size read at runtime.
+
+typedef struct {
+    uint32_t table_size;        // 0 for the generic kernel
+
+    // Entries [begin, end) of the permutation offset, offset + skip, ...
+    // (mod table_size). offset and skip must be below table_size.
+    void (*permutation)(uint32_t *list, uint32_t table_size, uint32_t offset, uint32_t skip,
+                        uint32_t begin, uint32_t end);
+
+    // Table slot of each key hash, as maglev_slot()
+    void (*slots)(const uint64_t *keys, uint32_t *slots, uint32_t count, uint32_t table_size);
+} TableKernel;
+
+// Kernel for a table size: a specialized one if the size has one, else the generic kernel
+const TableKernel *table_kernel_select(uint32_t table_size);
+const TableKernel *table_kernel_generic(void);
+
+// Specialized kernels, for listing and benchmarking
+const TableKernel *table_kernel_specialized(uint32_t *count);
+
+#endif // TABLE_KERNEL_H
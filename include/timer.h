@@ -0,0 +1,12 @@
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdint.h>
+
+// Monotonic wall-clock time in nanoseconds
+uint64_t timer_now_ns(void);
+
+// Process CPU time (user + system) in seconds
+double timer_cpu_seconds(void);
+
+#endif // TIMER_H
@@ -0,0 +1,304 @@
+#include "bounded_load.h"
+#include "maglev.h"
+#include "load_stats.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define BOUNDED_MAX_PROBES 64   // Give up and use the plain owner after this many slots
+#define BOUNDED_MAX_THREADS 64
+#define BOUNDED_BATCH 1024
+#define BOUNDED_SAMPLE_EVERY 1024
+
+// Epsilon values compared by the sweep, unbounded first
+static const double sweep_epsilons[] = { BOUNDED_UNBOUNDED, 2.0, 1.0, 0.5, 0.25, 0.1, 0.05 };
+
+bool bounded_load_init(BoundedLoad *bl, double epsilon) {
+    memset(bl, 0, sizeof(*bl));
+    bl->epsilon = epsilon;
+    bl->node_count = g_maglev.table_node_count;
+
+    for (uint32_t i = 0; i < bl->node_count; i++) {
+        if (!g_maglev.table_node_down[i]) bl->active_count++;
+    }
+    if (bl->active_count == 0) {
+        bl->active_count = 1;
+    }
+
+    if (posix_memalign((void **)&bl->load, 64, (bl->node_count + 1) * sizeof(BoundedCounter)) != 0) {
+        bl->load = NULL;
+        return false;
+    }
+    memset(bl->load, 0, (bl->node_count + 1) * sizeof(BoundedCounter));
+    return true;
+}
+
+void bounded_load_free(BoundedLoad *bl) {
+    free(bl->load);
+    bl->load = NULL;
+}
+
+static inline void claim(BoundedLoad *bl, uint32_t owner) {
+    __atomic_fetch_add(&bl->load[owner].inflight, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&bl->total.inflight, 1, __ATOMIC_RELAXED);
+}
+
+// Claim a request on owner only if it stays within the bound (CAS, no lock)
+static inline bool try_claim(BoundedLoad *bl, uint32_t owner, double scale) {
+    uint32_t total = __atomic_load_n(&bl->total.inflight, __ATOMIC_RELAXED);
+    double bound = scale * (total + 1);
+    uint32_t capacity = (uint32_t)bound;
+    capacity += capacity < bound;       // ceil() without a libm call
+    uint32_t current = __atomic_load_n(&bl->load[owner].inflight, __ATOMIC_RELAXED);
+
+    while (current < capacity) {
+        if (__atomic_compare_exchange_n(&bl->load[owner].inflight, &current, current + 1,
+                                        true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            __atomic_fetch_add(&bl->total.inflight, 1, __ATOMIC_RELAXED);
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline uint32_t slot_owner(uint32_t slot, uint32_t node_count) {
+    uint32_t owner = g_maglev.lookup_table[slot];
+    if (owner < node_count && g_maglev.table_node_down[owner]) {
+        owner = maglev_resolve_slot(slot);
+    }
+    return owner;
+}
+
+// Pick a backend for a key and count the request in flight
+uint32_t bounded_load_acquire(BoundedLoad *bl, uint64_t key_hash, uint32_t *probes) {
+    uint32_t table_size = g_maglev.table_size;
+    uint32_t slot = maglev_slot(key_hash, table_size);
+    uint32_t first = slot_owner(slot, bl->node_count);
+
+    *probes = 1;
+    if (first >= bl->node_count) {
+        return UINT32_MAX;
+    }
+    if (bl->epsilon < 0) {
+        claim(bl, first);
+        return first;
+    }
+
+    // The key's probe sequence: a key-derived step coprime with the size, so
+    // it cycles through every slot (any step for a prime size, odd steps for
+    // a power of two; an even step would revisit size/gcd(step, size) slots)
+    uint32_t step = 1 + (uint32_t)(((key_hash >> 32) * (uint64_t)(table_size - 1)) >> 32);
+    if (g_maglev.pow2) {
+        step |= 1;
+    }
+    double scale = (1.0 + bl->epsilon) / bl->active_count;
+    uint32_t owner = first;
+
+    for (uint32_t probe = 1; ; probe++) {
+        if (owner < bl->node_count && try_claim(bl, owner, scale)) {
+            *probes = probe;
+            return owner;
+        }
+        if (probe == BOUNDED_MAX_PROBES) break;
+
+        slot += step;
+        if (slot >= table_size) slot -= table_size;
+        owner = slot_owner(slot, bl->node_count);
+    }
+
+    // Every probed backend is full (possible while other threads race): plain owner
+    *probes = BOUNDED_MAX_PROBES;
+    claim(bl, first);
+    return first;
+}
+
+void bounded_load_release(BoundedLoad *bl, uint32_t owner) {
+    if (owner < bl->node_count) {
+        __atomic_fetch_sub(&bl->load[owner].inflight, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_sub(&bl->total.inflight, 1, __ATOMIC_RELAXED);
+    }
+}
+
+typedef struct {
+    BoundedLoad *bl;
+    KeyStream ks;
+    uint64_t rng_start;         // Replayed for every epsilon
+    uint64_t lookups;
+    uint32_t inflight;
+    uint32_t *ring;             // Owners of this thread's in-flight requests
+    LoadShard *load;            // Backend traffic counter shard, NULL when counting is off
+    bool sample;                // Thread 0 samples the load spread
+    uint64_t probes;
+    uint64_t redirected;
+    double peak_ratio;
+    double ratio_sum;
+    uint64_t samples;
+} BoundedWorker;
+
+// Max in-flight load over the average, across active backends
+static double load_ratio(const BoundedLoad *bl) {
+    uint32_t max = 0;
+    for (uint32_t i = 0; i < bl->node_count; i++) {
+        uint32_t load = __atomic_load_n(&bl->load[i].inflight, __ATOMIC_RELAXED);
+        if (load > max) max = load;
+    }
+    uint32_t total = __atomic_load_n(&bl->total.inflight, __ATOMIC_RELAXED);
+    return total ? (double)max * bl->active_count / total : 0.0;
+}
+
+// Closed loop: each thread keeps a fixed number of requests in flight and
+// releases the oldest one before starting the next
+static void *bounded_worker(void *arg) {
+    BoundedWorker *w = arg;
+    uint64_t keys[BOUNDED_BATCH];
+    uint32_t head = 0, held = 0;
+
+    w->ks.rng_state = w->rng_start;
+    w->probes = 0;
+    w->redirected = 0;
+    w->peak_ratio = 0.0;
+    w->ratio_sum = 0.0;
+    w->samples = 0;
+
+    for (uint64_t done = 0; done < w->lookups; ) {
+        uint32_t batch = w->lookups - done < BOUNDED_BATCH ? (uint32_t)(w->lookups - done) : BOUNDED_BATCH;
+        keystream_fill(&w->ks, keys, batch);
+
+        for (uint32_t i = 0; i < batch; i++) {
+            if (held == w->inflight) {
+                bounded_load_release(w->bl, w->ring[head]);
+                held--;
+            }
+
+            uint32_t probes;
+            w->ring[head] = bounded_load_acquire(w->bl, keys[i], &probes);
+            if (w->load) {
+                uint32_t owner = w->ring[head];
+                load_stats_count_one(w->load, owner < w->bl->node_count ? owner : w->bl->node_count, keys[i]);
+            }
+            head = head + 1 == w->inflight ? 0 : head + 1;
+            held++;
+
+            w->probes += probes;
+            w->redirected += probes > 1;
+        }
+        done += batch;
+
+        if (w->sample && held == w->inflight && done % BOUNDED_SAMPLE_EVERY == 0) {
+            double ratio = load_ratio(w->bl);
+            if (ratio > w->peak_ratio) w->peak_ratio = ratio;
+            w->ratio_sum += ratio;
+            w->samples++;
+        }
+    }
+
+    // Drain: release whatever is still in flight
+    for (uint32_t i = 0; i < held; i++) {
+        uint32_t idx = (head + w->inflight - held + i) % w->inflight;
+        bounded_load_release(w->bl, w->ring[idx]);
+    }
+    return NULL;
+}
+
+// Max backend load and lookup cost for a range of epsilon values
+bool bounded_load_sweep(const BoundedSweepConfig *config) {
+    if (!g_maglev.is_initialized || g_maglev.table_node_count == 0) {
+        printf("Error: Maglev table not initialized or has no nodes\n");
+        return false;
+    }
+
+    uint32_t threads = config->threads;
+    if (threads == 0) threads = 1;
+    if (threads > BOUNDED_MAX_THREADS) threads = BOUNDED_MAX_THREADS;
+
+    BoundedWorker *workers = calloc(threads, sizeof(BoundedWorker));
+    pthread_t tids[BOUNDED_MAX_THREADS];
+    KeyStream base;
+    bool have_base = workers && keystream_init(&base, &config->keys);
+    bool ok = have_base;
+
+    for (uint32_t t = 0; ok && t < threads; t++) {
+        BoundedWorker *w = &workers[t];
+        w->lookups = config->key_count / threads + (t < config->key_count % threads ? 1 : 0);
+        w->inflight = config->inflight;
+        w->sample = (t == 0);
+        w->load = load_stats_shard(t);
+        w->ring = malloc(config->inflight * sizeof(uint32_t));
+        ok = w->ring != NULL;
+        if (ok) {
+            // Same flow population and alias table, independent request order per thread
+            keystream_fork(&w->ks, &base, t);
+            w->rng_start = w->ks.rng_state;
+        }
+    }
+
+    if (ok) {
+        uint32_t active = 0;
+        for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+            if (!g_maglev.table_node_down[i]) active++;
+        }
+        uint64_t total_inflight = (uint64_t)config->inflight * threads;
+
+        printf("Bounded-load lookup: %llu %s keys, %llu requests in flight over %u backends "
+               "(%.1f each), %u thread%s\n",
+               (unsigned long long)config->key_count, keystream_distribution_name(config->keys.dist),
+               (unsigned long long)total_inflight, active, active ? (double)total_inflight / active : 0.0,
+               threads, threads == 1 ? "" : "s");
+        printf("  %8s %14s %14s %11s %14s %11s\n", "Epsilon", "Max/avg peak", "Max/avg mean",
+               "Redirected", "Probes/lookup", "ns/lookup");
+
+        for (size_t e = 0; e < sizeof(sweep_epsilons) / sizeof(sweep_epsilons[0]); e++) {
+            BoundedLoad bl;
+            if (!bounded_load_init(&bl, sweep_epsilons[e])) {
+                ok = false;
+                break;
+            }
+
+            uint64_t start = timer_now_ns();
+            for (uint32_t t = 0; t < threads; t++) {
+                workers[t].bl = &bl;
+                if (pthread_create(&tids[t], NULL, bounded_worker, &workers[t]) != 0) {
+                    bounded_worker(&workers[t]);
+                    tids[t] = 0;
+                }
+            }
+            for (uint32_t t = 0; t < threads; t++) {
+                if (tids[t]) pthread_join(tids[t], NULL);
+            }
+            uint64_t elapsed = timer_now_ns() - start;
+
+            uint64_t probes = 0, redirected = 0;
+            for (uint32_t t = 0; t < threads; t++) {
+                probes += workers[t].probes;
+                redirected += workers[t].redirected;
+            }
+
+            char label[16];
+            if (sweep_epsilons[e] < 0) {
+                snprintf(label, sizeof(label), "off");
+            } else {
+                snprintf(label, sizeof(label), "%.2f", sweep_epsilons[e]);
+            }
+            printf("  %8s %14.3f %14.3f %10.2f%% %14.3f %11.1f\n", label,
+                   workers[0].peak_ratio,
+                   workers[0].samples ? workers[0].ratio_sum / workers[0].samples : 0.0,
+                   config->key_count ? 100.0 * redirected / config->key_count : 0.0,
+                   config->key_count ? (double)probes / config->key_count : 0.0,
+                   config->key_count ? (double)elapsed * threads / config->key_count : 0.0);
+
+            bounded_load_free(&bl);
+        }
+    }
+
+    if (!ok) {
+        printf("Error: Memory allocation failed\n");
+    }
+    for (uint32_t t = 0; workers && t < threads; t++) {
+        free(workers[t].ring);
+    }
+    if (have_base) keystream_free(&base);
+    free(workers);
+    return ok;
+}
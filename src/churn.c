@@ -0,0 +1,371 @@
+#include "churn.h"
+#include "maglev.h"
+#include "cli.h"
+#include "rebuild_worker.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define CHURN_LINE_LEN 1024
+#define CHURN_CHECKPOINT 100    // Events between 'show maglev' checkpoints in generated streams
+
+bool churn_parse_scenario(const char *name, ChurnScenario *scenario) {
+    if (strcmp(name, "rolling") == 0) {
+        *scenario = CHURN_ROLLING;
+    } else if (strcmp(name, "zone") == 0) {
+        *scenario = CHURN_ZONE;
+    } else if (strcmp(name, "steady") == 0) {
+        *scenario = CHURN_STEADY;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+static const char *scenario_name(ChurnScenario scenario) {
+    switch (scenario) {
+        case CHURN_ROLLING: return "rolling";
+        case CHURN_ZONE:    return "zone";
+        case CHURN_STEADY:  return "steady";
+    }
+    return "?";
+}
+
+void churn_default_config(ChurnGenConfig *config, ChurnScenario scenario) {
+    config->scenario = scenario;
+    config->backends = 2000;
+    config->zones = 4;
+    config->events = scenario == CHURN_ZONE ? 8 : 500;
+    config->table_size = 65537;
+    config->seed = 0x9e3779b97f4a7c15ull;
+}
+
+static inline uint64_t churn_rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dull;
+}
+
+static void backend_name(char *buf, size_t len, uint32_t id, uint32_t zones) {
+    snprintf(buf, len, "be-z%u-%05u", id % zones, id);
+}
+
+// Write a command script for the scenario
+bool churn_generate(const char *filename, const ChurnGenConfig *config) {
+    if (config->backends == 0 || config->backends > MAX_NODES ||
+        config->zones == 0 || config->zones > config->backends) {
+        printf("Error: Need 1-%d backends and 1-backends zones\n", MAX_NODES);
+        return false;
+    }
+
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Cannot create file '%s'\n", filename);
+        return false;
+    }
+
+    uint32_t *live = malloc(MAX_NODES * sizeof(uint32_t));
+    if (!live) {
+        fclose(file);
+        printf("Error: Memory allocation failed\n");
+        return false;
+    }
+
+    char name[64];
+    uint64_t rng = config->seed ? config->seed : 1;
+    uint64_t commands = 0;
+
+    fprintf(file, "# Churn scenario '%s': %u backends in %u zones, %u events, table %u\n",
+            scenario_name(config->scenario), config->backends, config->zones,
+            config->events, config->table_size);
+    fprintf(file, "# Replay with: churn run %s [rate]\n", filename);
+    fprintf(file, "init %u\n", config->table_size);
+
+    // Bulk setup on the background worker so it coalesces into a few rebuilds
+    fprintf(file, "async on\n");
+    for (uint32_t i = 0; i < config->backends; i++) {
+        backend_name(name, sizeof(name), i, config->zones);
+        fprintf(file, "add %s\n", name);
+        live[i] = i;
+    }
+    fprintf(file, "sync\nasync off\n");
+    fprintf(file, "#! measure\n");
+
+    uint32_t live_count = config->backends;
+    uint32_t next_id = config->backends;
+
+    for (uint32_t e = 0; e < config->events; e++) {
+        switch (config->scenario) {
+            case CHURN_ROLLING: {
+                backend_name(name, sizeof(name), e % config->backends, config->zones);
+                fprintf(file, "del %s\nadd %s\n", name, name);
+                commands += 2;
+                break;
+            }
+
+            case CHURN_ZONE: {
+                // Outage: every backend in the zone fails, then comes back
+                uint32_t zone = e % config->zones;
+                fprintf(file, "# zone %u outage\n", zone);
+                for (uint32_t i = zone; i < config->backends; i += config->zones) {
+                    backend_name(name, sizeof(name), i, config->zones);
+                    fprintf(file, "fail %s\n", name);
+                    commands++;
+                }
+                fprintf(file, "show maglev\n");
+                for (uint32_t i = zone; i < config->backends; i += config->zones) {
+                    backend_name(name, sizeof(name), i, config->zones);
+                    fprintf(file, "recover %s\n", name);
+                    commands++;
+                }
+                break;
+            }
+
+            case CHURN_STEADY: {
+                // Random walk around the initial size, bounded to +-10%
+                bool grow = churn_rng_next(&rng) & 1;
+                if (live_count <= config->backends - config->backends / 10 || live_count <= 1) grow = true;
+                if (live_count >= config->backends + config->backends / 10 || live_count >= MAX_NODES) grow = false;
+
+                if (grow) {
+                    backend_name(name, sizeof(name), next_id, config->zones);
+                    live[live_count++] = next_id++;
+                    fprintf(file, "add %s\n", name);
+                } else {
+                    uint32_t victim = (uint32_t)(churn_rng_next(&rng) % live_count);
+                    backend_name(name, sizeof(name), live[victim], config->zones);
+                    live[victim] = live[--live_count];
+                    fprintf(file, "del %s\n", name);
+                }
+                commands++;
+                break;
+            }
+        }
+
+        if (config->scenario != CHURN_ZONE && (e + 1) % CHURN_CHECKPOINT == 0) {
+            fprintf(file, "show maglev\n");
+        }
+    }
+    fprintf(file, "show nodes\n");
+
+    bool ok = (fclose(file) == 0);
+    free(live);
+    if (!ok) {
+        printf("Error: Failed to write '%s'\n", filename);
+        return false;
+    }
+
+    printf("Wrote '%s': %s churn, %u backends in %u zones, %llu measured membership commands\n",
+           filename, scenario_name(config->scenario), config->backends, config->zones,
+           (unsigned long long)commands);
+    return true;
+}
+
+typedef struct {
+    uint64_t *latency_ns;       // Membership command latencies
+    uint64_t count;
+    uint64_t cap;
+    uint64_t commands;
+    uint64_t skipped;
+    uint64_t start_ns;
+    struct rusage start_usage;
+} ChurnStats;
+
+static void stats_reset(ChurnStats *stats) {
+    stats->count = 0;
+    stats->commands = 0;
+    stats->skipped = 0;
+    stats->start_ns = timer_now_ns();
+    getrusage(RUSAGE_SELF, &stats->start_usage);
+    rebuild_worker_reset_stats();
+}
+
+static bool stats_record(ChurnStats *stats, uint64_t ns) {
+    if (stats->count == stats->cap) {
+        uint64_t cap = stats->cap ? stats->cap * 2 : 1024;
+        uint64_t *latency = realloc(stats->latency_ns, cap * sizeof(uint64_t));
+        if (!latency) return false;
+        stats->latency_ns = latency;
+        stats->cap = cap;
+    }
+    stats->latency_ns[stats->count++] = ns;
+    return true;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static double percentile_ms(const uint64_t *sorted, uint64_t count, double p) {
+    if (count == 0) return 0.0;
+    uint64_t index = (uint64_t)(p * (count - 1) + 0.5);
+    return sorted[index] / 1e6;
+}
+
+static double timeval_seconds(const struct timeval *tv) {
+    return tv->tv_sec + tv->tv_usec / 1e6;
+}
+
+static bool is_membership_command(const char *line) {
+    static const char *const membership[] = { "init", "resize", "add", "del", "fail", "recover", NULL };
+    for (int i = 0; membership[i]; i++) {
+        size_t len = strlen(membership[i]);
+        if (strncmp(line, membership[i], len) == 0 && (line[len] == ' ' || line[len] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Sort latencies in place and print their distribution
+static void print_latency(const char *label, uint64_t *samples, uint64_t count) {
+    qsort(samples, count, sizeof(uint64_t), compare_u64);
+    uint64_t total = 0;
+    for (uint64_t i = 0; i < count; i++) total += samples[i];
+
+    printf("  %s: mean %.3f ms, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n",
+           label, total / 1e6 / count,
+           percentile_ms(samples, count, 0.50),
+           percentile_ms(samples, count, 0.90),
+           percentile_ms(samples, count, 0.99),
+           percentile_ms(samples, count, 0.999),
+           samples[count - 1] / 1e6);
+}
+
+static void report(const char *filename, ChurnStats *stats) {
+    uint64_t wall_ns = timer_now_ns() - stats->start_ns;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    double user = timeval_seconds(&usage.ru_utime) - timeval_seconds(&stats->start_usage.ru_utime);
+    double system = timeval_seconds(&usage.ru_stime) - timeval_seconds(&stats->start_usage.ru_stime);
+
+    RebuildStats worker;
+    rebuild_worker_get_stats(&worker);
+
+    printf("Churn run '%s':\n", filename);
+    printf("  Commands: %llu executed, %llu membership changes, %llu show commands skipped, %.2f s wall\n",
+           (unsigned long long)stats->commands, (unsigned long long)stats->count,
+           (unsigned long long)stats->skipped, wall_ns / 1e9);
+
+    // With the background worker a command returns before its table is
+    // published, so rebuild latency comes from the worker's samples
+    uint64_t *published = NULL;
+    uint64_t published_count = 0;
+    if (worker.latency_count > 0) {
+        published = malloc(worker.latency_count * sizeof(uint64_t));
+        if (published) {
+            published_count = rebuild_worker_latency_samples(published, worker.latency_count);
+        }
+    }
+
+    if (published_count > 0) {
+        print_latency("Rebuild latency (change-to-publish)", published, published_count);
+        if (stats->count > 0) {
+            print_latency("Command latency (returns before publish)", stats->latency_ns, stats->count);
+        }
+    } else if (stats->count > 0) {
+        print_latency("Rebuild latency (per command)", stats->latency_ns, stats->count);
+    }
+    free(published);
+
+    if (worker.changes > 0) {
+        printf("  Background worker: %llu changes in %llu rebuilds, change-to-publish avg %.3f ms, max %.3f ms\n",
+               (unsigned long long)worker.changes, (unsigned long long)worker.rebuilds,
+               worker.latency_count ? worker.latency_total_ns / 1e6 / worker.latency_count : 0.0,
+               worker.latency_max_ns / 1e6);
+    }
+
+    printf("  CPU time: %.2f s (%.2f s user, %.2f s system)\n", user + system, user, system);
+    printf("  Peak RSS: %.1f MB\n", usage.ru_maxrss / 1024.0);
+}
+
+// Replay a command script quietly and report rebuild latency, CPU time and peak RSS
+bool churn_run(const char *filename, double rate, ChurnExecuteFn execute) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return false;
+    }
+
+    ChurnStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats_reset(&stats);
+
+    bool was_verbose = cli_set_verbose(false);
+    uint64_t interval_ns = rate > 0 ? (uint64_t)(1e9 / rate) : 0;
+    uint64_t next_ns = timer_now_ns();
+    char line[CHURN_LINE_LEN];
+    bool ok = true;
+    bool synced = true;
+
+    while (ok && synced && fgets(line, sizeof(line), file)) {
+        char *cmd = line;
+        while (isspace((unsigned char)*cmd)) cmd++;
+        size_t len = strlen(cmd);
+        while (len > 0 && isspace((unsigned char)cmd[len - 1])) cmd[--len] = '\0';
+
+        if (len == 0) continue;
+        if (strncmp(cmd, "#! measure", 10) == 0) {
+            // Wait out background work from the setup so it is not counted
+            synced = rebuild_worker_sync();
+            stats_reset(&stats);
+            next_ns = timer_now_ns();
+            continue;
+        }
+        if (cmd[0] == '#') continue;
+        if (strcmp(cmd, "quit") == 0 || strcmp(cmd, "exit") == 0) break;
+        if (strncmp(cmd, "show", 4) == 0 && (cmd[4] == ' ' || cmd[4] == '\0')) {
+            stats.skipped++;
+            continue;
+        }
+
+        if (interval_ns) {
+            uint64_t now = timer_now_ns();
+            if (now < next_ns) {
+                struct timespec ts = { (time_t)((next_ns - now) / 1000000000ull),
+                                       (long)((next_ns - now) % 1000000000ull) };
+                nanosleep(&ts, NULL);
+            }
+            next_ns += interval_ns;
+        }
+
+        bool membership = is_membership_command(cmd);
+        uint64_t start = timer_now_ns();
+        execute(cmd);
+        uint64_t elapsed = timer_now_ns() - start;
+
+        stats.commands++;
+        if (membership) {
+            ok = stats_record(&stats, elapsed);
+        }
+    }
+    fclose(file);
+
+    // Background rebuilds still in flight belong to this run
+    if (synced) {
+        synced = rebuild_worker_sync();
+    }
+    cli_set_verbose(was_verbose);
+
+    if (!synced) {
+        maglev_lock();
+        printf("Error: Background rebuild failed (out of memory), table is at generation %llu of %llu\n",
+               (unsigned long long)g_maglev.table_generation, (unsigned long long)g_maglev.generation);
+        maglev_unlock();
+    } else if (!ok) {
+        printf("Error: Memory allocation failed while recording latencies\n");
+    } else {
+        report(filename, &stats);
+    }
+    free(stats.latency_ns);
+    return ok && synced;
+}
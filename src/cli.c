@@ -0,0 +1,94 @@
+#include "cli.h"
+#include "maglev.h"
+#include <stdlib.h>
+#include <time.h>
+
+// Whether the CLI reports successful control-plane changes
+static bool g_verbose = true;
+
+bool cli_set_verbose(bool verbose) {
+    bool previous = g_verbose;
+    g_verbose = verbose;
+    return previous;
+}
+
+bool cli_is_verbose(void) {
+    return g_verbose;
+}
+
+// Predefined color array - includes more 256-color mode colors
+static const int color_palette[] = {
+    // Standard 16 colors (avoid black and dark colors)
+    31, 32, 33, 34, 35, 36, 37,         // red, green, yellow, blue, magenta, cyan, white
+    91, 92, 93, 94, 95, 96, 97,         // bright red, bright green, bright yellow, bright blue, bright magenta, bright cyan, bright white
+
+    // Selected 256-color mode colors (using 38;5;n format)
+    // Red series
+    196, 197, 198, 199, 200, 201, 202, 203, 204, 205,
+    // Green series
+    46, 47, 48, 49, 50, 82, 83, 84, 85, 86,
+    // Yellow series
+    220, 221, 222, 223, 224, 225, 226, 227, 228, 229,
+    // Blue series
+    21, 26, 27, 32, 33, 38, 39, 44, 45, 75,
+    // Magenta/Pink series
+    207, 213, 219, 225, 165, 171, 177, 183, 189, 195,
+    // Cyan series
+    51, 87, 123, 159, 14, 80, 116, 152, 188, 194,
+    // Purple series
+    129, 135, 141, 147, 153, 93, 99, 105, 111, 117,
+    // Orange series
+    166, 172, 178, 184, 190, 208, 214, 215, 216, 217,
+    // Gray series
+    244, 245, 246, 247, 248, 249, 250, 251, 252, 253,
+    // Special colors
+    11, 12, 13, 14, 15, 76, 77, 78, 79, 118, 119, 120, 121, 122
+};
+
+#define COLOR_COUNT ((int)(sizeof(color_palette) / sizeof(color_palette[0])))
+
+// Assign unique color index
+static int assign_unique_color_index(void) {
+    static bool seeded = false;
+    if (!seeded) {
+        srand((unsigned int)time(NULL));
+        seeded = true;
+    }
+
+    // Mark colors used by existing nodes
+    bool used_colors[COLOR_COUNT];
+    for (int i = 0; i < COLOR_COUNT; i++) {
+        used_colors[i] = false;
+    }
+    for (uint32_t i = 0; i < g_maglev.node_count; i++) {
+        if (g_maglev.nodes[i] && g_maglev.nodes[i]->color_index >= 0 && g_maglev.nodes[i]->color_index < COLOR_COUNT) {
+            used_colors[g_maglev.nodes[i]->color_index] = true;
+        }
+    }
+
+    // First try to assign unused colors
+    int available_colors[COLOR_COUNT];
+    int available_count = 0;
+    for (int i = 0; i < COLOR_COUNT; i++) {
+        if (!used_colors[i]) {
+            available_colors[available_count++] = i;
+        }
+    }
+
+    if (available_count > 0) {
+        return available_colors[rand() % available_count];
+    }
+
+    // If all colors are used, randomly select one (when node count exceeds color count)
+    return rand() % COLOR_COUNT;
+}
+
+int cli_node_color(Node *node) {
+    if (!node) {
+        return -1;
+    }
+    if (node->color_index < 0 || node->color_index >= COLOR_COUNT) {
+        node->color_index = assign_unique_color_index();
+    }
+    return color_palette[node->color_index];
+}
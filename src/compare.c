@@ -0,0 +1,541 @@
+#include "compare.h"
+#include "engine.h"
+#include "maglev.h"
+#include "node.h"
+#include "hash.h"
+#include "timer.h"
+#include "preference_pool.h"
+#include "table_kernel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+const EngineOps *const all_engines[] = {
+    &maglev_engine,
+    &ring_engine,
+    &rendezvous_engine,
+    &jump_engine,
+    NULL
+};
+
+typedef struct {
+    double build_ms;
+    double rebuild_ms;          // Commit after a single add
+    double lookup_ns;
+    size_t memory;
+    double cv;
+    double max_over_mean;
+    double add_moved;           // Share of keys that changed owner on add
+    double remove_moved;        // Share of keys that changed owner on remove
+} CompareResult;
+
+// Look up every sample key; returns elapsed ns
+static uint64_t lookup_all(const EngineOps *ops, const void *state, const uint64_t *keys,
+                           uint32_t key_count, uint32_t *owners) {
+    uint64_t start = timer_now_ns();
+    for (uint32_t i = 0; i < key_count; i++) {
+        owners[i] = ops->lookup(state, keys[i]);
+    }
+    return timer_now_ns() - start;
+}
+
+static double moved_share(const uint32_t *before, const uint32_t *after, uint32_t key_count) {
+    uint32_t moved = 0;
+    for (uint32_t i = 0; i < key_count; i++) {
+        moved += before[i] != after[i];
+    }
+    return key_count ? (double)moved / key_count : 0.0;
+}
+
+static bool run_engine(const EngineOps *ops, char names[][MAX_NODE_NAME_LEN], uint32_t node_count,
+                       const CompareConfig *config, const uint64_t *keys,
+                       uint32_t *baseline, uint32_t *scratch, CompareResult *result) {
+    void *state = ops->create(config->table_size);
+    if (!state) return false;
+
+    // Build from scratch
+    uint64_t start = timer_now_ns();
+    for (uint32_t i = 0; i < node_count; i++) {
+        if (!ops->add(state, i, names[i])) {
+            ops->destroy(state);
+            return false;
+        }
+    }
+    ops->commit(state);
+    result->build_ms = (timer_now_ns() - start) / 1e6;
+    result->memory = ops->memory(state);
+
+    // Lookup cost and balance on the baseline membership
+    uint64_t elapsed = lookup_all(ops, state, keys, config->key_count, baseline);
+    result->lookup_ns = config->key_count ? (double)elapsed / config->key_count : 0.0;
+
+    uint64_t *hits = calloc(node_count, sizeof(uint64_t));
+    if (!hits) {
+        ops->destroy(state);
+        return false;
+    }
+    for (uint32_t i = 0; i < config->key_count; i++) {
+        if (baseline[i] < node_count) hits[baseline[i]]++;
+    }
+
+    double mean = (double)config->key_count / node_count;
+    double variance = 0.0;
+    uint64_t max_hits = 0;
+    for (uint32_t i = 0; i < node_count; i++) {
+        double diff = hits[i] - mean;
+        variance += diff * diff;
+        if (hits[i] > max_hits) max_hits = hits[i];
+    }
+    result->cv = sqrt(variance / node_count) / mean;
+    result->max_over_mean = max_hits / mean;
+    free(hits);
+
+    // Disruption on add
+    start = timer_now_ns();
+    ops->add(state, node_count, "compare-extra-node");
+    ops->commit(state);
+    result->rebuild_ms = (timer_now_ns() - start) / 1e6;
+    lookup_all(ops, state, keys, config->key_count, scratch);
+    result->add_moved = moved_share(baseline, scratch, config->key_count);
+
+    // Back to the baseline, then disruption on removing a node in the middle
+    ops->remove(state, node_count);
+    ops->remove(state, node_count / 2);
+    ops->commit(state);
+    lookup_all(ops, state, keys, config->key_count, scratch);
+    result->remove_moved = moved_share(baseline, scratch, config->key_count);
+
+    ops->destroy(state);
+    return true;
+}
+
+// Current simulator node names, or synthetic ones
+static void fill_names(char names[][MAX_NODE_NAME_LEN], uint32_t node_count, bool use_current) {
+    for (uint32_t i = 0; i < node_count; i++) {
+        if (use_current) {
+            strcpy(names[i], g_maglev.nodes[i]->name);
+        } else {
+            snprintf(names[i], MAX_NODE_NAME_LEN, "backend%04u", i);
+        }
+    }
+}
+
+// Node count to compare with: the current nodes if node_count is 0
+static bool resolve_node_count(uint32_t *node_count, bool *use_current) {
+    *use_current = (*node_count == 0);
+    if (*use_current) {
+        if (!g_maglev.is_initialized || g_maglev.node_count < 2) {
+            printf("Error: Need at least 2 nodes (add nodes or pass a node count)\n");
+            return false;
+        }
+        *node_count = g_maglev.node_count;
+    }
+
+    if (*node_count < 2 || *node_count >= MAX_NODES) {
+        printf("Error: Node count must be between 2 and %d\n", MAX_NODES - 1);
+        return false;
+    }
+    return true;
+}
+
+// Benchmark every consistent-hash engine on the same node set
+bool compare_engines(const CompareConfig *config) {
+    uint32_t node_count = config->node_count;
+    bool use_current;
+    if (!resolve_node_count(&node_count, &use_current)) {
+        return false;
+    }
+
+    char (*names)[MAX_NODE_NAME_LEN] = malloc(node_count * sizeof(*names));
+    uint64_t *keys = malloc(config->key_count * sizeof(uint64_t));
+    uint32_t *baseline = malloc(config->key_count * sizeof(uint32_t));
+    uint32_t *scratch = malloc(config->key_count * sizeof(uint32_t));
+    if (!names || !keys || !baseline || !scratch) {
+        printf("Error: Memory allocation failed\n");
+        free(names);
+        free(keys);
+        free(baseline);
+        free(scratch);
+        return false;
+    }
+
+    fill_names(names, node_count, use_current);
+    for (uint32_t i = 0; i < config->key_count; i++) {
+        keys[i] = hash_key64(i);
+    }
+
+    printf("Comparing engines: %u nodes, maglev table %u, %u sample keys\n",
+           node_count, next_prime(config->table_size), config->key_count);
+    printf("  ideal moved share: add %.2f%%, remove %.2f%%\n\n",
+           100.0 / (node_count + 1), 100.0 / node_count);
+    printf("%-11s %9s %11s %9s %11s %7s %9s %9s %9s\n",
+           "engine", "lookup_ns", "memory_KiB", "build_ms", "rebuild_ms",
+           "cv", "max/mean", "add_mv%", "del_mv%");
+
+    bool ok = true;
+    for (const EngineOps *const *ops = all_engines; *ops; ops++) {
+        CompareResult r;
+        if (!run_engine(*ops, names, node_count, config, keys, baseline, scratch, &r)) {
+            printf("%-11s (failed)\n", (*ops)->name);
+            ok = false;
+            continue;
+        }
+
+        printf("%-11s %9.1f %11.1f %9.3f %11.3f %7.4f %9.3f %9.2f %9.2f\n",
+               (*ops)->name, r.lookup_ns, r.memory / 1024.0, r.build_ms, r.rebuild_ms,
+               r.cv, r.max_over_mean, 100.0 * r.add_moved, 100.0 * r.remove_moved);
+    }
+
+    free(names);
+    free(keys);
+    free(baseline);
+    free(scratch);
+    return ok;
+}
+
+typedef struct {
+    uint32_t table_size;
+    double build_ms;            // Preference lists and fill
+    double slot_max;            // Most slots of one node over the mean
+    double slot_min;            // Fewest slots of one node over the mean
+    double cv;                  // Key balance
+    double max_over_mean;
+    double lookup_ns;
+} SizingResult;
+
+#define SIZING_LOOKUP_RUNS 5
+
+static bool run_sizing(uint32_t table_size, char names[][MAX_NODE_NAME_LEN], uint32_t node_count,
+                       const uint64_t *keys, uint32_t key_count, uint32_t *owners, SizingResult *r) {
+    Node **nodes = calloc(node_count, sizeof(Node *));
+    uint32_t *table = malloc(table_size * sizeof(uint32_t));
+    uint64_t *counts = calloc(node_count, sizeof(uint64_t));
+    bool ok = nodes && table && counts;
+
+    uint64_t start = timer_now_ns();
+    for (uint32_t i = 0; ok && i < node_count; i++) {
+        nodes[i] = node_create(names[i], table_size);
+        ok = nodes[i] != NULL;
+    }
+    if (ok) {
+        maglev_fill_table(table, NULL, NULL, table_size, nodes, node_count);
+    }
+    r->table_size = table_size;
+    r->build_ms = (timer_now_ns() - start) / 1e6;
+
+    if (ok) {
+        // Slot balance
+        for (uint32_t s = 0; s < table_size; s++) {
+            counts[table[s]]++;
+        }
+        double mean = (double)table_size / node_count;
+        uint64_t max_slots = 0, min_slots = UINT64_MAX;
+        for (uint32_t i = 0; i < node_count; i++) {
+            if (counts[i] > max_slots) max_slots = counts[i];
+            if (counts[i] < min_slots) min_slots = counts[i];
+        }
+        r->slot_max = max_slots / mean;
+        r->slot_min = min_slots / mean;
+
+        // Lookup cost through the same slot mapping the simulator uses, best run
+        uint64_t best = UINT64_MAX;
+        for (int run = 0; run < SIZING_LOOKUP_RUNS; run++) {
+            uint64_t t0 = timer_now_ns();
+            for (uint32_t k = 0; k < key_count; k++) {
+                owners[k] = table[maglev_slot(keys[k], table_size)];
+            }
+            uint64_t elapsed = timer_now_ns() - t0;
+            if (elapsed < best) best = elapsed;
+        }
+        r->lookup_ns = (double)best / key_count;
+
+        // Key balance
+        memset(counts, 0, node_count * sizeof(uint64_t));
+        for (uint32_t k = 0; k < key_count; k++) {
+            counts[owners[k]]++;
+        }
+        mean = (double)key_count / node_count;
+        double variance = 0.0;
+        uint64_t max_hits = 0;
+        for (uint32_t i = 0; i < node_count; i++) {
+            double diff = counts[i] - mean;
+            variance += diff * diff;
+            if (counts[i] > max_hits) max_hits = counts[i];
+        }
+        r->cv = sqrt(variance / node_count) / mean;
+        r->max_over_mean = max_hits / mean;
+    }
+
+    for (uint32_t i = 0; nodes && i < node_count; i++) {
+        node_destroy(nodes[i]);
+    }
+    free(nodes);
+    free(table);
+    free(counts);
+    return ok;
+}
+
+// Prime versus power-of-two table sizing on the same node set
+bool compare_sizing(const CompareConfig *config) {
+    uint32_t node_count = config->node_count;
+    bool use_current;
+    if (!resolve_node_count(&node_count, &use_current)) {
+        return false;
+    }
+
+    char (*names)[MAX_NODE_NAME_LEN] = malloc(node_count * sizeof(*names));
+    uint64_t *keys = malloc(config->key_count * sizeof(uint64_t));
+    uint32_t *owners = malloc(config->key_count * sizeof(uint32_t));
+    if (!names || !keys || !owners) {
+        printf("Error: Memory allocation failed\n");
+        free(names);
+        free(keys);
+        free(owners);
+        return false;
+    }
+
+    fill_names(names, node_count, use_current);
+    for (uint32_t i = 0; i < config->key_count; i++) {
+        keys[i] = hash_key64(i);
+    }
+
+    printf("Comparing table sizing: %u nodes, requested size %u, %u sample keys\n",
+           node_count, config->table_size, config->key_count);
+    printf("  prime: key %% size (integer division); pow2: key & (size - 1), odd skips\n\n");
+    printf("%-7s %10s %9s %10s %10s %7s %9s %9s %11s\n",
+           "sizing", "size", "build_ms", "slots_max", "slots_min", "cv", "max/mean", "lookup_ns", "Mlookups/s");
+
+    const struct {
+        const char *name;
+        uint32_t table_size;
+    } sizings[] = {
+        { "prime", next_prime(config->table_size) },
+        { "pow2", next_pow2(config->table_size) },
+    };
+
+    bool ok = true;
+    for (size_t s = 0; s < sizeof(sizings) / sizeof(sizings[0]); s++) {
+        SizingResult r;
+        if (!run_sizing(sizings[s].table_size, names, node_count, keys, config->key_count, owners, &r)) {
+            printf("%-7s (failed)\n", sizings[s].name);
+            ok = false;
+            continue;
+        }
+        printf("%-7s %10u %9.3f %10.4f %10.4f %7.4f %9.3f %9.2f %11.1f\n",
+               sizings[s].name, r.table_size, r.build_ms, r.slot_max, r.slot_min,
+               r.cv, r.max_over_mean, r.lookup_ns, r.lookup_ns > 0 ? 1e3 / r.lookup_ns : 0.0);
+    }
+
+    free(names);
+    free(keys);
+    free(owners);
+    return ok;
+}
+
+#define THREADS_RUNS 3
+
+// Order-sensitive digest of every preference list
+static uint64_t lists_digest(Node *const *nodes, uint32_t node_count, uint32_t table_size) {
+    uint64_t digest = 0;
+    for (uint32_t i = 0; i < node_count; i++) {
+        const uint32_t *list = nodes[i]->preference_list;
+        for (uint32_t e = 0; e < table_size; e++) {
+            digest = (digest ^ list[e]) * 0x100000001b3ull;
+        }
+    }
+    return digest;
+}
+
+// Preference list generation through the worker pool, from 1 thread to
+// all online CPUs, next to the single-threaded fill it feeds
+bool compare_threads(const CompareConfig *config) {
+    uint32_t node_count = config->node_count;
+    bool use_current;
+    if (!resolve_node_count(&node_count, &use_current)) {
+        return false;
+    }
+
+    uint32_t table_size = maglev_is_pow2(config->table_size) ? config->table_size
+                                                               : next_prime(config->table_size);
+    uint32_t cpus = preference_pool_default_threads();
+    uint32_t max_threads = config->threads ? config->threads : cpus;
+    if (max_threads > PREFERENCE_POOL_MAX_THREADS) max_threads = PREFERENCE_POOL_MAX_THREADS;
+
+    char (*names)[MAX_NODE_NAME_LEN] = malloc(node_count * sizeof(*names));
+    Node **nodes = calloc(node_count, sizeof(Node *));
+    uint32_t *table = malloc(table_size * sizeof(uint32_t));
+    bool ok = names && nodes && table;
+    if (ok) {
+        fill_names(names, node_count, use_current);
+    }
+    for (uint32_t i = 0; ok && i < node_count; i++) {
+        nodes[i] = node_alloc(names[i], table_size);
+        ok = nodes[i] != NULL;
+    }
+    if (!ok) {
+        printf("Error: Memory allocation failed\n");
+        for (uint32_t i = 0; nodes && i < node_count; i++) node_destroy(nodes[i]);
+        free(names);
+        free(nodes);
+        free(table);
+        return false;
+    }
+
+    uint64_t entries = (uint64_t)node_count * table_size;
+    printf("Preference list scaling: %u nodes, table %u (%.1f M entries, %.1f MiB), up to %u thread%s, %u online CPU%s\n",
+           node_count, table_size, entries / 1e6, entries * sizeof(uint32_t) / 1048576.0,
+           max_threads, max_threads == 1 ? "" : "s", cpus, cpus == 1 ? "" : "s");
+
+    // The fill is sequential whatever the thread count
+    preference_pool_generate(nodes, node_count, table_size, 1);
+    uint64_t reference = lists_digest(nodes, node_count, table_size);
+    uint64_t fill_start = timer_now_ns();
+    maglev_fill_table(table, NULL, NULL, table_size, nodes, node_count);
+    double fill_ms = (timer_now_ns() - fill_start) / 1e6;
+    printf("  fill (single thread): %.3f ms\n\n", fill_ms);
+
+    printf("%7s %9s %11s %8s %10s %9s %13s\n",
+           "threads", "prefs_ms", "Mentries/s", "speedup", "efficiency", "build_ms", "build_speedup");
+
+    double base_ms = 0.0;
+    bool identical = true;
+    for (uint32_t t = 1; t <= max_threads; t = (t == max_threads || t * 2 <= max_threads) ? t * 2 : max_threads) {
+        for (uint32_t i = 0; i < node_count; i++) {
+            memset(nodes[i]->preference_list, 0, table_size * sizeof(uint32_t));
+        }
+
+        uint64_t best = UINT64_MAX;
+        uint32_t used = 0;
+        for (int run = 0; run < THREADS_RUNS; run++) {
+            uint64_t start = timer_now_ns();
+            used = preference_pool_generate(nodes, node_count, table_size, t);
+            uint64_t elapsed = timer_now_ns() - start;
+            if (elapsed < best) best = elapsed;
+        }
+        identical = identical && lists_digest(nodes, node_count, table_size) == reference;
+
+        double ms = best / 1e6;
+        if (t == 1) base_ms = ms;
+        double speedup = ms > 0 ? base_ms / ms : 0.0;
+        printf("%7u %9.3f %11.1f %8.2f %9.0f%% %9.3f %13.2f\n",
+               used, ms, ms > 0 ? entries / ms / 1e3 : 0.0, speedup, 100.0 * speedup / used,
+               ms + fill_ms, (base_ms + fill_ms) / (ms + fill_ms));
+        if (used < t) {
+            printf("  (job too small for more threads: at least %u entries per thread)\n",
+                   PREFERENCE_POOL_THREAD_ENTRIES);
+            break;
+        }
+    }
+    printf("\nLists identical to the single-thread run: %s\n", identical ? "yes" : "NO");
+
+    for (uint32_t i = 0; i < node_count; i++) node_destroy(nodes[i]);
+    free(names);
+    free(nodes);
+    free(table);
+    return identical;
+}
+
+#define KERNEL_PERMUTATION_RUNS 20
+#define KERNEL_SLOT_RUNS 5
+#define KERNEL_BATCH 4096
+
+// Best time of runs permutations of one list, in ms
+static double time_permutation(const TableKernel *kernel, uint32_t *list, uint32_t table_size,
+                               uint32_t offset, uint32_t skip) {
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < KERNEL_PERMUTATION_RUNS; run++) {
+        uint64_t start = timer_now_ns();
+        kernel->permutation(list, table_size, offset, skip, 0, table_size);
+        uint64_t elapsed = timer_now_ns() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    return best / 1e6;
+}
+
+// Best time per key of reducing key_count keys in simulator-sized batches, in ns
+static double time_slots(const TableKernel *kernel, const uint64_t *keys, uint32_t *slots,
+                         uint32_t table_size, uint32_t key_count) {
+    uint64_t best = UINT64_MAX;
+    for (int run = 0; run < KERNEL_SLOT_RUNS; run++) {
+        uint64_t start = timer_now_ns();
+        for (uint32_t done = 0; done < key_count; done += KERNEL_BATCH) {
+            uint32_t batch = key_count - done < KERNEL_BATCH ? key_count - done : KERNEL_BATCH;
+            kernel->slots(keys, slots, batch, table_size);
+        }
+        uint64_t elapsed = timer_now_ns() - start;
+        if (elapsed < best) best = elapsed;
+    }
+    return (double)best / key_count;
+}
+
+// Generic versus size-specialized kernels for every specialized size
+bool compare_kernels(const CompareConfig *config) {
+    uint32_t kernel_count;
+    const TableKernel *kernels = table_kernel_specialized(&kernel_count);
+    const TableKernel *generic = table_kernel_generic();
+
+    uint32_t max_size = 0;
+    for (uint32_t k = 0; k < kernel_count; k++) {
+        if (kernels[k].table_size > max_size) max_size = kernels[k].table_size;
+    }
+
+    uint32_t *expected = malloc(max_size * sizeof(uint32_t));
+    uint32_t *actual = malloc(max_size * sizeof(uint32_t));
+    uint64_t *keys = malloc(KERNEL_BATCH * sizeof(uint64_t));
+    uint32_t *slots = malloc(KERNEL_BATCH * sizeof(uint32_t));
+    if (!expected || !actual || !keys || !slots) {
+        printf("Error: Memory allocation failed\n");
+        free(expected);
+        free(actual);
+        free(keys);
+        free(slots);
+        return false;
+    }
+    for (uint32_t i = 0; i < KERNEL_BATCH; i++) {
+        keys[i] = hash_key64(i);
+    }
+
+    printf("Comparing table kernels: generic (runtime size) vs specialized (constant size)\n");
+    printf("  permutation: one full preference list, best of %d; slots: %u keys in batches of %d, best of %d\n\n",
+           KERNEL_PERMUTATION_RUNS, config->key_count, KERNEL_BATCH, KERNEL_SLOT_RUNS);
+    printf("%8s %11s %11s %8s %10s %10s %8s %6s\n",
+           "size", "perm_ms", "perm_ms", "speedup", "slot_ns", "slot_ns", "speedup", "same");
+    printf("%8s %11s %11s %8s %10s %10s %8s %6s\n",
+           "", "generic", "special", "", "generic", "special", "", "");
+
+    bool identical = true;
+    for (uint32_t k = 0; k < kernel_count; k++) {
+        const TableKernel *kernel = &kernels[k];
+        uint32_t table_size = kernel->table_size;
+        uint32_t offset = hash_offset("backend0000", table_size);
+        uint32_t skip = hash_skip("backend0000", table_size);
+
+        double perm_generic = time_permutation(generic, expected, table_size, offset, skip);
+        double perm_special = time_permutation(kernel, actual, table_size, offset, skip);
+        bool same = memcmp(expected, actual, table_size * sizeof(uint32_t)) == 0;
+
+        double slot_generic = time_slots(generic, keys, expected, table_size, config->key_count);
+        double slot_special = time_slots(kernel, keys, slots, table_size, config->key_count);
+        same = same && memcmp(expected, slots, KERNEL_BATCH * sizeof(uint32_t)) == 0;
+        identical = identical && same;
+
+        printf("%8u %11.3f %11.3f %7.2fx %10.2f %10.2f %7.2fx %6s\n",
+               table_size, perm_generic, perm_special,
+               perm_special > 0 ? perm_generic / perm_special : 0.0,
+               slot_generic, slot_special,
+               slot_special > 0 ? slot_generic / slot_special : 0.0,
+               same ? "yes" : "NO");
+    }
+    printf("\nOther sizes use the generic kernels%s\n",
+           g_maglev.is_initialized
+               ? (g_maglev.kernel->table_size ? "; the current table uses its specialized kernels"
+                                              : "; the current table uses them")
+               : "");
+
+    free(expected);
+    free(actual);
+    free(keys);
+    free(slots);
+    return identical;
+}
@@ -0,0 +1,441 @@
+#include "delta.h"
+#include "maglev.h"
+#include "outbuf.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define DELTA_MAGIC 0x444c474du     // "MGLD"
+#define DELTA_VERSION 1
+
+// A table plus the names its entries index into
+typedef struct {
+    uint32_t *table;
+    uint32_t table_size;
+    char (*names)[MAX_NODE_NAME_LEN];
+    uint32_t node_count;
+    uint64_t generation;
+    uint64_t fingerprint;
+} TableCopy;
+
+static TableCopy g_baseline = {0};  // Sender: last exported table
+static TableCopy g_replica = {0};   // Receiver: table rebuilt from deltas
+
+static void table_copy_free(TableCopy *copy) {
+    free(copy->table);
+    free(copy->names);
+    memset(copy, 0, sizeof(*copy));
+}
+
+void delta_reset(void) {
+    table_copy_free(&g_baseline);
+    table_copy_free(&g_replica);
+}
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Four independent lanes over 64-bit words so the multiply chains overlap
+uint64_t delta_fingerprint(const uint32_t *table, uint32_t table_size,
+                           const char (*names)[MAX_NODE_NAME_LEN], uint32_t node_count) {
+    const uint64_t p1 = 0x9e3779b185ebca87ull, p2 = 0xc2b2ae3d27d4eb4full;
+    uint64_t lanes[4] = { p1, p2, p1 ^ p2, ~p1 };
+    uint32_t i = 0;
+
+    for (; i + 8 <= table_size; i += 8) {
+        for (int l = 0; l < 4; l++) {
+            uint64_t w = (uint64_t)table[i + 2 * l] | ((uint64_t)table[i + 2 * l + 1] << 32);
+            lanes[l] = rotl64(lanes[l] + w * p2, 31) * p1;
+        }
+    }
+
+    uint64_t h = rotl64(lanes[0], 1) + rotl64(lanes[1], 7) + rotl64(lanes[2], 12) + rotl64(lanes[3], 18);
+    for (; i < table_size; i++) {
+        h = rotl64(h ^ (table[i] * p2), 27) * p1;
+    }
+
+    for (uint32_t n = 0; n < node_count; n++) {
+        for (const unsigned char *c = (const unsigned char *)names[n]; *c; c++) {
+            h = (h ^ *c) * 0x100000001b3ull;
+        }
+        h = rotl64(h ^ n, 17) * p1;
+    }
+
+    h ^= table_size;
+    h ^= h >> 33;
+    h *= p2;
+    h ^= h >> 29;
+    return h;
+}
+
+static void put_varint(OutBuf *buf, uint64_t value) {
+    while (value >= 0x80) {
+        outbuf_putc(buf, (char)(value | 0x80));
+        value >>= 7;
+    }
+    outbuf_putc(buf, (char)value);
+}
+
+static void put_u64(OutBuf *buf, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        outbuf_putc(buf, (char)(value >> (8 * i)));
+    }
+}
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    bool failed;
+} Reader;
+
+static uint64_t get_varint(Reader *r) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (r->pos >= r->len) {
+            r->failed = true;
+            return 0;
+        }
+        uint8_t byte = r->data[r->pos++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    r->failed = true;
+    return 0;
+}
+
+static uint64_t get_u64(Reader *r) {
+    if (r->pos + 8 > r->len) {
+        r->failed = true;
+        return 0;
+    }
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value |= (uint64_t)r->data[r->pos++] << (8 * i);
+    }
+    return value;
+}
+
+// Write a delta from the last exported table to the current table
+bool delta_export(const char *filename) {
+    if (!g_maglev.is_initialized) {
+        printf("Error: Maglev table not initialized\n");
+        return false;
+    }
+
+    uint64_t start = timer_now_ns();
+    uint32_t size = g_maglev.table_size;
+    uint32_t node_count = g_maglev.table_node_count;
+
+    // New baseline = current published table
+    TableCopy next = {0};
+    next.table = malloc(size * sizeof(uint32_t));
+    next.names = malloc((node_count ? node_count : 1) * sizeof(*next.names));
+    if (!next.table || !next.names) {
+        table_copy_free(&next);
+        printf("Error: Memory allocation failed\n");
+        return false;
+    }
+    for (uint32_t i = 0; i < size; i++) {
+        next.table[i] = maglev_resolve_slot(i);
+    }
+    for (uint32_t n = 0; n < node_count; n++) {
+        memcpy(next.names[n], g_maglev.table_nodes[n]->name, MAX_NODE_NAME_LEN);
+    }
+    next.table_size = size;
+    next.node_count = node_count;
+    next.generation = g_maglev.table_generation;
+    next.fingerprint = delta_fingerprint(next.table, size,
+                                         (const char (*)[MAX_NODE_NAME_LEN])next.names, node_count);
+
+    // A size change (or first export) means a full delta from an empty table
+    bool full = (g_baseline.table == NULL || g_baseline.table_size != size);
+    uint64_t base_fingerprint = full ? delta_fingerprint(NULL, 0, NULL, 0) : g_baseline.fingerprint;
+
+    // Baseline index -> new index by name, so index shifts are not changes
+    uint32_t remap[MAX_NODES];
+    if (!full) {
+        for (uint32_t b = 0; b < g_baseline.node_count; b++) {
+            remap[b] = UINT32_MAX - 1;  // Gone: never equal to a live index
+            for (uint32_t n = 0; n < node_count; n++) {
+                if (strcmp(g_baseline.names[b], next.names[n]) == 0) {
+                    remap[b] = n;
+                    break;
+                }
+            }
+        }
+    }
+
+    OutBuf buf;
+    outbuf_init(&buf, 4096);
+    put_u64(&buf, ((uint64_t)DELTA_VERSION << 32) | DELTA_MAGIC);
+    put_varint(&buf, full ? 0 : g_baseline.generation);
+    put_varint(&buf, next.generation);
+    put_varint(&buf, size);
+    outbuf_putc(&buf, full ? 1 : 0);
+    put_u64(&buf, base_fingerprint);
+    put_u64(&buf, next.fingerprint);
+
+    put_varint(&buf, node_count);
+    for (uint32_t n = 0; n < node_count; n++) {
+        size_t len = strlen(next.names[n]);
+        put_varint(&buf, len);
+        outbuf_append(&buf, next.names[n], len);
+    }
+
+    // Changed ranges: (gap, length, then (owner + 1, repeat) pairs)
+    uint32_t changed = 0, runs = 0, last_end = 0;
+    uint32_t slot = 0;
+    while (slot < size) {
+        uint32_t old_owner = full ? UINT32_MAX : g_baseline.table[slot];
+        uint32_t old_mapped = (old_owner == UINT32_MAX) ? UINT32_MAX : remap[old_owner];
+        if (!full && old_mapped == next.table[slot]) {
+            slot++;
+            continue;
+        }
+
+        // Extend the changed range
+        uint32_t end = slot + 1;
+        while (end < size) {
+            uint32_t o = full ? UINT32_MAX : g_baseline.table[end];
+            uint32_t m = (o == UINT32_MAX) ? UINT32_MAX : remap[o];
+            if (!full && m == next.table[end]) break;
+            end++;
+        }
+
+        put_varint(&buf, slot - last_end);
+        put_varint(&buf, end - slot);
+        for (uint32_t i = slot; i < end; ) {
+            uint32_t value = next.table[i];
+            uint32_t repeat = 1;
+            while (i + repeat < end && next.table[i + repeat] == value) repeat++;
+            put_varint(&buf, (uint64_t)value + 1);     // UINT32_MAX encodes as 0
+            put_varint(&buf, repeat);
+            i += repeat;
+        }
+
+        changed += end - slot;
+        runs++;
+        last_end = end;
+        slot = end;
+    }
+
+    // Run count trails the runs so the encoder makes a single pass
+    put_varint(&buf, runs);
+    uint64_t encoded = timer_now_ns();
+
+    FILE *file = fopen(filename, "wb");
+    bool ok = file && outbuf_write(&buf, file);
+    if (file) ok = (fclose(file) == 0) && ok;
+
+    if (!ok) {
+        printf("Error: Failed to write '%s'\n", filename);
+        outbuf_free(&buf);
+        table_copy_free(&next);
+        return false;
+    }
+
+    printf("Delta generation %llu -> %llu%s written to '%s'\n",
+           (unsigned long long)(full ? 0 : g_baseline.generation),
+           (unsigned long long)next.generation, full ? " (full)" : "", filename);
+    printf("  Changed slots: %u (%.2f%%) in %u ranges\n", changed,
+           size ? 100.0 * changed / size : 0.0, runs);
+    printf("  Size: %zu bytes vs %zu bytes full table (%.2f%%), encode %.3f ms\n",
+           buf.len, (size_t)size * sizeof(uint32_t),
+           size ? 100.0 * buf.len / ((double)size * sizeof(uint32_t)) : 0.0,
+           (encoded - start) / 1e6);
+    printf("  Fingerprint: %016llx\n", (unsigned long long)next.fingerprint);
+
+    outbuf_free(&buf);
+    table_copy_free(&g_baseline);
+    g_baseline = next;
+    return true;
+}
+
+static uint8_t *read_file(const char *filename, size_t *len) {
+    FILE *file = fopen(filename, "rb");
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (size < 0) {
+        fclose(file);
+        return NULL;
+    }
+
+    uint8_t *data = malloc(size ? (size_t)size : 1);
+    if (data && fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        data = NULL;
+    }
+    fclose(file);
+    *len = (size_t)size;
+    return data;
+}
+
+// Apply a delta file to the local receiver replica
+bool delta_apply(const char *filename) {
+    size_t len = 0;
+    uint8_t *data = read_file(filename, &len);
+    if (!data) {
+        printf("Error: Cannot read file '%s'\n", filename);
+        return false;
+    }
+
+    uint64_t start = timer_now_ns();
+    Reader r = { data, len, 0, false };
+    bool ok = false;
+    TableCopy next = {0};
+
+    uint64_t magic = get_u64(&r);
+    uint64_t from_generation = get_varint(&r);
+    uint64_t to_generation = get_varint(&r);
+    uint64_t size = get_varint(&r);
+    bool full = (r.pos < len) ? data[r.pos++] != 0 : (r.failed = true, false);
+    uint64_t base_fingerprint = get_u64(&r);
+    uint64_t target_fingerprint = get_u64(&r);
+    uint64_t node_count = get_varint(&r);
+
+    if (r.failed || magic != (((uint64_t)DELTA_VERSION << 32) | DELTA_MAGIC) ||
+        size == 0 || size > UINT32_MAX || node_count > MAX_NODES) {
+        printf("Error: '%s' is not a valid delta file\n", filename);
+        goto out;
+    }
+
+    // The replica must be exactly the table this delta was computed against
+    uint64_t replica_fingerprint = g_replica.table
+        ? g_replica.fingerprint : delta_fingerprint(NULL, 0, NULL, 0);
+    if (!full && (replica_fingerprint != base_fingerprint || g_replica.table_size != size)) {
+        printf("Error: Replica (generation %llu) does not match delta base (generation %llu)\n",
+               (unsigned long long)g_replica.generation, (unsigned long long)from_generation);
+        goto out;
+    }
+
+    next.table_size = (uint32_t)size;
+    next.node_count = (uint32_t)node_count;
+    next.generation = to_generation;
+    next.table = malloc(size * sizeof(uint32_t));
+    next.names = calloc(node_count ? node_count : 1, sizeof(*next.names));
+    if (!next.table || !next.names) {
+        printf("Error: Memory allocation failed\n");
+        goto out;
+    }
+
+    for (uint32_t n = 0; n < node_count; n++) {
+        uint64_t name_len = get_varint(&r);
+        if (r.failed || name_len >= MAX_NODE_NAME_LEN || r.pos + name_len > len) {
+            r.failed = true;
+            break;
+        }
+        memcpy(next.names[n], data + r.pos, name_len);
+        r.pos += name_len;
+    }
+
+    // Carry unchanged slots over, translating replica indices to the new name list
+    if (full) {
+        for (uint32_t i = 0; i < size; i++) next.table[i] = UINT32_MAX;
+    } else {
+        uint32_t remap[MAX_NODES];
+        for (uint32_t b = 0; b < g_replica.node_count; b++) {
+            remap[b] = UINT32_MAX;
+            for (uint32_t n = 0; n < node_count; n++) {
+                if (strcmp(g_replica.names[b], next.names[n]) == 0) {
+                    remap[b] = n;
+                    break;
+                }
+            }
+        }
+        for (uint32_t i = 0; i < size; i++) {
+            uint32_t owner = g_replica.table[i];
+            next.table[i] = (owner == UINT32_MAX) ? UINT32_MAX : remap[owner];
+        }
+    }
+
+    // Changed ranges; the run count trails them
+    uint32_t changed = 0, runs = 0;
+    uint64_t slot = 0;
+    while (!r.failed && r.pos < len) {
+        // Peek: the last varint in the file is the run count
+        size_t mark = r.pos;
+        uint64_t gap = get_varint(&r);
+        if (r.pos == len) {
+            if (gap != runs) r.failed = true;
+            break;
+        }
+        r.pos = mark;
+
+        gap = get_varint(&r);
+        uint64_t run_len = get_varint(&r);
+        slot += gap;
+        if (r.failed || slot + run_len > size) {
+            r.failed = true;
+            break;
+        }
+
+        uint64_t end = slot + run_len;
+        while (slot < end) {
+            uint64_t value = get_varint(&r);
+            uint64_t repeat = get_varint(&r);
+            if (r.failed || repeat == 0 || slot + repeat > end || value > (uint64_t)node_count) {
+                r.failed = true;
+                break;
+            }
+            uint32_t owner = value ? (uint32_t)(value - 1) : UINT32_MAX;
+            for (uint64_t k = 0; k < repeat; k++) {
+                next.table[slot++] = owner;
+            }
+        }
+        changed += (uint32_t)run_len;
+        runs++;
+    }
+
+    if (r.failed) {
+        printf("Error: '%s' is truncated or corrupt\n", filename);
+        goto out;
+    }
+
+    next.fingerprint = delta_fingerprint(next.table, next.table_size,
+                                         (const char (*)[MAX_NODE_NAME_LEN])next.names,
+                                         next.node_count);
+    if (next.fingerprint != target_fingerprint) {
+        printf("Error: Fingerprint mismatch after applying '%s' (got %016llx, expected %016llx)\n",
+               filename, (unsigned long long)next.fingerprint,
+               (unsigned long long)target_fingerprint);
+        goto out;
+    }
+
+    uint64_t elapsed = timer_now_ns() - start;
+    table_copy_free(&g_replica);
+    g_replica = next;
+    memset(&next, 0, sizeof(next));
+    ok = true;
+
+    printf("Applied delta generation %llu -> %llu from '%s': %u slots in %u ranges, %.3f ms\n",
+           (unsigned long long)from_generation, (unsigned long long)to_generation,
+           filename, changed, runs, elapsed / 1e6);
+    printf("  Replica fingerprint %016llx verified\n", (unsigned long long)g_replica.fingerprint);
+
+    // Compare against the live table when it is the same generation
+    if (g_maglev.is_initialized && g_maglev.table_generation == g_replica.generation &&
+        g_maglev.table_size == g_replica.table_size) {
+        bool match = true;
+        for (uint32_t i = 0; i < g_replica.table_size && match; i++) {
+            uint32_t live = maglev_resolve_slot(i);
+            uint32_t mine = g_replica.table[i];
+            const char *a = (live == UINT32_MAX) ? "" : g_maglev.table_nodes[live]->name;
+            const char *b = (mine == UINT32_MAX) ? "" : g_replica.names[mine];
+            match = strcmp(a, b) == 0;
+        }
+        printf("  Replica %s the live table\n", match ? "matches" : "DIFFERS FROM");
+    }
+
+out:
+    table_copy_free(&next);
+    free(data);
+    return ok;
+}
@@ -0,0 +1,788 @@
+#include "des.h"
+#include "engine.h"
+#include "keystream.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define DES_KEY_BATCH 4096
+#define DES_LINE_LEN 1024
+#define DES_UTIL_COLUMNS 10     // Per-backend utilisation columns before switching to mean/max
+#define LAT_SUB_BITS 4          // 16 sub-buckets per power of two (~6% resolution)
+#define LAT_SUB (1u << LAT_SUB_BITS)
+#define LAT_BUCKETS ((64 - LAT_SUB_BITS + 1) * LAT_SUB)
+
+// Same-time events run in this order, so a report closes its interval first
+typedef enum {
+    DES_REPORT,
+    DES_TIMELINE,
+    DES_DEPARTURE,
+    DES_ARRIVAL
+} DesEventType;
+
+typedef struct {
+    double time;
+    uint32_t type;
+    uint32_t arg;               // Backend index or timeline action index
+    uint32_t epoch;             // Departure: backend epoch, stale after a del
+} DesEvent;
+
+// Binary min-heap on event time
+typedef struct {
+    DesEvent *items;
+    uint32_t count;
+    uint32_t cap;
+} DesHeap;
+
+typedef enum {
+    DES_ACT_ADD,
+    DES_ACT_DEL,
+    DES_ACT_DRAIN,
+    DES_ACT_RATE
+} DesActionType;
+
+typedef struct {
+    double time;
+    DesActionType type;
+    char name[MAX_NODE_NAME_LEN];
+    double value;               // Capacity (add) or arrival rate (rate), 0 = default
+    uint32_t order;             // File order, keeps same-time actions stable
+} DesAction;
+
+typedef struct {
+    double duration;
+    double rate;
+    double service;
+    double report;
+    uint32_t queue_limit;
+    uint32_t table_size;
+    KeyStreamConfig keys;
+    DesAction *actions;
+    uint32_t action_count;
+    uint32_t action_cap;
+    uint32_t initial_count;     // 'backend' lines
+} DesScenario;
+
+typedef struct {
+    char name[MAX_NODE_NAME_LEN];
+    double capacity;
+    bool in_table;
+    bool draining;
+    uint32_t epoch;
+    double *queue;              // Arrival times, head is in service
+    uint32_t head;
+    uint32_t len;
+    uint32_t cap;
+    bool busy;
+    double busy_since;
+    double busy_interval;
+    double busy_total;
+    uint64_t served;
+    uint64_t lost;              // Queue overflow or queued at del
+} DesBackend;
+
+typedef struct {
+    uint64_t buckets[LAT_BUCKETS];
+    uint64_t count;
+    double max;
+} LatencyHist;
+
+typedef struct {
+    DesScenario *sc;
+    DesHeap heap;
+    DesBackend *backends;
+    uint32_t backend_count;
+    int column_width;           // Utilisation column width (name length, 6..12)
+    const EngineOps *engine;
+    void *table;
+    KeyStream ks;
+    uint64_t keys[DES_KEY_BATCH];
+    uint32_t key_pos;
+    uint64_t rng;
+    double now;
+    double rate;
+    bool arrival_pending;
+    double interval_start;
+    LatencyHist interval_hist;
+    LatencyHist total_hist;
+    uint64_t events;
+    uint64_t arrivals;
+    uint64_t unrouted;
+    uint64_t interval_arrivals;
+    uint64_t interval_served;
+    uint64_t interval_lost;
+} DesSim;
+
+static inline bool event_before(const DesEvent *a, const DesEvent *b) {
+    return a->time < b->time || (a->time == b->time && a->type < b->type);
+}
+
+static bool heap_push(DesHeap *heap, DesEvent ev) {
+    if (heap->count == heap->cap) {
+        uint32_t cap = heap->cap ? heap->cap * 2 : 64;
+        DesEvent *items = realloc(heap->items, cap * sizeof(DesEvent));
+        if (!items) return false;
+        heap->items = items;
+        heap->cap = cap;
+    }
+
+    uint32_t i = heap->count++;
+    while (i > 0) {
+        uint32_t parent = (i - 1) / 2;
+        if (!event_before(&ev, &heap->items[parent])) break;
+        heap->items[i] = heap->items[parent];
+        i = parent;
+    }
+    heap->items[i] = ev;
+    return true;
+}
+
+static DesEvent heap_pop(DesHeap *heap) {
+    DesEvent top = heap->items[0];
+    DesEvent last = heap->items[--heap->count];
+    uint32_t i = 0;
+
+    for (;;) {
+        uint32_t child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && event_before(&heap->items[child + 1], &heap->items[child])) {
+            child++;
+        }
+        if (!event_before(&heap->items[child], &last)) break;
+        heap->items[i] = heap->items[child];
+        i = child;
+    }
+    if (heap->count > 0) {
+        heap->items[i] = last;
+    }
+    return top;
+}
+
+static inline uint64_t des_rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dull;
+}
+
+// Exponential inter-event time for a Poisson process of the given rate
+static inline double exp_sample(uint64_t *state, double rate) {
+    double u = (des_rng_next(state) >> 11) * 0x1.0p-53;
+    return -log1p(-u) / rate;
+}
+
+static uint32_t latency_bucket(uint64_t us) {
+    if (us < LAT_SUB) return (uint32_t)us;
+    uint32_t e = 63 - (uint32_t)__builtin_clzll(us);
+    return (e - LAT_SUB_BITS + 1) * LAT_SUB + (uint32_t)((us >> (e - LAT_SUB_BITS)) & (LAT_SUB - 1));
+}
+
+// Upper edge of a bucket in microseconds
+static double latency_bucket_upper(uint32_t bucket) {
+    if (bucket < LAT_SUB) return bucket;
+    uint32_t e = bucket / LAT_SUB + LAT_SUB_BITS - 1;
+    uint32_t sub = bucket % LAT_SUB;
+    double width = ldexp(1.0, (int)(e - LAT_SUB_BITS));
+    return (LAT_SUB + sub + 1) * width;
+}
+
+static void latency_add(LatencyHist *hist, double seconds) {
+    uint64_t us = (uint64_t)(seconds * 1e6);
+    hist->buckets[latency_bucket(us)]++;
+    hist->count++;
+    if (seconds > hist->max) hist->max = seconds;
+}
+
+// Percentile in milliseconds (bucket upper edge, capped at the observed max)
+static double latency_percentile(const LatencyHist *hist, double p) {
+    if (hist->count == 0) return 0.0;
+
+    uint64_t rank = (uint64_t)ceil(p * hist->count);
+    if (rank == 0) rank = 1;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < LAT_BUCKETS; b++) {
+        seen += hist->buckets[b];
+        if (seen >= rank) {
+            double ms = latency_bucket_upper(b) / 1e3;
+            return ms < hist->max * 1e3 ? ms : hist->max * 1e3;
+        }
+    }
+    return hist->max * 1e3;
+}
+
+static void format_time(double seconds, char *buf, size_t len) {
+    uint64_t s = (uint64_t)seconds;
+    snprintf(buf, len, "%02llu:%02llu:%02llu", (unsigned long long)(s / 3600),
+             (unsigned long long)(s / 60 % 60), (unsigned long long)(s % 60));
+}
+
+static bool scenario_add_action(DesScenario *sc, double time, DesActionType type,
+                                const char *name, double value) {
+    if (sc->action_count == sc->action_cap) {
+        uint32_t cap = sc->action_cap ? sc->action_cap * 2 : 16;
+        DesAction *actions = realloc(sc->actions, cap * sizeof(DesAction));
+        if (!actions) return false;
+        sc->actions = actions;
+        sc->action_cap = cap;
+    }
+
+    DesAction *a = &sc->actions[sc->action_count];
+    memset(a, 0, sizeof(*a));
+    a->time = time;
+    a->type = type;
+    a->value = value;
+    a->order = sc->action_count++;
+    if (name) {
+        snprintf(a->name, sizeof(a->name), "%s", name);
+    }
+    return true;
+}
+
+static bool parse_double(const char *s, double *value) {
+    char *end;
+    if (!s) return false;
+    *value = strtod(s, &end);
+    return *end == '\0' && *value >= 0 && isfinite(*value);
+}
+
+static bool scenario_parse(const char *filename, DesScenario *sc) {
+    FILE *file = fopen(filename, "r");
+    if (!file) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        return false;
+    }
+
+    char line[DES_LINE_LEN];
+    uint32_t line_no = 0;
+    bool ok = true;
+
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_no++;
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+
+        char *tok[6] = {0};
+        int n = 0;
+        for (char *t = strtok(line, " \t\r\n"); t && n < 6; t = strtok(NULL, " \t\r\n")) {
+            tok[n++] = t;
+        }
+        if (n == 0) continue;
+
+        double v = 0, at = 0;
+        if (strcmp(tok[0], "duration") == 0 && n == 2 && parse_double(tok[1], &v) && v > 0) {
+            sc->duration = v;
+        } else if (strcmp(tok[0], "rate") == 0 && n == 2 && parse_double(tok[1], &v)) {
+            sc->rate = v;
+        } else if (strcmp(tok[0], "service") == 0 && n == 2 && parse_double(tok[1], &v) && v > 0) {
+            sc->service = v;
+        } else if (strcmp(tok[0], "report") == 0 && n == 2 && parse_double(tok[1], &v) && v > 0) {
+            sc->report = v;
+        } else if (strcmp(tok[0], "queue") == 0 && n == 2 && parse_double(tok[1], &v) &&
+                   v >= 1 && v <= UINT32_MAX) {
+            sc->queue_limit = (uint32_t)v;
+        } else if (strcmp(tok[0], "table") == 0 && n == 2 && parse_double(tok[1], &v) &&
+                   v >= 2 && v <= UINT32_MAX / 2) {
+            sc->table_size = (uint32_t)v;
+        } else if (strcmp(tok[0], "flows") == 0 && n == 2 && parse_double(tok[1], &v) &&
+                   v >= 1 && v <= UINT32_MAX) {
+            sc->keys.flow_count = (uint32_t)v;
+        } else if (strcmp(tok[0], "seed") == 0 && n == 2 && parse_double(tok[1], &v)) {
+            sc->keys.seed = (uint64_t)v;
+        } else if (strcmp(tok[0], "dist") == 0 && (n == 2 || n == 3) &&
+                   keystream_parse_distribution(tok[1], &sc->keys.dist)) {
+            if (n == 3) {
+                ok = parse_double(tok[2], &v) && v > 0;
+                if (sc->keys.dist == KEYDIST_ZIPF) {
+                    sc->keys.zipf_s = v;
+                } else if (sc->keys.dist == KEYDIST_HOTSPOT) {
+                    ok = ok && v <= 1;
+                    sc->keys.hot_traffic_share = v;
+                }
+            }
+        } else if (strcmp(tok[0], "backend") == 0 && (n == 2 || n == 3) &&
+                   strlen(tok[1]) < MAX_NODE_NAME_LEN && (n == 2 || (parse_double(tok[2], &v) && v > 0))) {
+            ok = scenario_add_action(sc, 0.0, DES_ACT_ADD, tok[1], v);
+            sc->initial_count++;
+        } else if (strcmp(tok[0], "at") == 0 && n >= 3 && parse_double(tok[1], &at)) {
+            if (strcmp(tok[2], "add") == 0 && (n == 4 || n == 5) && strlen(tok[3]) < MAX_NODE_NAME_LEN &&
+                (n == 4 || (parse_double(tok[4], &v) && v > 0))) {
+                ok = scenario_add_action(sc, at, DES_ACT_ADD, tok[3], v);
+            } else if (strcmp(tok[2], "del") == 0 && n == 4) {
+                ok = scenario_add_action(sc, at, DES_ACT_DEL, tok[3], 0);
+            } else if (strcmp(tok[2], "drain") == 0 && n == 4) {
+                ok = scenario_add_action(sc, at, DES_ACT_DRAIN, tok[3], 0);
+            } else if (strcmp(tok[2], "rate") == 0 && n == 4 && parse_double(tok[3], &v)) {
+                ok = scenario_add_action(sc, at, DES_ACT_RATE, NULL, v);
+            } else {
+                ok = false;
+            }
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            printf("Error: %s:%u: invalid directive '%s'\n", filename, line_no, tok[0]);
+        }
+    }
+
+    fclose(file);
+    return ok;
+}
+
+static int action_compare(const void *a, const void *b) {
+    const DesAction *x = a, *y = b;
+    if (x->time != y->time) return x->time < y->time ? -1 : 1;
+    return x->order < y->order ? -1 : (x->order > y->order);
+}
+
+static DesBackend *find_backend(DesSim *sim, const char *name) {
+    for (uint32_t i = 0; i < sim->backend_count; i++) {
+        if (strcmp(sim->backends[i].name, name) == 0) {
+            return &sim->backends[i];
+        }
+    }
+    return NULL;
+}
+
+static DesBackend *get_backend(DesSim *sim, const char *name) {
+    DesBackend *b = find_backend(sim, name);
+    if (b || sim->backend_count >= MAX_NODES) return b;
+
+    b = &sim->backends[sim->backend_count++];
+    memset(b, 0, sizeof(*b));
+    strcpy(b->name, name);
+    b->capacity = sim->sc->service;
+    return b;
+}
+
+static bool schedule(DesSim *sim, double time, DesEventType type, uint32_t arg, uint32_t epoch) {
+    DesEvent ev = { time, type, arg, epoch };
+    return heap_push(&sim->heap, ev);
+}
+
+// Close the busy period bookkeeping at the current time
+static void account_busy(DesSim *sim, DesBackend *b) {
+    if (b->busy) {
+        double busy = sim->now - b->busy_since;
+        b->busy_interval += busy;
+        b->busy_total += busy;
+        b->busy_since = sim->now;
+    }
+}
+
+static bool start_service(DesSim *sim, uint32_t index) {
+    DesBackend *b = &sim->backends[index];
+    b->busy = true;
+    b->busy_since = sim->now;
+    return schedule(sim, sim->now + exp_sample(&sim->rng, b->capacity), DES_DEPARTURE, index, b->epoch);
+}
+
+static bool handle_arrival(DesSim *sim) {
+    sim->arrivals++;
+    sim->interval_arrivals++;
+
+    if (sim->key_pos == DES_KEY_BATCH) {
+        keystream_fill(&sim->ks, sim->keys, DES_KEY_BATCH);
+        sim->key_pos = 0;
+    }
+    uint32_t owner = sim->engine->lookup(sim->table, sim->keys[sim->key_pos++]);
+
+    if (owner == UINT32_MAX) {
+        sim->unrouted++;
+        sim->interval_lost++;
+    } else {
+        DesBackend *b = &sim->backends[owner];
+        if (b->len >= sim->sc->queue_limit) {
+            b->lost++;
+            sim->interval_lost++;
+        } else {
+            if (b->len == b->cap) {
+                uint32_t cap = b->cap ? b->cap * 2 : 16;
+                double *queue = malloc(cap * sizeof(double));
+                if (!queue) return false;
+                for (uint32_t i = 0; i < b->len; i++) {
+                    queue[i] = b->queue[(b->head + i) % b->cap];
+                }
+                free(b->queue);
+                b->queue = queue;
+                b->head = 0;
+                b->cap = cap;
+            }
+            uint32_t tail = b->head + b->len;
+            b->queue[tail < b->cap ? tail : tail - b->cap] = sim->now;
+            b->len++;
+            if (!b->busy && !start_service(sim, owner)) return false;
+        }
+    }
+
+    sim->arrival_pending = false;
+    if (sim->rate > 0) {
+        sim->arrival_pending = true;
+        return schedule(sim, sim->now + exp_sample(&sim->rng, sim->rate), DES_ARRIVAL, 0, 0);
+    }
+    return true;
+}
+
+static bool handle_departure(DesSim *sim, const DesEvent *ev) {
+    DesBackend *b = &sim->backends[ev->arg];
+    if (ev->epoch != b->epoch || !b->busy) {
+        return true;    // Backend was deleted while serving
+    }
+
+    double latency = sim->now - b->queue[b->head];
+    latency_add(&sim->interval_hist, latency);
+    latency_add(&sim->total_hist, latency);
+    b->head = (b->head + 1 == b->cap) ? 0 : b->head + 1;
+    b->len--;
+    b->served++;
+    sim->interval_served++;
+
+    account_busy(sim, b);
+    if (b->len > 0) {
+        return start_service(sim, ev->arg);
+    }
+
+    b->busy = false;
+    if (b->draining) {
+        char when[32];
+        format_time(sim->now, when, sizeof(when));
+        printf("  [%s] drain %s complete\n", when, b->name);
+        b->draining = false;
+    }
+    return true;
+}
+
+static void handle_action(DesSim *sim, const DesAction *a) {
+    char when[32];
+    format_time(sim->now, when, sizeof(when));
+
+    if (a->type == DES_ACT_RATE) {
+        sim->rate = a->value;
+        printf("  [%s] rate %.0f req/s\n", when, a->value);
+        if (sim->rate > 0 && !sim->arrival_pending) {
+            sim->arrival_pending = schedule(sim, sim->now + exp_sample(&sim->rng, sim->rate),
+                                            DES_ARRIVAL, 0, 0);
+        }
+        return;
+    }
+
+    DesBackend *b = (a->type == DES_ACT_ADD) ? get_backend(sim, a->name) : find_backend(sim, a->name);
+    if (!b) {
+        printf("  [%s] %s %s: unknown backend, ignored\n", when,
+               a->type == DES_ACT_DEL ? "del" : a->type == DES_ACT_DRAIN ? "drain" : "add", a->name);
+        return;
+    }
+    uint32_t index = (uint32_t)(b - sim->backends);
+
+    uint64_t start = timer_now_ns();
+    bool changed = false;
+    uint32_t dropped = 0;
+
+    if (a->type == DES_ACT_ADD) {
+        if (a->value > 0) b->capacity = a->value;
+        b->draining = false;
+        if (!b->in_table) {
+            changed = sim->engine->add(sim->table, index, b->name);
+            b->in_table = changed;
+        }
+    } else {
+        if (b->in_table) {
+            changed = sim->engine->remove(sim->table, index);
+            b->in_table = false;
+        }
+        if (a->type == DES_ACT_DEL) {
+            // In-flight and queued requests are lost with the backend
+            account_busy(sim, b);
+            dropped = b->len;
+            b->lost += b->len;
+            sim->interval_lost += b->len;
+            b->len = 0;
+            b->head = 0;
+            b->busy = false;
+            b->draining = false;
+            b->epoch++;
+        } else {
+            b->draining = b->len > 0;
+        }
+    }
+
+    if (changed) {
+        sim->engine->commit(sim->table);
+    }
+    double rebuild_ms = (timer_now_ns() - start) / 1e6;
+
+    if (a->type == DES_ACT_ADD) {
+        printf("  [%s] add %s (%.0f req/s), table rebuilt in %.2f ms\n",
+               when, b->name, b->capacity, rebuild_ms);
+    } else if (a->type == DES_ACT_DEL) {
+        printf("  [%s] del %s, %u queued requests lost, table rebuilt in %.2f ms\n",
+               when, b->name, dropped, rebuild_ms);
+    } else {
+        printf("  [%s] drain %s, %u requests queued, table rebuilt in %.2f ms\n",
+               when, b->name, b->len, rebuild_ms);
+    }
+}
+
+static void print_header(const DesSim *sim) {
+    printf("  %-8s %10s %10s %8s %9s %9s %9s  ", "Time", "Arrivals", "Served", "Lost",
+           "p50(ms)", "p99(ms)", "p999(ms)");
+    if (sim->backend_count <= DES_UTIL_COLUMNS) {
+        printf("Utilisation:");
+        for (uint32_t i = 0; i < sim->backend_count; i++) {
+            printf(" %*.*s", sim->column_width, sim->column_width, sim->backends[i].name);
+        }
+    } else {
+        printf("%9s %9s  %s", "Util avg", "Util max", "Hottest");
+    }
+    printf("\n");
+}
+
+static void report_interval(DesSim *sim) {
+    double length = sim->now - sim->interval_start;
+    if (length <= 0) return;
+
+    char when[32];
+    format_time(sim->now, when, sizeof(when));
+    printf("  %-8s %10llu %10llu %8llu %9.2f %9.2f %9.2f  ", when,
+           (unsigned long long)sim->interval_arrivals, (unsigned long long)sim->interval_served,
+           (unsigned long long)sim->interval_lost,
+           latency_percentile(&sim->interval_hist, 0.50),
+           latency_percentile(&sim->interval_hist, 0.99),
+           latency_percentile(&sim->interval_hist, 0.999));
+
+    double util_sum = 0.0, util_max = 0.0;
+    uint32_t util_count = 0, hottest = 0;
+    if (sim->backend_count <= DES_UTIL_COLUMNS) printf("            ");
+
+    for (uint32_t i = 0; i < sim->backend_count; i++) {
+        DesBackend *b = &sim->backends[i];
+        account_busy(sim, b);
+        double util = b->busy_interval / length;
+        b->busy_interval = 0.0;
+
+        if (sim->backend_count <= DES_UTIL_COLUMNS) {
+            if (b->in_table || util > 0) {
+                printf(" %*.1f%%", sim->column_width - 1, 100.0 * util);
+            } else {
+                printf(" %*s", sim->column_width, "-");
+            }
+        }
+        if (b->in_table || util > 0) {
+            util_sum += util;
+            util_count++;
+            if (util > util_max) {
+                util_max = util;
+                hottest = i;
+            }
+        }
+    }
+
+    if (sim->backend_count > DES_UTIL_COLUMNS) {
+        printf("%8.1f%% %8.1f%%  %s", util_count ? 100.0 * util_sum / util_count : 0.0,
+               100.0 * util_max, util_count ? sim->backends[hottest].name : "-");
+    }
+    printf("\n");
+
+    memset(&sim->interval_hist, 0, sizeof(sim->interval_hist));
+    sim->interval_arrivals = 0;
+    sim->interval_served = 0;
+    sim->interval_lost = 0;
+    sim->interval_start = sim->now;
+}
+
+static bool des_loop(DesSim *sim) {
+    DesScenario *sc = sim->sc;
+    uint32_t next_action = 0;
+
+    // Initial membership
+    while (next_action < sc->action_count && sc->actions[next_action].time <= 0.0) {
+        handle_action(sim, &sc->actions[next_action++]);
+    }
+
+    print_header(sim);
+
+    bool ok = true;
+    if (sim->rate > 0) {
+        sim->arrival_pending = true;
+        ok = schedule(sim, exp_sample(&sim->rng, sim->rate), DES_ARRIVAL, 0, 0);
+    }
+    ok = ok && schedule(sim, sc->report, DES_REPORT, 0, 0);
+    if (next_action < sc->action_count) {
+        ok = ok && schedule(sim, sc->actions[next_action].time, DES_TIMELINE, next_action, 0);
+    }
+
+    while (ok && sim->heap.count > 0) {
+        DesEvent ev = heap_pop(&sim->heap);
+        if (ev.time > sc->duration) break;
+
+        sim->now = ev.time;
+        sim->events++;
+
+        switch (ev.type) {
+            case DES_ARRIVAL:
+                ok = handle_arrival(sim);
+                break;
+
+            case DES_DEPARTURE:
+                ok = handle_departure(sim, &ev);
+                break;
+
+            case DES_TIMELINE:
+                handle_action(sim, &sc->actions[ev.arg]);
+                if (ev.arg + 1 < sc->action_count) {
+                    ok = schedule(sim, sc->actions[ev.arg + 1].time, DES_TIMELINE, ev.arg + 1, 0);
+                }
+                break;
+
+            case DES_REPORT:
+                report_interval(sim);
+                ok = schedule(sim, sim->now + sc->report, DES_REPORT, 0, 0);
+                break;
+        }
+    }
+
+    sim->now = sc->duration;
+    if (sim->now - sim->interval_start > 1e-9) {
+        report_interval(sim);
+    } else {
+        for (uint32_t i = 0; i < sim->backend_count; i++) account_busy(sim, &sim->backends[i]);
+    }
+
+    if (!ok) {
+        printf("Error: Memory allocation failed\n");
+    }
+    return ok;
+}
+
+static void print_summary(const DesSim *sim, double wall_seconds) {
+    const DesScenario *sc = sim->sc;
+    uint64_t served = 0, lost = sim->unrouted, queued = 0;
+
+    int width = 4;
+    for (uint32_t i = 0; i < sim->backend_count; i++) {
+        int len = (int)strlen(sim->backends[i].name);
+        if (len > width) width = len;
+    }
+
+    printf("Per-backend totals:\n");
+    for (uint32_t i = 0; i < sim->backend_count; i++) {
+        const DesBackend *b = &sim->backends[i];
+        served += b->served;
+        lost += b->lost;
+        queued += b->len;
+        printf("  %-*s %8.0f req/s  served %12llu  lost %10llu  utilisation %5.1f%%%s\n",
+               width, b->name, b->capacity,
+               (unsigned long long)b->served, (unsigned long long)b->lost,
+               100.0 * b->busy_total / sc->duration, b->in_table ? "" : "  (removed)");
+    }
+
+    printf("Requests: %llu arrived, %llu served, %llu lost (%llu unrouted), %llu still queued\n",
+           (unsigned long long)sim->arrivals, (unsigned long long)served,
+           (unsigned long long)lost, (unsigned long long)sim->unrouted,
+           (unsigned long long)queued);
+    printf("Latency: p50 %.2f ms, p99 %.2f ms, p99.9 %.2f ms, max %.2f ms\n",
+           latency_percentile(&sim->total_hist, 0.50),
+           latency_percentile(&sim->total_hist, 0.99),
+           latency_percentile(&sim->total_hist, 0.999), sim->total_hist.max * 1e3);
+    printf("Simulated %.0f s with %llu events in %.2f s wall (%.2f M events/s)\n",
+           sc->duration, (unsigned long long)sim->events, wall_seconds,
+           wall_seconds > 0 ? sim->events / wall_seconds / 1e6 : 0.0);
+}
+
+bool des_run_scenario(const char *filename, uint32_t table_size,
+                      const char (*nodes)[MAX_NODE_NAME_LEN], uint32_t node_count) {
+    DesScenario sc;
+    memset(&sc, 0, sizeof(sc));
+    sc.duration = 3600.0;
+    sc.rate = 1000.0;
+    sc.service = 400.0;
+    sc.queue_limit = 10000;
+    sc.table_size = table_size ? table_size : DEFAULT_TABLE_SIZE;
+    keystream_default_config(&sc.keys, KEYDIST_UNIFORM);
+
+    if (!scenario_parse(filename, &sc)) {
+        free(sc.actions);
+        return false;
+    }
+    if (sc.report <= 0) {
+        sc.report = sc.duration / 24;
+    }
+
+    // Without 'backend' lines, start from the current nodes
+    if (sc.initial_count == 0) {
+        if (!nodes || node_count == 0) {
+            printf("Error: No backends (add 'backend' lines or nodes)\n");
+            free(sc.actions);
+            return false;
+        }
+        for (uint32_t i = 0; i < node_count; i++) {
+            if (!scenario_add_action(&sc, 0.0, DES_ACT_ADD, nodes[i], 0)) {
+                printf("Error: Memory allocation failed\n");
+                free(sc.actions);
+                return false;
+            }
+        }
+    }
+    qsort(sc.actions, sc.action_count, sizeof(DesAction), action_compare);
+
+    DesSim *sim = calloc(1, sizeof(DesSim));
+    if (!sim) {
+        printf("Error: Memory allocation failed\n");
+        free(sc.actions);
+        return false;
+    }
+    sim->sc = &sc;
+    sim->rate = sc.rate;
+    sim->rng = sc.keys.seed ^ 0xd1b54a32d192ed03ull;
+    if (sim->rng == 0) sim->rng = 1;
+    sim->key_pos = DES_KEY_BATCH;
+    sim->engine = &maglev_engine;
+    sim->backends = calloc(MAX_NODES, sizeof(DesBackend));
+    sim->table = sim->engine->create(sc.table_size);
+
+    bool ok = sim->backends && sim->table && keystream_init(&sim->ks, &sc.keys);
+    if (ok) {
+        // Create every backend named in the scenario up front so report columns stay fixed
+        for (uint32_t i = 0; i < sc.action_count; i++) {
+            if (sc.actions[i].type == DES_ACT_ADD) get_backend(sim, sc.actions[i].name);
+        }
+        sim->column_width = 6;
+        for (uint32_t i = 0; i < sim->backend_count; i++) {
+            int len = (int)strlen(sim->backends[i].name);
+            if (len > sim->column_width) sim->column_width = len < 12 ? len : 12;
+        }
+
+        uint32_t engine_size = next_prime(sc.table_size);
+        printf("Discrete-event simulation: %.0f s, %.0f req/s, %s keys over %u flows, table %u\n",
+               sc.duration, sc.rate, keystream_distribution_name(sc.keys.dist),
+               sc.keys.flow_count, engine_size);
+        if (engine_size != sc.table_size) {
+            printf("  Table size %u rounded up to the prime %u (the simulation engine uses prime sizes)\n",
+                   sc.table_size, engine_size);
+        }
+
+        uint64_t start = timer_now_ns();
+        ok = des_loop(sim);
+        double wall = (timer_now_ns() - start) / 1e9;
+        if (ok) {
+            print_summary(sim, wall);
+        }
+        keystream_free(&sim->ks);
+    } else {
+        printf("Error: Failed to set up simulation\n");
+    }
+
+    if (sim->table) sim->engine->destroy(sim->table);
+    if (sim->backends) {
+        for (uint32_t i = 0; i < sim->backend_count; i++) free(sim->backends[i].queue);
+    }
+    free(sim->backends);
+    free(sim->heap.items);
+    free(sim);
+    free(sc.actions);
+    return ok;
+}
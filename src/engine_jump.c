@@ -0,0 +1,84 @@
+#include "engine.h"
+#include <stdlib.h>
+
+// Jump consistent hash (Lamping & Veach). Buckets are numbered 0..n-1, so
+// only removing the last bucket is minimal. Removing any other node moves
+// the last node into its bucket, which also remaps the last bucket's keys.
+typedef struct {
+    uint32_t *bucket_ids;       // Node id per bucket
+    uint32_t bucket_count;
+    uint32_t bucket_cap;
+} JumpEngine;
+
+static int32_t jump_consistent_hash(uint64_t key, int32_t num_buckets) {
+    int64_t b = -1, j = 0;
+    while (j < num_buckets) {
+        b = j;
+        key = key * 2862933555777941757ull + 1;
+        j = (int64_t)((b + 1) * ((double)(1ll << 31) / (double)((key >> 33) + 1)));
+    }
+    return (int32_t)b;
+}
+
+static void *jump_engine_create(uint32_t table_size) {
+    (void)table_size;
+    return calloc(1, sizeof(JumpEngine));
+}
+
+static void jump_engine_destroy(void *state) {
+    JumpEngine *e = state;
+    free(e->bucket_ids);
+    free(e);
+}
+
+static bool jump_engine_add(void *state, uint32_t id, const char *name) {
+    (void)name;
+    JumpEngine *e = state;
+    if (e->bucket_count == e->bucket_cap) {
+        uint32_t cap = e->bucket_cap ? e->bucket_cap * 2 : 64;
+        uint32_t *ids = realloc(e->bucket_ids, cap * sizeof(uint32_t));
+        if (!ids) return false;
+        e->bucket_ids = ids;
+        e->bucket_cap = cap;
+    }
+
+    e->bucket_ids[e->bucket_count++] = id;
+    return true;
+}
+
+static bool jump_engine_remove(void *state, uint32_t id) {
+    JumpEngine *e = state;
+    for (uint32_t i = 0; i < e->bucket_count; i++) {
+        if (e->bucket_ids[i] != id) continue;
+        e->bucket_count--;
+        e->bucket_ids[i] = e->bucket_ids[e->bucket_count];
+        return true;
+    }
+    return false;
+}
+
+static void jump_engine_commit(void *state) {
+    (void)state;    // Nothing precomputed
+}
+
+static uint32_t jump_engine_lookup(const void *state, uint64_t key_hash) {
+    const JumpEngine *e = state;
+    if (e->bucket_count == 0) return UINT32_MAX;
+    return e->bucket_ids[jump_consistent_hash(key_hash, (int32_t)e->bucket_count)];
+}
+
+static size_t jump_engine_memory(const void *state) {
+    const JumpEngine *e = state;
+    return sizeof(JumpEngine) + (size_t)e->bucket_cap * sizeof(uint32_t);
+}
+
+const EngineOps jump_engine = {
+    .name = "jump",
+    .create = jump_engine_create,
+    .destroy = jump_engine_destroy,
+    .add = jump_engine_add,
+    .remove = jump_engine_remove,
+    .commit = jump_engine_commit,
+    .lookup = jump_engine_lookup,
+    .memory = jump_engine_memory,
+};
@@ -0,0 +1,51 @@
+#include "engine.h"
+#include "libmaglev.h"
+
+// Maglev through the embeddable library API, so comparisons and the
+// queueing simulation measure the same lookup path an embedder gets
+static void *maglev_engine_create(uint32_t table_size) {
+    libmaglev_t *lm;
+    if (libmaglev_create(table_size < 2 ? 0 : table_size, &lm) != LIBMAGLEV_OK) {
+        return NULL;
+    }
+    return lm;
+}
+
+static void maglev_engine_destroy(void *state) {
+    libmaglev_destroy(state);
+}
+
+static bool maglev_engine_add(void *state, uint32_t id, const char *name) {
+    return libmaglev_add_backend(state, id, name) == LIBMAGLEV_OK;
+}
+
+static bool maglev_engine_remove(void *state, uint32_t id) {
+    return libmaglev_remove_backend(state, id) == LIBMAGLEV_OK;
+}
+
+static void maglev_engine_commit(void *state) {
+    libmaglev_commit(state);
+}
+
+static uint32_t maglev_engine_lookup(const void *state, uint64_t key_hash) {
+    return libmaglev_lookup(state, key_hash);
+}
+
+static size_t maglev_engine_memory(const void *state) {
+    libmaglev_info info;
+    if (libmaglev_get_info((libmaglev_t *)state, &info) != LIBMAGLEV_OK) {
+        return 0;
+    }
+    return info.memory_bytes;
+}
+
+const EngineOps maglev_engine = {
+    .name = "maglev",
+    .create = maglev_engine_create,
+    .destroy = maglev_engine_destroy,
+    .add = maglev_engine_add,
+    .remove = maglev_engine_remove,
+    .commit = maglev_engine_commit,
+    .lookup = maglev_engine_lookup,
+    .memory = maglev_engine_memory,
+};
@@ -0,0 +1,89 @@
+#include "engine.h"
+#include "hash.h"
+#include <stdlib.h>
+
+// Rendezvous (highest random weight) hashing: no precomputed state, O(n) lookup
+typedef struct {
+    uint64_t *node_hash;
+    uint32_t *ids;
+    uint32_t node_count;
+    uint32_t node_cap;
+} RendezvousEngine;
+
+static void *rendezvous_engine_create(uint32_t table_size) {
+    (void)table_size;
+    return calloc(1, sizeof(RendezvousEngine));
+}
+
+static void rendezvous_engine_destroy(void *state) {
+    RendezvousEngine *e = state;
+    free(e->node_hash);
+    free(e->ids);
+    free(e);
+}
+
+static bool rendezvous_engine_add(void *state, uint32_t id, const char *name) {
+    RendezvousEngine *e = state;
+    if (e->node_count == e->node_cap) {
+        uint32_t cap = e->node_cap ? e->node_cap * 2 : 64;
+        uint64_t *hashes = realloc(e->node_hash, cap * sizeof(uint64_t));
+        if (!hashes) return false;
+        e->node_hash = hashes;
+        uint32_t *ids = realloc(e->ids, cap * sizeof(uint32_t));
+        if (!ids) return false;
+        e->ids = ids;
+        e->node_cap = cap;
+    }
+
+    e->node_hash[e->node_count] = hash_name64(name);
+    e->ids[e->node_count] = id;
+    e->node_count++;
+    return true;
+}
+
+static bool rendezvous_engine_remove(void *state, uint32_t id) {
+    RendezvousEngine *e = state;
+    for (uint32_t i = 0; i < e->node_count; i++) {
+        if (e->ids[i] != id) continue;
+        e->node_count--;
+        e->node_hash[i] = e->node_hash[e->node_count];
+        e->ids[i] = e->ids[e->node_count];
+        return true;
+    }
+    return false;
+}
+
+static void rendezvous_engine_commit(void *state) {
+    (void)state;    // Nothing precomputed
+}
+
+static uint32_t rendezvous_engine_lookup(const void *state, uint64_t key_hash) {
+    const RendezvousEngine *e = state;
+    uint32_t best = UINT32_MAX;
+    uint64_t best_score = 0;
+
+    for (uint32_t i = 0; i < e->node_count; i++) {
+        uint64_t score = hash_key64(key_hash ^ e->node_hash[i]);
+        if (best == UINT32_MAX || score > best_score) {
+            best_score = score;
+            best = e->ids[i];
+        }
+    }
+    return best;
+}
+
+static size_t rendezvous_engine_memory(const void *state) {
+    const RendezvousEngine *e = state;
+    return sizeof(RendezvousEngine) + (size_t)e->node_cap * (sizeof(uint64_t) + sizeof(uint32_t));
+}
+
+const EngineOps rendezvous_engine = {
+    .name = "rendezvous",
+    .create = rendezvous_engine_create,
+    .destroy = rendezvous_engine_destroy,
+    .add = rendezvous_engine_add,
+    .remove = rendezvous_engine_remove,
+    .commit = rendezvous_engine_commit,
+    .lookup = rendezvous_engine_lookup,
+    .memory = rendezvous_engine_memory,
+};
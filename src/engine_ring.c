@@ -0,0 +1,139 @@
+#include "engine.h"
+#include "hash.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define RING_VNODES 160         // Virtual nodes per backend (ketama default)
+
+typedef struct {
+    uint64_t point;
+    uint32_t id;
+} RingPoint;
+
+typedef struct {
+    uint64_t *node_hash;        // Name hash per member
+    uint32_t *ids;
+    uint32_t node_count;
+    uint32_t node_cap;
+    RingPoint *ring;            // Sorted virtual node points
+    uint64_t *points;           // Point values only, for a cache-friendly binary search
+    uint32_t *owners;
+    uint32_t ring_size;
+} RingEngine;
+
+static int compare_points(const void *a, const void *b) {
+    const RingPoint *pa = a, *pb = b;
+    if (pa->point != pb->point) return pa->point < pb->point ? -1 : 1;
+    return pa->id < pb->id ? -1 : (pa->id > pb->id);
+}
+
+static void *ring_engine_create(uint32_t table_size) {
+    (void)table_size;
+    return calloc(1, sizeof(RingEngine));
+}
+
+static void ring_engine_destroy(void *state) {
+    RingEngine *e = state;
+    free(e->node_hash);
+    free(e->ids);
+    free(e->ring);
+    free(e->points);
+    free(e->owners);
+    free(e);
+}
+
+static bool ring_engine_add(void *state, uint32_t id, const char *name) {
+    RingEngine *e = state;
+    if (e->node_count == e->node_cap) {
+        uint32_t cap = e->node_cap ? e->node_cap * 2 : 64;
+        uint64_t *hashes = realloc(e->node_hash, cap * sizeof(uint64_t));
+        if (!hashes) return false;
+        e->node_hash = hashes;
+        uint32_t *ids = realloc(e->ids, cap * sizeof(uint32_t));
+        if (!ids) return false;
+        e->ids = ids;
+        e->node_cap = cap;
+    }
+
+    e->node_hash[e->node_count] = hash_name64(name);
+    e->ids[e->node_count] = id;
+    e->node_count++;
+    return true;
+}
+
+static bool ring_engine_remove(void *state, uint32_t id) {
+    RingEngine *e = state;
+    for (uint32_t i = 0; i < e->node_count; i++) {
+        if (e->ids[i] != id) continue;
+        e->node_count--;
+        e->node_hash[i] = e->node_hash[e->node_count];
+        e->ids[i] = e->ids[e->node_count];
+        return true;
+    }
+    return false;
+}
+
+// Place RING_VNODES points per node and sort
+static void ring_engine_commit(void *state) {
+    RingEngine *e = state;
+    uint32_t size = e->node_count * RING_VNODES;
+
+    free(e->ring);
+    free(e->points);
+    free(e->owners);
+    e->ring = malloc((size ? size : 1) * sizeof(RingPoint));
+    e->points = malloc((size ? size : 1) * sizeof(uint64_t));
+    e->owners = malloc((size ? size : 1) * sizeof(uint32_t));
+    e->ring_size = 0;
+    if (!e->ring || !e->points || !e->owners) return;
+
+    for (uint32_t i = 0; i < e->node_count; i++) {
+        for (uint32_t v = 0; v < RING_VNODES; v++) {
+            RingPoint *p = &e->ring[i * RING_VNODES + v];
+            p->point = hash_key64(e->node_hash[i] + v * 0x9e3779b97f4a7c15ull);
+            p->id = e->ids[i];
+        }
+    }
+
+    qsort(e->ring, size, sizeof(RingPoint), compare_points);
+    for (uint32_t i = 0; i < size; i++) {
+        e->points[i] = e->ring[i].point;
+        e->owners[i] = e->ring[i].id;
+    }
+    e->ring_size = size;
+}
+
+// First point clockwise from the key
+static uint32_t ring_engine_lookup(const void *state, uint64_t key_hash) {
+    const RingEngine *e = state;
+    if (e->ring_size == 0) return UINT32_MAX;
+
+    uint32_t lo = 0, hi = e->ring_size;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (e->points[mid] < key_hash) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return e->owners[lo == e->ring_size ? 0 : lo];
+}
+
+static size_t ring_engine_memory(const void *state) {
+    const RingEngine *e = state;
+    // Search arrays only; the RingPoint staging array is a build artifact
+    return sizeof(RingEngine) + (size_t)e->node_cap * (sizeof(uint64_t) + sizeof(uint32_t)) +
+           (size_t)e->ring_size * (sizeof(uint64_t) + sizeof(uint32_t));
+}
+
+const EngineOps ring_engine = {
+    .name = "ring",
+    .create = ring_engine_create,
+    .destroy = ring_engine_destroy,
+    .add = ring_engine_add,
+    .remove = ring_engine_remove,
+    .commit = ring_engine_commit,
+    .lookup = ring_engine_lookup,
+    .memory = ring_engine_memory,
+};
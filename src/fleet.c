@@ -0,0 +1,572 @@
+#include "fleet.h"
+#include "hier.h"
+#include "hash.h"
+#include "keystream.h"
+#include "table_kernel.h"
+#include "preference_pool.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define FLEET_TICK_MS 1.0
+#define FLEET_TICK_CHUNK 64                 // Ticks a worker claims at a time
+#define FLEET_MAX_THREADS 64
+#define FLEET_MAX_CHANGES 1000
+#define FLEET_MAX_INSTANCES 100000
+#define FLEET_SYNTHETIC_BACKENDS 100
+#define FLEET_REPORT_ROWS 40
+#define FLEET_MAX_TABLE_BYTES (2ull << 30)
+
+typedef struct {
+    double time_ms;             // Published by the control plane
+    double last_apply_ms;       // Applied by the slowest instance
+    bool add;
+    uint32_t backend;
+    double moved;               // Share of slots whose owner changed
+} FleetChange;
+
+// Accumulated over the ticks a change is in flight (published, not yet
+// applied everywhere); overlapping changes share ticks
+typedef struct {
+    uint64_t ticks;
+    uint64_t split_ticks;           // Ticks with instances on different generations
+    uint64_t keys;
+    uint64_t split_keys;            // Keys sampled during split ticks
+    uint64_t inconsistent_keys;
+    double pairwise;                // Sum of per-key pairwise disagreement
+} FleetChangeStats;
+
+typedef struct {
+    uint32_t instances;
+    uint32_t changes;
+    uint32_t table_size;
+    uint32_t keys_per_tick;
+    uint32_t tick_count;
+    uint64_t seed;
+
+    char (*names)[MAX_NODE_NAME_LEN];   // Every backend that ever exists, by id
+    uint32_t **members;                 // Member ids of each generation
+    uint32_t *member_count;
+    CompactMaglev *tables;              // Generation g: membership after g changes
+    FleetChange *change;                // Indexed by generation, 1..changes
+    double *apply_ms;                   // [instance * (changes + 1) + g], non-decreasing in g
+    const TableKernel *kernel;
+    KeyStreamConfig keys;
+
+    uint32_t next_build;                // Claimed with atomic adds
+    uint32_t next_chunk;
+} Fleet;
+
+typedef struct {
+    Fleet *fleet;
+    FleetChangeStats *stats;    // changes + 1 entries
+    uint64_t keys;
+    uint64_t inconsistent_keys;
+    double pairwise;
+    uint64_t lookups;
+    bool ok;
+} FleetWorker;
+
+static inline uint64_t fleet_rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dull;
+}
+
+// Uniform in [0, 1), fixed per (instance, generation) whatever the thread count
+static double fleet_uniform(uint64_t seed, uint32_t instance, uint32_t generation) {
+    uint64_t h = hash_key64(seed ^ ((uint64_t)instance << 32 | generation));
+    return (h >> 11) * (1.0 / 9007199254740992.0);
+}
+
+void fleet_default_config(FleetConfig *config) {
+    config->instances = 200;
+    config->changes = 20;
+    config->table_size = DEFAULT_TABLE_SIZE;
+    config->interval_ms = 1000.0;
+    config->delay_ms = 50.0;
+    config->jitter_ms = 200.0;
+    config->keys_per_tick = 1024;
+    config->threads = 0;
+    config->seed = 0x9e3779b97f4a7c15ull;
+    config->backends = NULL;
+    config->backend_count = 0;
+}
+
+static void fleet_free(Fleet *f) {
+    if (f->tables) {
+        for (uint32_t g = 0; g <= f->changes; g++) {
+            compact_maglev_free(&f->tables[g]);
+        }
+    }
+    if (f->members) {
+        for (uint32_t g = 0; g <= f->changes; g++) {
+            free(f->members[g]);
+        }
+    }
+    free(f->tables);
+    free(f->members);
+    free(f->member_count);
+    free(f->names);
+    free(f->change);
+    free(f->apply_ms);
+}
+
+// Initial membership and a random walk of adds and removes, one member list per generation
+static bool fleet_plan_changes(Fleet *f, const FleetConfig *config, uint32_t backends, bool use_current) {
+    uint32_t capacity = backends + f->changes;
+    f->names = malloc((size_t)capacity * sizeof(*f->names));
+    f->members = calloc(f->changes + 1, sizeof(uint32_t *));
+    f->member_count = calloc(f->changes + 1, sizeof(uint32_t));
+    f->change = calloc(f->changes + 1, sizeof(FleetChange));
+    if (!f->names || !f->members || !f->member_count || !f->change) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < backends; i++) {
+        if (use_current) {
+            strcpy(f->names[i], config->backends[i]);
+        } else {
+            snprintf(f->names[i], MAX_NODE_NAME_LEN, "backend%04u", i);
+        }
+    }
+
+    uint64_t rng = config->seed ? config->seed : 1;
+    uint32_t next_id = backends;
+    for (uint32_t g = 0; g <= f->changes; g++) {
+        f->members[g] = malloc((size_t)capacity * sizeof(uint32_t));
+        if (!f->members[g]) {
+            return false;
+        }
+        if (g == 0) {
+            for (uint32_t i = 0; i < backends; i++) f->members[0][i] = i;
+            f->member_count[0] = backends;
+            continue;
+        }
+
+        uint32_t count = f->member_count[g - 1];
+        memcpy(f->members[g], f->members[g - 1], count * sizeof(uint32_t));
+
+        FleetChange *c = &f->change[g];
+        c->time_ms = g * config->interval_ms;
+        c->add = count <= 2 || (fleet_rng_next(&rng) & 1);
+        if (c->add) {
+            c->backend = next_id++;
+            snprintf(f->names[c->backend], MAX_NODE_NAME_LEN, "added%04u", c->backend - backends);
+            f->members[g][count++] = c->backend;
+        } else {
+            // Keep member order: the fill result depends on it
+            uint32_t victim = (uint32_t)(fleet_rng_next(&rng) % count);
+            c->backend = f->members[g][victim];
+            memmove(&f->members[g][victim], &f->members[g][victim + 1],
+                    (count - victim - 1) * sizeof(uint32_t));
+            count--;
+        }
+        f->member_count[g] = count;
+    }
+    return true;
+}
+
+// Every instance applies changes in order, each after delay + jitter
+static void fleet_schedule(Fleet *f, const FleetConfig *config) {
+    uint32_t stride = f->changes + 1;
+    double end_ms = 0.0;
+    for (uint32_t i = 0; i < f->instances; i++) {
+        double *apply = &f->apply_ms[(size_t)i * stride];
+        apply[0] = 0.0;
+        for (uint32_t g = 1; g <= f->changes; g++) {
+            double t = f->change[g].time_ms + config->delay_ms +
+                       config->jitter_ms * fleet_uniform(f->seed, i, g);
+            apply[g] = t > apply[g - 1] ? t : apply[g - 1];
+            if (apply[g] > f->change[g].last_apply_ms) {
+                f->change[g].last_apply_ms = apply[g];
+            }
+            if (apply[g] > end_ms) end_ms = apply[g];
+        }
+    }
+
+    // Run one interval past the last apply so the fleet is seen converged
+    f->tick_count = (uint32_t)((end_ms + config->interval_ms) / FLEET_TICK_MS) + 1;
+}
+
+static void *fleet_build_worker(void *arg) {
+    FleetWorker *w = arg;
+    Fleet *f = w->fleet;
+    w->ok = true;
+    for (;;) {
+        uint32_t g = __atomic_fetch_add(&f->next_build, 1, __ATOMIC_RELAXED);
+        if (g > f->changes) {
+            return NULL;
+        }
+
+        CompactMaglev *t = &f->tables[g];
+        uint32_t count = f->member_count[g];
+        if (!compact_maglev_init(t, f->table_size, count ? count : 1)) {
+            w->ok = false;
+            continue;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t id = f->members[g][i];
+            compact_maglev_add(t, id, f->names[id]);
+        }
+        if (!compact_maglev_build(t)) {
+            w->ok = false;
+        }
+    }
+}
+
+// Generation of instance i at time_ms: changes applied so far
+static uint32_t fleet_generation_at(const Fleet *f, uint32_t i, double time_ms) {
+    const double *apply = &f->apply_ms[(size_t)i * (f->changes + 1)];
+    uint32_t lo = 0, hi = f->changes;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if (apply[mid] <= time_ms) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+// Run one tick's keys through every generation some instance is on
+static void fleet_sample_tick(FleetWorker *w, KeyStream *ks, uint64_t tick, const uint32_t *live,
+                              const double *share, uint32_t live_count, uint64_t *keys,
+                              uint32_t *slots, uint64_t *inconsistent, double *pairwise) {
+    Fleet *f = w->fleet;
+    ks->rng_state = hash_key64(f->seed + tick) | 1;
+    keystream_fill(ks, keys, f->keys_per_tick);
+    f->kernel->slots(keys, slots, f->keys_per_tick, f->table_size);
+
+    uint32_t owners[FLEET_MAX_CHANGES + 1];
+    *inconsistent = 0;
+    *pairwise = 0.0;
+    for (uint32_t k = 0; k < f->keys_per_tick; k++) {
+        for (uint32_t l = 0; l < live_count; l++) {
+            owners[l] = f->tables[live[l]].table[slots[k]];
+        }
+
+        // Share of instances per distinct owner; two random instances agree
+        // with probability sum(share^2)
+        double agree = 0.0;
+        bool split = false;
+        for (uint32_t l = 0; l < live_count; l++) {
+            bool seen = false;
+            double group = share[l];
+            for (uint32_t m = 0; m < l && !seen; m++) {
+                seen = owners[m] == owners[l];
+            }
+            if (seen) continue;
+            for (uint32_t m = l + 1; m < live_count; m++) {
+                if (owners[m] == owners[l]) group += share[m];
+            }
+            split = split || group < 1.0 - 1e-12;
+            agree += group * group;
+        }
+        *inconsistent += split;
+        *pairwise += 1.0 - agree;
+    }
+    w->lookups += (uint64_t)f->keys_per_tick * live_count;
+}
+
+static void *fleet_sim_worker(void *arg) {
+    FleetWorker *w = arg;
+    Fleet *f = w->fleet;
+    KeyStream ks;
+    uint32_t *gen = malloc(f->instances * sizeof(uint32_t));
+    uint32_t *counts = calloc(f->changes + 1, sizeof(uint32_t));
+    uint32_t *live = malloc((f->changes + 1) * sizeof(uint32_t));
+    double *share = malloc((f->changes + 1) * sizeof(double));
+    uint64_t *keys = malloc(f->keys_per_tick * sizeof(uint64_t));
+    uint32_t *slots = malloc(f->keys_per_tick * sizeof(uint32_t));
+    w->ok = gen && counts && live && share && keys && slots && keystream_init(&ks, &f->keys);
+    if (!w->ok) {
+        free(gen);
+        free(counts);
+        free(live);
+        free(share);
+        free(keys);
+        free(slots);
+        return NULL;
+    }
+
+    uint32_t chunks = (f->tick_count + FLEET_TICK_CHUNK - 1) / FLEET_TICK_CHUNK;
+    for (;;) {
+        uint32_t chunk = __atomic_fetch_add(&f->next_chunk, 1, __ATOMIC_RELAXED);
+        if (chunk >= chunks) {
+            break;
+        }
+
+        uint32_t first = chunk * FLEET_TICK_CHUNK;
+        uint32_t last = first + FLEET_TICK_CHUNK < f->tick_count ? first + FLEET_TICK_CHUNK : f->tick_count;
+        double start_ms = first * FLEET_TICK_MS;
+        for (uint32_t i = 0; i < f->instances; i++) {
+            gen[i] = fleet_generation_at(f, i, start_ms);
+        }
+        uint32_t published = 0;
+
+        for (uint32_t tick = first; tick < last; tick++) {
+            double now = tick * FLEET_TICK_MS;
+            while (published < f->changes && f->change[published + 1].time_ms <= now) {
+                published++;
+            }
+
+            // Apply whatever is due, instance by instance
+            uint32_t gmin = UINT32_MAX, gmax = 0;
+            for (uint32_t i = 0; i < f->instances; i++) {
+                const double *apply = &f->apply_ms[(size_t)i * (f->changes + 1)];
+                while (gen[i] < f->changes && apply[gen[i] + 1] <= now) {
+                    gen[i]++;
+                }
+                if (gen[i] < gmin) gmin = gen[i];
+                if (gen[i] > gmax) gmax = gen[i];
+            }
+
+            uint64_t inconsistent = 0;
+            double pairwise = 0.0;
+            if (gmin != gmax) {
+                for (uint32_t i = 0; i < f->instances; i++) {
+                    counts[gen[i]]++;
+                }
+                uint32_t live_count = 0;
+                for (uint32_t g = gmin; g <= gmax; g++) {
+                    if (counts[g] == 0) continue;
+                    live[live_count] = g;
+                    share[live_count] = (double)counts[g] / f->instances;
+                    live_count++;
+                    counts[g] = 0;
+                }
+                fleet_sample_tick(w, &ks, tick, live, share, live_count, keys, slots,
+                                  &inconsistent, &pairwise);
+            }
+
+            w->keys += f->keys_per_tick;
+            w->inconsistent_keys += inconsistent;
+            w->pairwise += pairwise;
+
+            // Changes in flight: published, not yet applied by every instance
+            bool split = gmin != gmax;
+            for (uint32_t g = gmin + 1; g <= published; g++) {
+                FleetChangeStats *s = &w->stats[g];
+                s->ticks++;
+                s->split_ticks += split;
+                s->keys += f->keys_per_tick;
+                s->split_keys += split ? f->keys_per_tick : 0;
+                s->inconsistent_keys += inconsistent;
+                s->pairwise += pairwise;
+            }
+        }
+    }
+
+    keystream_free(&ks);
+    free(gen);
+    free(counts);
+    free(live);
+    free(share);
+    free(keys);
+    free(slots);
+    return NULL;
+}
+
+// Start count workers on fn (the caller runs the first); false if any failed
+static bool fleet_run_workers(FleetWorker *workers, uint32_t count, void *(*fn)(void *)) {
+    pthread_t tids[FLEET_MAX_THREADS];
+    for (uint32_t t = 1; t < count; t++) {
+        if (pthread_create(&tids[t], NULL, fn, &workers[t]) != 0) {
+            tids[t] = 0;
+        }
+    }
+    fn(&workers[0]);
+    bool ok = workers[0].ok;
+    for (uint32_t t = 1; t < count; t++) {
+        if (tids[t]) {
+            pthread_join(tids[t], NULL);
+            ok = ok && workers[t].ok;
+        }
+    }
+    return ok;
+}
+
+static double share_of_slots_moved(const CompactMaglev *before, const CompactMaglev *after) {
+    uint32_t moved = 0;
+    for (uint32_t s = 0; s < after->table_size; s++) {
+        moved += before->table[s] != after->table[s];
+    }
+    return (double)moved / after->table_size;
+}
+
+static void fleet_report(const Fleet *f, const FleetConfig *config, const FleetChangeStats *stats,
+                         const FleetWorker *total) {
+    printf("\n%6s %9s %-22s %9s %8s %8s %8s %9s %7s\n", "change", "time_ms", "event",
+           "window_ms", "split_ms", "split%", "window%", "pairwise%", "moved%");
+
+    double window_sum = 0.0, window_max = 0.0, split_sum = 0.0, split_max = 0.0;
+    for (uint32_t g = 1; g <= f->changes; g++) {
+        const FleetChange *c = &f->change[g];
+        const FleetChangeStats *s = &stats[g];
+        double window = c->last_apply_ms - c->time_ms;
+        double split = s->split_ticks * FLEET_TICK_MS;
+        window_sum += window;
+        split_sum += split;
+        if (window > window_max) window_max = window;
+        if (split > split_max) split_max = split;
+
+        if (g <= FLEET_REPORT_ROWS) {
+            char event[64];
+            snprintf(event, sizeof(event), "%s %.18s", c->add ? "add" : "del", f->names[c->backend]);
+            printf("%6u %9.0f %-22s %9.1f %8.0f %8.3f %8.3f %9.3f %7.3f\n", g, c->time_ms, event,
+                   window, split,
+                   s->split_keys ? 100.0 * s->inconsistent_keys / s->split_keys : 0.0,
+                   s->keys ? 100.0 * s->inconsistent_keys / s->keys : 0.0,
+                   s->keys ? 100.0 * s->pairwise / s->keys : 0.0, 100.0 * c->moved);
+        }
+    }
+    if (f->changes > FLEET_REPORT_ROWS) {
+        printf("  ... %u more changes\n", f->changes - FLEET_REPORT_ROWS);
+    }
+
+    printf("\nPropagation window (publish to last instance): mean %.1f ms, max %.1f ms\n",
+           window_sum / f->changes, window_max);
+    printf("Fleet split per change (flows can be inconsistent): mean %.1f ms, max %.1f ms\n",
+           split_sum / f->changes, split_max);
+    printf("  split%%: inconsistent keys while split; window%%: over the whole window; pairwise%%: two\n"
+           "  random instances disagree; moved%%: slots the change reassigned\n");
+    printf("Flow inconsistency rate over %.1f s: %.4f%% of %llu sampled keys (pairwise %.4f%%)\n",
+           f->tick_count * FLEET_TICK_MS / 1e3,
+           total->keys ? 100.0 * total->inconsistent_keys / total->keys : 0.0,
+           (unsigned long long)total->keys,
+           total->keys ? 100.0 * total->pairwise / total->keys : 0.0);
+    if (config->interval_ms < config->delay_ms + config->jitter_ms) {
+        printf("  Changes arrive faster than they propagate: windows overlap and share ticks\n");
+    }
+}
+
+bool fleet_run(const FleetConfig *config) {
+    uint32_t backends = config->backends ? config->backend_count : 0;
+    bool use_current = backends >= 2;
+    if (!use_current) {
+        backends = FLEET_SYNTHETIC_BACKENDS;
+    }
+
+    if (config->instances < 2 || config->instances > FLEET_MAX_INSTANCES) {
+        printf("Error: Instance count must be between 2 and %d\n", FLEET_MAX_INSTANCES);
+        return false;
+    }
+    if (config->changes == 0 || config->changes > FLEET_MAX_CHANGES) {
+        printf("Error: Change count must be between 1 and %d\n", FLEET_MAX_CHANGES);
+        return false;
+    }
+    uint64_t table_bytes = (uint64_t)(config->changes + 1) * config->table_size * sizeof(uint32_t);
+    if (table_bytes > FLEET_MAX_TABLE_BYTES) {
+        printf("Error: %u generations of %u slots need %.1f GiB (limit %.0f GiB), use fewer changes\n",
+               config->changes + 1, config->table_size, table_bytes / 1073741824.0,
+               FLEET_MAX_TABLE_BYTES / 1073741824.0);
+        return false;
+    }
+
+    Fleet f;
+    memset(&f, 0, sizeof(f));
+    f.instances = config->instances;
+    f.changes = config->changes;
+    f.table_size = config->table_size;
+    f.keys_per_tick = config->keys_per_tick;
+    f.seed = config->seed;
+    f.kernel = table_kernel_select(config->table_size);
+    keystream_default_config(&f.keys, KEYDIST_UNIFORM);
+    f.keys.seed = config->seed;
+
+    uint32_t threads = config->threads ? config->threads : preference_pool_default_threads();
+    if (threads > FLEET_MAX_THREADS) threads = FLEET_MAX_THREADS;
+
+    FleetWorker *workers = calloc(threads, sizeof(FleetWorker));
+    FleetChangeStats *stats = calloc((size_t)threads * (config->changes + 1), sizeof(FleetChangeStats));
+    f.apply_ms = malloc((size_t)config->instances * (config->changes + 1) * sizeof(double));
+    f.tables = calloc(config->changes + 1, sizeof(CompactMaglev));
+    bool ok = workers && stats && f.apply_ms && f.tables &&
+              fleet_plan_changes(&f, config, backends, use_current);
+    if (!ok) {
+        printf("Error: Memory allocation failed\n");
+        fleet_free(&f);
+        free(workers);
+        free(stats);
+        return false;
+    }
+
+    printf("Fleet: %u instances, %u %sbackends, table %u, %u changes every %.0f ms\n",
+           f.instances, backends, use_current ? "current " : "synthetic ", f.table_size,
+           f.changes, config->interval_ms);
+    printf("  Propagation: %.1f ms + up to %.1f ms jitter per instance; %u keys per %.0f ms tick "
+           "(uniform, %u flows); %u thread%s\n",
+           config->delay_ms, config->jitter_ms, f.keys_per_tick, FLEET_TICK_MS,
+           f.keys.flow_count, threads, threads == 1 ? "" : "s");
+
+    for (uint32_t t = 0; t < threads; t++) {
+        workers[t].fleet = &f;
+        workers[t].stats = &stats[(size_t)t * (f.changes + 1)];
+    }
+
+    // Every generation's table, built once and shared by the instances on it
+    uint64_t build_start = timer_now_ns();
+    if (!fleet_run_workers(workers, threads, fleet_build_worker)) {
+        printf("Error: Memory allocation failed\n");
+        fleet_free(&f);
+        free(workers);
+        free(stats);
+        return false;
+    }
+    for (uint32_t g = 1; g <= f.changes; g++) {
+        f.change[g].moved = share_of_slots_moved(&f.tables[g - 1], &f.tables[g]);
+    }
+    double build_ms = (timer_now_ns() - build_start) / 1e6;
+
+    fleet_schedule(&f, config);
+
+    uint64_t sim_start = timer_now_ns();
+    ok = fleet_run_workers(workers, threads, fleet_sim_worker);
+    double sim_ms = (timer_now_ns() - sim_start) / 1e6;
+    if (!ok) {
+        printf("Error: Failed to start the key stream\n");
+        fleet_free(&f);
+        free(workers);
+        free(stats);
+        return false;
+    }
+
+    // Merge the per-worker statistics into worker 0
+    FleetWorker *total = &workers[0];
+    for (uint32_t t = 1; t < threads; t++) {
+        total->keys += workers[t].keys;
+        total->inconsistent_keys += workers[t].inconsistent_keys;
+        total->pairwise += workers[t].pairwise;
+        total->lookups += workers[t].lookups;
+        for (uint32_t g = 1; g <= f.changes; g++) {
+            FleetChangeStats *into = &stats[g];
+            const FleetChangeStats *from = &workers[t].stats[g];
+            into->ticks += from->ticks;
+            into->split_ticks += from->split_ticks;
+            into->keys += from->keys;
+            into->split_keys += from->split_keys;
+            into->inconsistent_keys += from->inconsistent_keys;
+            into->pairwise += from->pairwise;
+        }
+    }
+
+    double table_mib = (double)f.table_size * sizeof(uint32_t) / 1048576.0;
+    printf("  Tables: %u generations x %.2f MiB shared by all instances (%.1f MiB; a private copy each: %.1f MiB)\n",
+           f.changes + 1, table_mib, (f.changes + 1) * table_mib, f.instances * table_mib);
+    printf("  Built in %.2f ms; simulated %u ticks in %.2f ms (%.1f M lookups)\n",
+           build_ms, f.tick_count, sim_ms, total->lookups / 1e6);
+
+    fleet_report(&f, config, stats, total);
+
+    fleet_free(&f);
+    free(workers);
+    free(stats);
+    return true;
+}
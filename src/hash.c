@@ -1,5 +1,4 @@
 #include "hash.h"
-#include <stdio.h>
 
 // DJB2 hash algorithm
 uint32_t djb2_hash(const char *str) {
@@ -53,6 +52,27 @@ uint32_t hash_skip(const char *str, uint32_t table_size) {
     uint32_t h1 = sdbm_hash(str);
     uint32_t h2 = fnv1a_hash(str);
     uint32_t combined = h1 ^ (h2 << 8) ^ (h2 >> 24);
+
+    // Power-of-two tables need an odd skip, coprime with the size
+    if ((table_size & (table_size - 1)) == 0) {
+        return ((combined & ((table_size >> 1) - 1)) << 1) | 1;
+    }
+
     uint32_t skip = combined % (table_size - 1) + 1;
     return skip;
+}
+
+// Flow key hash (SplitMix64 finalizer, keeps sequential flow IDs well spread)
+uint64_t hash_key64(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ull;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebull;
+    key ^= key >> 31;
+    return key;
+}
+
+// 64-bit name hash (combines DJB2 and FNV-1a, then finalizes)
+uint64_t hash_name64(const char *str) {
+    return hash_key64(((uint64_t)djb2_hash(str) << 32) | fnv1a_hash(str));
 }
\ No newline at end of file
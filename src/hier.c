@@ -0,0 +1,345 @@
+#include "hier.h"
+#include "maglev_core.h"
+#include "hash.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define HIER_LOOKUPS 20000000ull   // Timed lookups per layout
+#define HIER_NAME_LEN 64
+
+bool compact_maglev_init(CompactMaglev *t, uint32_t table_size, uint32_t capacity) {
+    memset(t, 0, sizeof(*t));
+    t->table = malloc((size_t)table_size * sizeof(uint32_t));
+    t->ids = malloc((size_t)capacity * sizeof(uint32_t));
+    t->offset = malloc((size_t)capacity * sizeof(uint32_t));
+    t->skip = malloc((size_t)capacity * sizeof(uint32_t));
+    if (!t->table || !t->ids || !t->offset || !t->skip) {
+        compact_maglev_free(t);
+        return false;
+    }
+
+    memset(t->table, 0xff, (size_t)table_size * sizeof(uint32_t));
+    t->table_size = table_size;
+    t->capacity = capacity;
+    return true;
+}
+
+void compact_maglev_free(CompactMaglev *t) {
+    free(t->table);
+    free(t->ids);
+    free(t->offset);
+    free(t->skip);
+    memset(t, 0, sizeof(*t));
+}
+
+bool compact_maglev_add(CompactMaglev *t, uint32_t id, const char *name) {
+    if (t->count >= t->capacity) {
+        return false;
+    }
+
+    t->ids[t->count] = id;
+    t->offset[t->count] = hash_offset(name, t->table_size);
+    t->skip[t->count] = hash_skip(name, t->table_size);
+    t->count++;
+    return true;
+}
+
+bool compact_maglev_remove(CompactMaglev *t, uint32_t id) {
+    for (uint32_t i = 0; i < t->count; i++) {
+        if (t->ids[i] != id) continue;
+
+        // Keep member order: the fill result depends on it
+        uint32_t tail = t->count - i - 1;
+        memmove(&t->ids[i], &t->ids[i + 1], tail * sizeof(uint32_t));
+        memmove(&t->offset[i], &t->offset[i + 1], tail * sizeof(uint32_t));
+        memmove(&t->skip[i], &t->skip[i + 1], tail * sizeof(uint32_t));
+        t->count--;
+        return true;
+    }
+    return false;
+}
+
+bool compact_maglev_build(CompactMaglev *t) {
+    uint32_t *cursor = malloc((t->count ? t->count : 1) * sizeof(uint32_t));
+    if (!cursor) {
+        return false;
+    }
+
+    maglev_fill_compact(t->table, t->table_size, t->offset, t->skip, t->count, cursor);
+    free(cursor);
+
+    // Store ids directly so lookup is a single read
+    for (uint32_t i = 0; i < t->table_size; i++) {
+        if (t->table[i] != UINT32_MAX) {
+            t->table[i] = t->ids[t->table[i]];
+        }
+    }
+    return true;
+}
+
+size_t compact_maglev_memory(const CompactMaglev *t) {
+    return sizeof(*t) + (size_t)t->table_size * sizeof(uint32_t) + (size_t)t->capacity * 3 * sizeof(uint32_t);
+}
+
+bool hier_init(HierMaglev *h, uint32_t pools, uint32_t backends_per_pool,
+               uint32_t pool_table_size, uint32_t top_table_size) {
+    memset(h, 0, sizeof(*h));
+    h->pools = calloc(pools, sizeof(CompactMaglev));
+    if (!h->pools || !compact_maglev_init(&h->top, top_table_size, pools)) {
+        free(h->pools);
+        h->pools = NULL;
+        return false;
+    }
+
+    char name[HIER_NAME_LEN];
+    for (uint32_t p = 0; p < pools; p++) {
+        snprintf(name, sizeof(name), "pool-%05u", p);
+        compact_maglev_add(&h->top, p, name);
+
+        CompactMaglev *pool = &h->pools[p];
+        if (!compact_maglev_init(pool, pool_table_size, backends_per_pool)) {
+            hier_free(h);
+            return false;
+        }
+        h->pool_count++;
+
+        for (uint32_t b = 0; b < backends_per_pool; b++) {
+            snprintf(name, sizeof(name), "pool-%05u/backend-%05u", p, b);
+            compact_maglev_add(pool, p * backends_per_pool + b, name);
+        }
+        if (!compact_maglev_build(pool)) {
+            hier_free(h);
+            return false;
+        }
+    }
+
+    if (!compact_maglev_build(&h->top)) {
+        hier_free(h);
+        return false;
+    }
+    return true;
+}
+
+void hier_free(HierMaglev *h) {
+    if (h->pools) {
+        for (uint32_t p = 0; p < h->pool_count; p++) {
+            compact_maglev_free(&h->pools[p]);
+        }
+        free(h->pools);
+    }
+    compact_maglev_free(&h->top);
+    memset(h, 0, sizeof(*h));
+}
+
+size_t hier_memory(const HierMaglev *h) {
+    size_t total = sizeof(*h) + compact_maglev_memory(&h->top);
+    for (uint32_t p = 0; p < h->pool_count; p++) {
+        total += compact_maglev_memory(&h->pools[p]);
+    }
+    return total;
+}
+
+bool hier_remove_backend(HierMaglev *h, uint32_t pool, uint32_t id) {
+    if (pool >= h->pool_count || !compact_maglev_remove(&h->pools[pool], id)) {
+        return false;
+    }
+    return compact_maglev_build(&h->pools[pool]);
+}
+
+// Worst backend share relative to the mean, from slot counts (no sampling)
+static double hier_max_share(const HierMaglev *h, uint32_t backends, uint32_t *counts) {
+    uint32_t *pool_slots = counts;
+    memset(pool_slots, 0, h->pool_count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < h->top.table_size; i++) {
+        pool_slots[h->top.table[i]]++;
+    }
+
+    double max_share = 0.0;
+    uint32_t *backend_slots = counts + h->pool_count;
+    for (uint32_t p = 0; p < h->pool_count; p++) {
+        const CompactMaglev *pool = &h->pools[p];
+        for (uint32_t i = 0; i < pool->count; i++) {
+            backend_slots[pool->ids[i]] = 0;
+        }
+        for (uint32_t i = 0; i < pool->table_size; i++) {
+            backend_slots[pool->table[i]]++;
+        }
+
+        double pool_share = (double)pool_slots[p] / h->top.table_size;
+        for (uint32_t i = 0; i < pool->count; i++) {
+            double share = pool_share * backend_slots[pool->ids[i]] / pool->table_size;
+            if (share > max_share) max_share = share;
+        }
+    }
+    return max_share * backends;
+}
+
+static double flat_max_share(const CompactMaglev *flat, uint32_t *counts) {
+    memset(counts, 0, flat->count * sizeof(uint32_t));
+    for (uint32_t i = 0; i < flat->table_size; i++) {
+        counts[flat->table[i]]++;
+    }
+
+    uint32_t max_slots = 0;
+    for (uint32_t i = 0; i < flat->count; i++) {
+        if (counts[i] > max_slots) max_slots = counts[i];
+    }
+    return (double)max_slots * flat->count / flat->table_size;
+}
+
+typedef struct {
+    double build_ms;
+    double change_ms;
+    double memory_mib;
+    double lookup_ns;
+    double max_mean;
+    double moved;
+} LayoutResult;
+
+static void print_result(const char *name, const LayoutResult *r) {
+    printf("%-13s %10.2f %10.3f %11.2f %10.2f %9.3f %8.4f\n",
+           name, r->build_ms, r->change_ms, r->memory_mib, r->lookup_ns, r->max_mean, r->moved);
+}
+
+bool hier_compare(const HierConfig *config) {
+    uint32_t pools = config->pools;
+    uint32_t per_pool = config->backends_per_pool;
+    uint64_t total64 = (uint64_t)pools * per_pool;
+    if (pools == 0 || per_pool == 0 || config->keys == 0 || total64 > 100000000ull) {
+        printf("Error: Need at least one pool, one backend per pool and one key (at most 100M backends)\n");
+        return false;
+    }
+    uint32_t backends = (uint32_t)total64;
+
+    uint64_t pool_request = config->pool_table_size ? config->pool_table_size
+                          : (per_pool < 10 ? 101 : (uint64_t)per_pool * 10);
+    uint64_t top_request = config->top_table_size ? config->top_table_size
+                         : (pools < 2 ? 101 : (uint64_t)pools * 100);
+    uint64_t total_slots = top_request + (uint64_t)pools * pool_request;
+    if (total_slots > (1ull << 31)) {
+        printf("Error: Total table size %llu is too large\n", (unsigned long long)total_slots);
+        return false;
+    }
+    uint32_t pool_size = next_prime((uint32_t)pool_request);
+    uint32_t top_size = next_prime((uint32_t)top_request);
+    total_slots = (uint64_t)top_size + (uint64_t)pools * pool_size;
+    uint32_t flat_size = next_prime((uint32_t)total_slots);
+
+    uint64_t *hashes = malloc(config->keys * sizeof(uint64_t));
+    uint32_t *hier_before = malloc(config->keys * sizeof(uint32_t));
+    uint32_t *flat_before = malloc(config->keys * sizeof(uint32_t));
+    uint32_t *counts = malloc(((size_t)backends + pools) * sizeof(uint32_t));
+    HierMaglev hier;
+    CompactMaglev flat;
+    bool hier_ok = false, flat_ok = false, ok = false;
+
+    if (!hashes || !hier_before || !flat_before || !counts) {
+        printf("Error: Memory allocation failed\n");
+        goto out;
+    }
+
+    printf("Hierarchical vs flat Maglev: %u backends (%u pools x %u), %llu sample keys\n",
+           backends, pools, per_pool, (unsigned long long)config->keys);
+    printf("  hierarchical: top table %u, pool tables %u (%llu slots in total)\n",
+           top_size, pool_size, (unsigned long long)total_slots);
+    printf("  flat:         one table of %u slots\n\n", flat_size);
+
+    LayoutResult hr, fr;
+    memset(&hr, 0, sizeof(hr));
+    memset(&fr, 0, sizeof(fr));
+
+    // Build both layouts over the same backend names
+    uint64_t start = timer_now_ns();
+    hier_ok = hier_init(&hier, pools, per_pool, pool_size, top_size);
+    hr.build_ms = (timer_now_ns() - start) / 1e6;
+
+    start = timer_now_ns();
+    flat_ok = compact_maglev_init(&flat, flat_size, backends);
+    if (flat_ok) {
+        char name[HIER_NAME_LEN];
+        for (uint32_t p = 0; p < pools; p++) {
+            for (uint32_t b = 0; b < per_pool; b++) {
+                snprintf(name, sizeof(name), "pool-%05u/backend-%05u", p, b);
+                compact_maglev_add(&flat, p * per_pool + b, name);
+            }
+        }
+    }
+    bool built = flat_ok && compact_maglev_build(&flat);
+    fr.build_ms = (timer_now_ns() - start) / 1e6;
+
+    if (!hier_ok || !built) {
+        printf("Error: Memory allocation failed\n");
+        goto out;
+    }
+
+    hr.memory_mib = hier_memory(&hier) / (1024.0 * 1024.0);
+    fr.memory_mib = compact_maglev_memory(&flat) / (1024.0 * 1024.0);
+    hr.max_mean = hier_max_share(&hier, backends, counts);
+    fr.max_mean = flat_max_share(&flat, counts);
+
+    for (uint64_t k = 0; k < config->keys; k++) {
+        hashes[k] = hash_key64(k);
+        hier_before[k] = hier_lookup(&hier, hashes[k]);
+        flat_before[k] = compact_maglev_lookup(&flat, hashes[k]);
+    }
+
+    // End-to-end lookup cost, cycling through the sample keys
+    uint64_t checksum = 0;
+    start = timer_now_ns();
+    for (uint64_t i = 0, k = 0; i < HIER_LOOKUPS; i++) {
+        checksum += hier_lookup(&hier, hashes[k]);
+        if (++k == config->keys) k = 0;
+    }
+    hr.lookup_ns = (double)(timer_now_ns() - start) / HIER_LOOKUPS;
+
+    start = timer_now_ns();
+    for (uint64_t i = 0, k = 0; i < HIER_LOOKUPS; i++) {
+        checksum += compact_maglev_lookup(&flat, hashes[k]);
+        if (++k == config->keys) k = 0;
+    }
+    fr.lookup_ns = (double)(timer_now_ns() - start) / HIER_LOOKUPS;
+
+    // One backend leaves: the hierarchy rebuilds its pool, the flat table everything
+    uint32_t victim_pool = pools / 2;
+    uint32_t victim = victim_pool * per_pool + per_pool / 2;
+
+    start = timer_now_ns();
+    bool changed = hier_remove_backend(&hier, victim_pool, victim);
+    hr.change_ms = (timer_now_ns() - start) / 1e6;
+
+    start = timer_now_ns();
+    changed = compact_maglev_remove(&flat, victim) && compact_maglev_build(&flat) && changed;
+    fr.change_ms = (timer_now_ns() - start) / 1e6;
+    if (!changed) {
+        printf("Error: Memory allocation failed\n");
+        goto out;
+    }
+
+    uint64_t hier_moved = 0, flat_moved = 0;
+    for (uint64_t k = 0; k < config->keys; k++) {
+        hier_moved += hier_lookup(&hier, hashes[k]) != hier_before[k];
+        flat_moved += compact_maglev_lookup(&flat, hashes[k]) != flat_before[k];
+    }
+    hr.moved = 100.0 * hier_moved / config->keys;
+    fr.moved = 100.0 * flat_moved / config->keys;
+
+    printf("layout          build_ms  change_ms  memory_MiB  lookup_ns  max/mean  moved%%\n");
+    print_result("hierarchical", &hr);
+    print_result("flat", &fr);
+    printf("\n  change: remove one backend and rebuild (ideal moved share %.4f%%)\n", 100.0 / backends);
+    printf("  Precomputed preference lists, as the simulator keeps them, would add %.1f GiB to the flat table\n",
+           (double)flat_size * sizeof(uint32_t) * backends / (1024.0 * 1024.0 * 1024.0));
+    printf("  (checksum %llx)\n", (unsigned long long)checksum);
+    ok = true;
+
+out:
+    if (hier_ok) hier_free(&hier);
+    if (flat_ok) compact_maglev_free(&flat);
+    free(hashes);
+    free(hier_before);
+    free(flat_before);
+    free(counts);
+    return ok;
+}
@@ -0,0 +1,208 @@
+#include "keystream.h"
+#include "hash.h"
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// xorshift64* generator - one multiply per key, good enough for traffic shaping
+static inline uint64_t rng_next(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dull;
+}
+
+// Map a 32-bit random value onto [0, range) without division
+static inline uint32_t fast_range(uint32_t r, uint32_t range) {
+    return (uint32_t)(((uint64_t)r * range) >> 32);
+}
+
+// Scale a probability in [0, 1] to a 32-bit threshold
+static uint32_t probability_threshold(double p) {
+    if (p <= 0.0) return 0;
+    if (p >= 1.0) return UINT32_MAX;
+    return (uint32_t)(p * 4294967296.0);
+}
+
+bool keystream_parse_distribution(const char *name, KeyDistribution *dist) {
+    if (strcmp(name, "uniform") == 0) {
+        *dist = KEYDIST_UNIFORM;
+    } else if (strcmp(name, "zipf") == 0) {
+        *dist = KEYDIST_ZIPF;
+    } else if (strcmp(name, "hotspot") == 0) {
+        *dist = KEYDIST_HOTSPOT;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char *keystream_distribution_name(KeyDistribution dist) {
+    switch (dist) {
+        case KEYDIST_UNIFORM: return "uniform";
+        case KEYDIST_ZIPF:    return "zipf";
+        case KEYDIST_HOTSPOT: return "hotspot";
+    }
+    return "?";
+}
+
+void keystream_default_config(KeyStreamConfig *config, KeyDistribution dist) {
+    config->dist = dist;
+    config->flow_count = 1000000;
+    config->zipf_s = 1.0;
+    config->hot_key_share = 0.01;
+    config->hot_traffic_share = 0.9;
+    config->seed = 0x9e3779b97f4a7c15ull;
+}
+
+// Build Walker/Vose alias table so each Zipf sample costs one RNG call and one table read
+static bool build_zipf_alias(KeyStream *ks) {
+    uint32_t n = ks->config.flow_count;
+    double *weights = malloc(n * sizeof(double));
+    uint32_t *small = malloc(n * sizeof(uint32_t));
+    uint32_t *large = malloc(n * sizeof(uint32_t));
+    ks->alias_prob = malloc(n * sizeof(uint32_t));
+    ks->alias_index = malloc(n * sizeof(uint32_t));
+
+    if (!weights || !small || !large || !ks->alias_prob || !ks->alias_index) {
+        free(weights);
+        free(small);
+        free(large);
+        return false;
+    }
+
+    double total = 0.0;
+    for (uint32_t i = 0; i < n; i++) {
+        weights[i] = 1.0 / pow((double)(i + 1), ks->config.zipf_s);
+        total += weights[i];
+    }
+
+    // Scale so the average bucket weight is 1
+    uint32_t small_count = 0, large_count = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        weights[i] = weights[i] * n / total;
+        if (weights[i] < 1.0) {
+            small[small_count++] = i;
+        } else {
+            large[large_count++] = i;
+        }
+    }
+
+    while (small_count > 0 && large_count > 0) {
+        uint32_t s = small[--small_count];
+        uint32_t l = large[large_count - 1];
+
+        ks->alias_prob[s] = probability_threshold(weights[s]);
+        ks->alias_index[s] = l;
+
+        weights[l] -= 1.0 - weights[s];
+        if (weights[l] < 1.0) {
+            large_count--;
+            small[small_count++] = l;
+        }
+    }
+
+    // Leftovers are full buckets (rounding residue)
+    while (large_count > 0) {
+        uint32_t l = large[--large_count];
+        ks->alias_prob[l] = UINT32_MAX;
+        ks->alias_index[l] = l;
+    }
+    while (small_count > 0) {
+        uint32_t s = small[--small_count];
+        ks->alias_prob[s] = UINT32_MAX;
+        ks->alias_index[s] = s;
+    }
+
+    free(weights);
+    free(small);
+    free(large);
+    return true;
+}
+
+bool keystream_init(KeyStream *ks, const KeyStreamConfig *config) {
+    memset(ks, 0, sizeof(*ks));
+    ks->config = *config;
+
+    if (ks->config.flow_count == 0) {
+        ks->config.flow_count = 1;
+    }
+
+    // xorshift state must never be zero
+    ks->rng_state = hash_key64(config->seed) | 1;
+
+    if (config->dist == KEYDIST_ZIPF) {
+        if (!build_zipf_alias(ks)) {
+            keystream_free(ks);
+            return false;
+        }
+    } else if (config->dist == KEYDIST_HOTSPOT) {
+        double hot = config->hot_key_share * ks->config.flow_count;
+        ks->hot_count = (hot < 1.0) ? 1 : (uint32_t)hot;
+        if (ks->hot_count >= ks->config.flow_count) {
+            ks->hot_count = ks->config.flow_count - 1;
+        }
+        ks->hot_threshold = probability_threshold(config->hot_traffic_share);
+    }
+
+    return true;
+}
+
+void keystream_free(KeyStream *ks) {
+    if (!ks->borrowed) {
+        free(ks->alias_prob);
+        free(ks->alias_index);
+    }
+    ks->alias_prob = NULL;
+    ks->alias_index = NULL;
+}
+
+void keystream_fork(KeyStream *ks, const KeyStream *base, uint32_t stream_id) {
+    *ks = *base;
+    ks->borrowed = true;
+    ks->rng_state ^= (uint64_t)(stream_id + 1) * 0xd1b54a32d192ed03ull;
+    if (ks->rng_state == 0) ks->rng_state = 1;
+}
+
+// Generate the next batch of flow key hashes.
+// Ranks are hashed so that popular flows land on random table slots.
+void keystream_fill(KeyStream *ks, uint64_t *keys, uint32_t count) {
+    uint64_t state = ks->rng_state;
+    uint32_t n = ks->config.flow_count;
+    uint64_t salt = ks->config.seed;
+
+    switch (ks->config.dist) {
+        case KEYDIST_UNIFORM:
+            for (uint32_t i = 0; i < count; i++) {
+                uint32_t rank = fast_range((uint32_t)(rng_next(&state) >> 32), n);
+                keys[i] = hash_key64(rank ^ salt);
+            }
+            break;
+
+        case KEYDIST_ZIPF:
+            for (uint32_t i = 0; i < count; i++) {
+                uint64_t r = rng_next(&state);
+                uint32_t bucket = fast_range((uint32_t)(r >> 32), n);
+                uint32_t rank = ((uint32_t)r < ks->alias_prob[bucket]) ? bucket : ks->alias_index[bucket];
+                keys[i] = hash_key64(rank ^ salt);
+            }
+            break;
+
+        case KEYDIST_HOTSPOT: {
+            uint32_t hot = ks->hot_count;
+            uint32_t cold = n - hot;
+            for (uint32_t i = 0; i < count; i++) {
+                uint64_t r = rng_next(&state);
+                uint32_t rank = ((uint32_t)r < ks->hot_threshold)
+                    ? fast_range((uint32_t)(r >> 32), hot)
+                    : hot + fast_range((uint32_t)(r >> 32), cold);
+                keys[i] = hash_key64(rank ^ salt);
+            }
+            break;
+        }
+    }
+
+    ks->rng_state = state;
+}
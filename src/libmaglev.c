@@ -0,0 +1,318 @@
+#include "libmaglev.h"
+#include "maglev_core.h"
+#include "node.h"
+#include "hash.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#if LIBMAGLEV_MAX_BACKENDS != MAX_NODES || LIBMAGLEV_MAX_NAME_LEN != MAX_NODE_NAME_LEN - 1
+#error "libmaglev limits must match the Maglev core"
+#endif
+
+// One published table. Two of these alternate: commits rebuild the one
+// lookups are not using, then flip the active index. seq is odd while a
+// buffer is being written, so a lookup that raced with the writer retries.
+typedef struct {
+    uint64_t seq __attribute__((aligned(64)));
+    uint64_t generation;
+    uint32_t backend_count;
+    uint32_t *owner;            // Slot -> backend index (UINT32_MAX if unassigned)
+    uint32_t *backup;           // Slot -> owner to use while the owner is down
+    uint32_t ids[MAX_NODES];    // Backend index -> caller id
+    uint8_t down[MAX_NODES];    // Backend index -> down flag
+} Snapshot;
+
+struct libmaglev {
+    // Read by every lookup, never written after create except active
+    uint32_t table_size;
+    uint32_t active;
+    Snapshot snapshots[2];
+
+    // Staged membership, only touched with lock held
+    pthread_mutex_t lock;
+    Node *nodes[MAX_NODES];
+    uint32_t ids[MAX_NODES];
+    uint32_t node_count;
+    uint32_t down_count;
+    uint64_t generation;
+};
+
+const char *libmaglev_strerror(libmaglev_status status) {
+    switch (status) {
+        case LIBMAGLEV_OK:     return "success";
+        case LIBMAGLEV_EINVAL: return "invalid argument";
+        case LIBMAGLEV_ENOMEM: return "out of memory";
+        case LIBMAGLEV_EEXIST: return "backend already exists";
+        case LIBMAGLEV_ENOENT: return "no such backend";
+        case LIBMAGLEV_EFULL:  return "too many backends";
+    }
+    return "unknown error";
+}
+
+static void snapshot_free(Snapshot *s) {
+    free(s->owner);
+    free(s->backup);
+}
+
+// Allocate a handle with both snapshot buffers for an already rounded size
+static libmaglev_status create_table(uint32_t table_size, libmaglev_t **out) {
+    void *memory;
+    if (posix_memalign(&memory, 64, sizeof(libmaglev_t)) != 0) {
+        return LIBMAGLEV_ENOMEM;
+    }
+    libmaglev_t *lm = memory;
+    memset(lm, 0, sizeof(*lm));
+    lm->table_size = table_size;
+
+    bool ok = true;
+    for (int b = 0; b < 2; b++) {
+        Snapshot *s = &lm->snapshots[b];
+        s->owner = malloc(lm->table_size * sizeof(uint32_t));
+        s->backup = malloc(lm->table_size * sizeof(uint32_t));
+        if (!s->owner || !s->backup) {
+            ok = false;
+            continue;
+        }
+        memset(s->owner, 0xff, lm->table_size * sizeof(uint32_t));
+        memset(s->backup, 0xff, lm->table_size * sizeof(uint32_t));
+    }
+
+    if (!ok || pthread_mutex_init(&lm->lock, NULL) != 0) {
+        snapshot_free(&lm->snapshots[0]);
+        snapshot_free(&lm->snapshots[1]);
+        free(lm);
+        return LIBMAGLEV_ENOMEM;
+    }
+
+    *out = lm;
+    return LIBMAGLEV_OK;
+}
+
+libmaglev_status libmaglev_create(uint32_t table_size, libmaglev_t **out) {
+    if (!out || table_size == 1 || table_size > LIBMAGLEV_MAX_TABLE_SIZE) {
+        return LIBMAGLEV_EINVAL;
+    }
+    *out = NULL;
+    return create_table(next_prime(table_size == 0 ? DEFAULT_TABLE_SIZE : table_size), out);
+}
+
+libmaglev_status libmaglev_create_pow2(uint32_t table_size, libmaglev_t **out) {
+    if (!out || table_size == 1 || table_size > LIBMAGLEV_MAX_TABLE_SIZE) {
+        return LIBMAGLEV_EINVAL;
+    }
+    *out = NULL;
+    return create_table(next_pow2(table_size == 0 ? DEFAULT_TABLE_SIZE - 1 : table_size), out);
+}
+
+void libmaglev_destroy(libmaglev_t *lm) {
+    if (!lm) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < lm->node_count; i++) {
+        node_destroy(lm->nodes[i]);
+    }
+    snapshot_free(&lm->snapshots[0]);
+    snapshot_free(&lm->snapshots[1]);
+    pthread_mutex_destroy(&lm->lock);
+    free(lm);
+}
+
+// Staged index of a backend id, -1 if absent (lock held)
+static int find_backend(const libmaglev_t *lm, uint32_t id) {
+    for (uint32_t i = 0; i < lm->node_count; i++) {
+        if (lm->ids[i] == id) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+libmaglev_status libmaglev_add_backend(libmaglev_t *lm, uint32_t id, const char *name) {
+    if (!lm || !name || id == LIBMAGLEV_NO_BACKEND) {
+        return LIBMAGLEV_EINVAL;
+    }
+    size_t len = strlen(name);
+    if (len == 0 || len > LIBMAGLEV_MAX_NAME_LEN) {
+        return LIBMAGLEV_EINVAL;
+    }
+
+    pthread_mutex_lock(&lm->lock);
+
+    libmaglev_status status = LIBMAGLEV_OK;
+    for (uint32_t i = 0; i < lm->node_count; i++) {
+        if (lm->ids[i] == id || strcmp(lm->nodes[i]->name, name) == 0) {
+            status = LIBMAGLEV_EEXIST;
+            break;
+        }
+    }
+    if (status == LIBMAGLEV_OK && lm->node_count >= MAX_NODES) {
+        status = LIBMAGLEV_EFULL;
+    }
+
+    if (status == LIBMAGLEV_OK) {
+        Node *node = node_create(name, lm->table_size);
+        if (!node) {
+            status = LIBMAGLEV_ENOMEM;
+        } else {
+            lm->nodes[lm->node_count] = node;
+            lm->ids[lm->node_count] = id;
+            lm->node_count++;
+            lm->generation++;
+        }
+    }
+
+    pthread_mutex_unlock(&lm->lock);
+    return status;
+}
+
+libmaglev_status libmaglev_remove_backend(libmaglev_t *lm, uint32_t id) {
+    if (!lm) {
+        return LIBMAGLEV_EINVAL;
+    }
+
+    pthread_mutex_lock(&lm->lock);
+
+    int index = find_backend(lm, id);
+    if (index < 0) {
+        pthread_mutex_unlock(&lm->lock);
+        return LIBMAGLEV_ENOENT;
+    }
+
+    Node *node = lm->nodes[index];
+    if (!node->is_active) {
+        lm->down_count--;
+    }
+    node_destroy(node);
+
+    uint32_t tail = lm->node_count - (uint32_t)index - 1;
+    memmove(&lm->nodes[index], &lm->nodes[index + 1], tail * sizeof(Node *));
+    memmove(&lm->ids[index], &lm->ids[index + 1], tail * sizeof(uint32_t));
+    lm->node_count--;
+    lm->generation++;
+
+    pthread_mutex_unlock(&lm->lock);
+    return LIBMAGLEV_OK;
+}
+
+// Writer side of the buffer sequence counter (lock held)
+static void snapshot_begin_write(Snapshot *s) {
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void snapshot_end_write(Snapshot *s) {
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+libmaglev_status libmaglev_set_down(libmaglev_t *lm, uint32_t id, bool down) {
+    if (!lm) {
+        return LIBMAGLEV_EINVAL;
+    }
+
+    pthread_mutex_lock(&lm->lock);
+
+    int index = find_backend(lm, id);
+    if (index < 0) {
+        pthread_mutex_unlock(&lm->lock);
+        return LIBMAGLEV_ENOENT;
+    }
+
+    Node *node = lm->nodes[index];
+    if (node->is_active == down) {
+        node->is_active = !down;
+        lm->down_count += down ? 1 : (uint32_t)-1;
+        lm->generation++;
+
+        // Redirect (or restore) its slots in the published table right away
+        Snapshot *s = &lm->snapshots[lm->active];
+        for (uint32_t i = 0; i < s->backend_count; i++) {
+            if (s->ids[i] == id) {
+                snapshot_begin_write(s);
+                __atomic_store_n(&s->down[i], down ? 1 : 0, __ATOMIC_RELAXED);
+                snapshot_end_write(s);
+                break;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&lm->lock);
+    return LIBMAGLEV_OK;
+}
+
+libmaglev_status libmaglev_commit(libmaglev_t *lm) {
+    if (!lm) {
+        return LIBMAGLEV_EINVAL;
+    }
+
+    pthread_mutex_lock(&lm->lock);
+
+    // Only lookups that loaded the active index before the last flip can
+    // still be reading this buffer; the odd sequence makes them retry
+    uint32_t next = lm->active ^ 1;
+    Snapshot *s = &lm->snapshots[next];
+    snapshot_begin_write(s);
+
+    maglev_fill_table(s->owner, s->backup, NULL, lm->table_size, lm->nodes, lm->node_count);
+    for (uint32_t i = 0; i < lm->node_count; i++) {
+        s->ids[i] = lm->ids[i];
+        s->down[i] = lm->nodes[i]->is_active ? 0 : 1;
+    }
+    s->backend_count = lm->node_count;
+    s->generation = lm->generation;
+
+    snapshot_end_write(s);
+    __atomic_store_n(&lm->active, next, __ATOMIC_RELEASE);
+
+    pthread_mutex_unlock(&lm->lock);
+    return LIBMAGLEV_OK;
+}
+
+uint32_t libmaglev_lookup(const libmaglev_t *lm, uint64_t key_hash) {
+    uint32_t slot = maglev_slot(key_hash, lm->table_size);
+
+    for (;;) {
+        uint32_t active = __atomic_load_n(&lm->active, __ATOMIC_ACQUIRE);
+        const Snapshot *s = &lm->snapshots[active];
+        uint64_t seq = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            continue;
+        }
+
+        // Down owners are redirected to their backup; a torn view is caught by the sequence check
+        uint32_t index = maglev_resolve(s->owner, s->backup, s->down, MAX_NODES, lm->table_size, slot);
+        uint32_t id = index < MAX_NODES ? __atomic_load_n(&s->ids[index], __ATOMIC_RELAXED)
+                                        : LIBMAGLEV_NO_BACKEND;
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == seq) {
+            return id;
+        }
+    }
+}
+
+uint64_t libmaglev_hash_key(uint64_t key) {
+    return hash_key64(key);
+}
+
+libmaglev_status libmaglev_get_info(libmaglev_t *lm, libmaglev_info *info) {
+    if (!lm || !info) {
+        return LIBMAGLEV_EINVAL;
+    }
+
+    pthread_mutex_lock(&lm->lock);
+    const Snapshot *s = &lm->snapshots[lm->active];
+    info->table_size = lm->table_size;
+    info->backends = lm->node_count;
+    info->published_backends = s->backend_count;
+    info->down_backends = lm->down_count;
+    info->generation = lm->generation;
+    info->published_generation = s->generation;
+    // Two owner/backup buffers plus one preference list per backend
+    info->memory_bytes = sizeof(*lm) +
+                         (size_t)lm->table_size * sizeof(uint32_t) * (4 + lm->node_count);
+    pthread_mutex_unlock(&lm->lock);
+
+    return LIBMAGLEV_OK;
+}
@@ -0,0 +1,363 @@
+#include "load_stats.h"
+#include "hash.h"
+#include "timer.h"
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define LOAD_SHARD_BYTES ((sizeof(LoadShard) + 63) & ~(size_t)63)
+#define LOAD_BENCH_BATCH 1024
+#define LOAD_BENCH_ROUNDS 5
+
+typedef struct {
+    char name[MAX_NODE_NAME_LEN];
+    LoadCounter count;
+} LoadTotal;
+
+static bool g_enabled = false;
+static LoadShard *g_shards[LOAD_MAX_SHARDS];
+static bool g_shard_dirty[LOAD_MAX_SHARDS];
+
+// Folded counts, keyed by node name so they survive index shifts
+static LoadTotal g_totals[MAX_NODES];
+static uint32_t g_total_count = 0;
+static LoadCounter g_removed;       // Nodes no longer in the membership
+static LoadCounter g_unassigned;    // Keys that hit an empty slot
+
+static LoadShard *alloc_shard(void) {
+    LoadShard *shard;
+    if (posix_memalign((void **)&shard, 64, LOAD_SHARD_BYTES) != 0) {
+        return NULL;
+    }
+    memset(shard, 0, LOAD_SHARD_BYTES);
+    return shard;
+}
+
+bool load_stats_set_enabled(bool enabled) {
+    bool previous = g_enabled;
+    g_enabled = enabled;
+    return previous;
+}
+
+bool load_stats_enabled(void) {
+    return g_enabled;
+}
+
+// Counter shard for a lookup thread, allocated on first use
+LoadShard *load_stats_shard(uint32_t shard_id) {
+    if (!g_enabled) {
+        return NULL;
+    }
+
+    shard_id %= LOAD_MAX_SHARDS;
+    if (!g_shards[shard_id]) {
+        g_shards[shard_id] = alloc_shard();
+        if (!g_shards[shard_id]) {
+            return NULL;
+        }
+    }
+    g_shard_dirty[shard_id] = true;
+    return g_shards[shard_id];
+}
+
+static void counter_add(LoadCounter *dst, const LoadCounter *src) {
+    dst->hits += src->hits;
+    dst->bytes += src->bytes;
+}
+
+// Move packed counts into the wide counters
+void load_stats_widen(LoadShard *shard) {
+    for (uint32_t l = 0; l < LOAD_LANES; l++) {
+        for (uint32_t i = 0; i < LOAD_SHARD_COUNTERS; i++) {
+            uint64_t packed = shard->packed[l][i];
+            if (packed) {
+                shard->wide[i].hits += packed & LOAD_PACK_LIMIT;
+                shard->wide[i].bytes += packed >> LOAD_PACK_BITS;
+                shard->packed[l][i] = 0;
+            }
+        }
+    }
+    shard->pending = 0;
+}
+
+static LoadTotal *find_total(const char *name) {
+    for (uint32_t i = 0; i < g_total_count; i++) {
+        if (strcmp(g_totals[i].name, name) == 0) {
+            return &g_totals[i];
+        }
+    }
+    return NULL;
+}
+
+static bool is_member(const char *name) {
+    for (uint32_t i = 0; i < g_maglev.node_count; i++) {
+        if (g_maglev.nodes[i] && strcmp(g_maglev.nodes[i]->name, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Widen every shard written since the last fold
+static void widen_shards(void) {
+    for (uint32_t s = 0; s < LOAD_MAX_SHARDS; s++) {
+        if (g_shard_dirty[s] && g_shards[s]->pending) {
+            load_stats_widen(g_shards[s]);
+        }
+    }
+}
+
+// Sum one index across all shards (widened)
+static void sum_shards(uint32_t index, LoadCounter *sum) {
+    for (uint32_t s = 0; s < LOAD_MAX_SHARDS; s++) {
+        if (g_shard_dirty[s]) {
+            counter_add(sum, &g_shards[s]->wide[index]);
+        }
+    }
+}
+
+// Move shard counts into per-name totals (table lock held, before table_nodes changes)
+void load_stats_fold(void) {
+    bool dirty = false;
+    for (uint32_t s = 0; s < LOAD_MAX_SHARDS; s++) {
+        dirty = dirty || g_shard_dirty[s];
+    }
+
+    if (dirty) {
+        widen_shards();
+        uint32_t node_count = g_maglev.table_node_count;
+        for (uint32_t i = 0; i < node_count; i++) {
+            LoadCounter sum = {0, 0};
+            sum_shards(i, &sum);
+            if (sum.hits == 0) continue;
+
+            const char *name = g_maglev.table_nodes[i]->name;
+            LoadTotal *total = find_total(name);
+            if (!total && g_total_count < MAX_NODES) {
+                total = &g_totals[g_total_count++];
+                strcpy(total->name, name);
+                memset(&total->count, 0, sizeof(total->count));
+            }
+            counter_add(total ? &total->count : &g_removed, &sum);
+        }
+        sum_shards(node_count, &g_unassigned);
+
+        for (uint32_t s = 0; s < LOAD_MAX_SHARDS; s++) {
+            if (g_shard_dirty[s]) {
+                memset(g_shards[s], 0, LOAD_SHARD_BYTES);
+                g_shard_dirty[s] = false;
+            }
+        }
+    }
+
+    // Totals of removed nodes collapse into a single bucket
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < g_total_count; i++) {
+        if (is_member(g_totals[i].name)) {
+            g_totals[kept++] = g_totals[i];
+        } else {
+            counter_add(&g_removed, &g_totals[i].count);
+        }
+    }
+    g_total_count = kept;
+}
+
+void load_stats_reset(void) {
+    for (uint32_t s = 0; s < LOAD_MAX_SHARDS; s++) {
+        if (g_shards[s]) {
+            memset(g_shards[s], 0, LOAD_SHARD_BYTES);
+        }
+        g_shard_dirty[s] = false;
+    }
+    g_total_count = 0;
+    memset(&g_removed, 0, sizeof(g_removed));
+    memset(&g_unassigned, 0, sizeof(g_unassigned));
+}
+
+// Print per-backend hits and bytes against each backend's slot share
+void load_stats_show(void) {
+    if (!g_maglev.is_initialized) {
+        printf("Error: Maglev table not initialized\n");
+        return;
+    }
+
+    uint32_t node_count = g_maglev.table_node_count;
+    LoadCounter *counts = calloc(node_count + 1, sizeof(LoadCounter));
+    uint32_t *slots = calloc(node_count + 1, sizeof(uint32_t));
+    if (!counts || !slots) {
+        printf("Error: Memory allocation failed\n");
+        free(counts);
+        free(slots);
+        return;
+    }
+
+    widen_shards();
+    LoadCounter total = g_removed;
+    counter_add(&total, &g_unassigned);
+    for (uint32_t i = 0; i < node_count; i++) {
+        LoadTotal *folded = find_total(g_maglev.table_nodes[i]->name);
+        if (folded) {
+            counts[i] = folded->count;
+        }
+        sum_shards(i, &counts[i]);
+        counter_add(&total, &counts[i]);
+    }
+    sum_shards(node_count, &counts[node_count]);
+    counter_add(&total, &counts[node_count]);
+
+    for (uint32_t i = 0; i < g_maglev.table_size; i++) {
+        uint32_t owner = maglev_resolve_slot(i);
+        slots[owner < node_count ? owner : node_count]++;
+    }
+
+    printf("Backend load (counters %s, %llu hits, %.1f MB total):\n",
+           g_enabled ? "on" : "off", (unsigned long long)total.hits, total.bytes / 1e6);
+    printf("  %-*s %14s %8s %14s %8s %8s\n", get_max_node_name_length(), "Node",
+           "Hits", "Share", "Bytes", "Slots", "Ratio");
+
+    for (uint32_t i = 0; i < node_count; i++) {
+        double hit_share = total.hits ? 100.0 * counts[i].hits / total.hits : 0.0;
+        double slot_share = 100.0 * slots[i] / g_maglev.table_size;
+        printf("  %-*s %14llu %7.2f%% %14llu %7.2f%% %7.3fx%s\n",
+               get_max_node_name_length(), g_maglev.table_nodes[i]->name,
+               (unsigned long long)counts[i].hits, hit_share,
+               (unsigned long long)counts[i].bytes, slot_share,
+               slot_share > 0 ? hit_share / slot_share : 0.0,
+               g_maglev.table_node_down[i] ? "  (failed)" : "");
+    }
+
+    if (g_removed.hits > 0) {
+        printf("  Removed nodes: %llu hits, %llu bytes\n",
+               (unsigned long long)g_removed.hits, (unsigned long long)g_removed.bytes);
+    }
+    uint64_t unassigned = g_unassigned.hits + counts[node_count].hits;
+    if (unassigned > 0) {
+        printf("  Unassigned: %llu hits\n", (unsigned long long)unassigned);
+    }
+    if (!g_enabled && total.hits == 0) {
+        printf("  (use 'load on' and run 'simulate' to collect traffic)\n");
+    }
+
+    free(counts);
+    free(slots);
+}
+
+typedef struct {
+    uint64_t lookups;
+    uint64_t seed;
+    LoadShard *shard;           // NULL: counting off
+    uint64_t checksum;
+} LoadBenchWorker;
+
+// The simulate lookup loop, with or without counting
+static void *load_bench_worker(void *arg) {
+    LoadBenchWorker *w = arg;
+    uint64_t keys[LOAD_BENCH_BATCH];
+    uint32_t owners[LOAD_BENCH_BATCH];
+    uint32_t slots[LOAD_BENCH_BATCH];
+    const uint32_t *table = g_maglev.lookup_table;
+    const uint8_t *down = g_maglev.table_node_down;
+    uint32_t table_size = g_maglev.table_size;
+    const TableKernel *kernel = g_maglev.kernel;
+    uint32_t unassigned = g_maglev.table_node_count;
+    uint64_t counter = w->seed;
+    uint64_t checksum = 0;
+
+    for (uint64_t done = 0; done < w->lookups; done += LOAD_BENCH_BATCH) {
+        for (uint32_t i = 0; i < LOAD_BENCH_BATCH; i++) {
+            keys[i] = hash_key64(counter++);
+        }
+        kernel->slots(keys, slots, LOAD_BENCH_BATCH, table_size);
+        for (uint32_t i = 0; i < LOAD_BENCH_BATCH; i++) {
+            uint32_t owner = table[slots[i]];
+            if (owner < unassigned && down[owner]) {
+                owner = maglev_resolve_slot(slots[i]);
+            }
+            owners[i] = owner < unassigned ? owner : unassigned;
+            checksum += owners[i];
+        }
+        if (w->shard) {
+            load_stats_count_batch(w->shard, owners, keys, LOAD_BENCH_BATCH);
+        }
+    }
+
+    w->checksum = checksum;
+    return NULL;
+}
+
+// One timed run, in Mlookups/s
+static double load_bench_run(uint32_t threads, uint64_t lookups, uint64_t seed, LoadShard **shards) {
+    LoadBenchWorker workers[LOAD_MAX_SHARDS];
+    pthread_t tids[LOAD_MAX_SHARDS];
+
+    for (uint32_t t = 0; t < threads; t++) {
+        workers[t].lookups = lookups;
+        workers[t].seed = ((uint64_t)t << 40) + seed;
+        workers[t].shard = shards ? shards[t] : NULL;
+        workers[t].checksum = 0;
+    }
+
+    profile_phase_begin(PROFILE_LOOKUP);
+    uint64_t start = timer_now_ns();
+    for (uint32_t t = 0; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, load_bench_worker, &workers[t]) != 0) {
+            load_bench_worker(&workers[t]);
+            tids[t] = 0;
+        }
+    }
+    for (uint32_t t = 0; t < threads; t++) {
+        if (tids[t]) pthread_join(tids[t], NULL);
+    }
+    uint64_t elapsed = timer_now_ns() - start;
+    profile_phase_end(PROFILE_LOOKUP);
+
+    return elapsed ? (double)threads * lookups / (elapsed / 1e9) / 1e6 : 0.0;
+}
+
+// Lookup throughput with counting off versus on, for 1..max_threads threads
+void load_stats_bench(uint32_t max_threads, uint64_t lookups_per_thread) {
+    if (!g_maglev.is_initialized || g_maglev.table_node_count == 0) {
+        printf("Error: Maglev table not initialized or has no nodes\n");
+        return;
+    }
+
+    if (max_threads == 0) max_threads = 1;
+    if (max_threads > LOAD_MAX_SHARDS) max_threads = LOAD_MAX_SHARDS;
+    lookups_per_thread = (lookups_per_thread + LOAD_BENCH_BATCH - 1) / LOAD_BENCH_BATCH * LOAD_BENCH_BATCH;
+
+    // Scratch shards: the benchmark does not pollute the real counters
+    LoadShard *shards[LOAD_MAX_SHARDS];
+    for (uint32_t t = 0; t < max_threads; t++) {
+        shards[t] = alloc_shard();
+        if (!shards[t]) {
+            for (uint32_t j = 0; j < t; j++) free(shards[j]);
+            printf("Error: Memory allocation failed\n");
+            return;
+        }
+    }
+
+    printf("Lookup throughput, counters off vs on (%llu lookups/thread, best of %d):\n",
+           (unsigned long long)lookups_per_thread, LOAD_BENCH_ROUNDS);
+    printf("  %7s %14s %14s %9s\n", "Threads", "Off (M/s)", "On (M/s)", "Overhead");
+
+    for (uint32_t threads = 1; ; threads = threads * 2 < max_threads ? threads * 2 : max_threads) {
+        // Alternate off/on runs so frequency or scheduler drift hits both equally
+        double off = 0.0, on = 0.0;
+        for (int round = 0; round < LOAD_BENCH_ROUNDS; round++) {
+            uint64_t seed = (uint64_t)round * lookups_per_thread;
+            double rate = load_bench_run(threads, lookups_per_thread, seed, NULL);
+            if (rate > off) off = rate;
+            rate = load_bench_run(threads, lookups_per_thread, seed, shards);
+            if (rate > on) on = rate;
+        }
+        printf("  %7u %14.1f %14.1f %8.2f%%\n", threads, off, on,
+               off > 0 ? 100.0 * (off - on) / off : 0.0);
+        if (threads == max_threads) break;
+    }
+
+    for (uint32_t t = 0; t < max_threads; t++) {
+        free(shards[t]);
+    }
+}
@@ -1,62 +1,153 @@
 #include "maglev.h"
 #include "node.h"
+#include "rebuild_worker.h"
+#include "load_stats.h"
+#include "timer.h"
+#include "hash.h"
+#include "profile.h"
+#include "table_history.h"
+#include "preference_pool.h"
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
-#include <time.h>
+
+#define RESIZE_SAMPLE_KEYS (1u << 20)  // Keys sampled to measure movement on resize
 
 // Global Maglev table instance
 MaglevTable g_maglev = {0};
 
-// Check if a number is prime
-bool is_prime(uint32_t n) {
-    if (n < 2) return false;
-    if (n == 2) return true;
-    if (n % 2 == 0) return false;
+// Protects the published table and the node array against the rebuild worker
+static pthread_mutex_t g_maglev_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Called after every table publish, e.g. to mirror it into shared memory
+static MaglevPublishHook g_publish_hook = NULL;
+
+const char *maglev_strerror(MaglevStatus status) {
+    switch (status) {
+    case MAGLEV_OK: return "Success";
+    case MAGLEV_ENOTINIT: return "Maglev table not initialized";
+    case MAGLEV_EINVAL: return "Invalid node name";
+    case MAGLEV_EEXIST: return "Node already exists";
+    case MAGLEV_EDUP: return "Node given more than once";
+    case MAGLEV_ENOENT: return "Node does not exist";
+    case MAGLEV_EFULL: return "Maximum number of nodes reached";
+    case MAGLEV_ENOMEM: return "Memory allocation failed";
+    case MAGLEV_ENOHISTORY: return "Table history is off";
+    case MAGLEV_ERANGE: return "Version not kept";
+    case MAGLEV_ESIZE: return "Version has a different table size";
+    }
+    return "Unknown error";
+}
 
-    for (uint32_t i = 3; i * i <= n; i += 2) {
-        if (n % i == 0) return false;
+// Clear the caller's change report, or point at a scratch one if it passed NULL
+static MaglevChange *change_reset(MaglevChange *change, MaglevChange *scratch) {
+    change = change ? change : scratch;
+    memset(change, 0, sizeof(*change));
+    return change;
+}
+
+void maglev_set_publish_hook(MaglevPublishHook hook) {
+    g_publish_hook = hook;
+}
+
+// Run the publish hook (lock held or no worker)
+void maglev_notify_published(bool down_only) {
+    if (g_publish_hook) {
+        g_publish_hook(down_only);
     }
-    return true;
 }
 
-// Find the next prime number
-uint32_t next_prime(uint32_t n) {
-    while (!is_prime(n)) {
-        n++;
+void maglev_lock(void) {
+    pthread_mutex_lock(&g_maglev_lock);
+}
+
+void maglev_unlock(void) {
+    pthread_mutex_unlock(&g_maglev_lock);
+}
+
+void maglev_wait(pthread_cond_t *cond) {
+    pthread_cond_wait(cond, &g_maglev_lock);
+}
+
+// Advance the membership generation (lock held)
+static void maglev_bump_generation(void) {
+    g_maglev.generation++;
+    rebuild_worker_note_change(g_maglev.generation);
+}
+
+// Publish the node snapshot an inline-filled table indexes into
+static void maglev_publish_snapshot(void) {
+    load_stats_fold();
+    memcpy(g_maglev.table_nodes, g_maglev.nodes, g_maglev.node_count * sizeof(Node *));
+    g_maglev.table_node_count = g_maglev.node_count;
+    g_maglev.table_generation = g_maglev.generation;
+    g_maglev.slot_index_stale = false;
+    maglev_publish_down_flags();
+    maglev_notify_published(false);
+}
+
+// Record the published table in the history. Only for tables this thread
+// published with the worker idle: runs without the lock, so failure
+// redirects are not held up by the O(table_size) pass.
+static void maglev_record_published(void) {
+    TableSnapshot snapshot = {
+        .generation = g_maglev.table_generation,
+        .table_size = g_maglev.table_size,
+        .table = g_maglev.lookup_table,
+        .backup = g_maglev.backup_table,
+        .nodes = g_maglev.table_nodes,
+        .down = g_maglev.table_node_down,
+        .node_count = g_maglev.table_node_count,
+    };
+    table_history_record(&snapshot);
+}
+
+// Round a requested size up to a prime, or to a power of two
+static uint32_t round_table_size(uint32_t table_size, bool pow2) {
+    if (table_size < 2) {
+        table_size = pow2 ? DEFAULT_TABLE_SIZE - 1 : DEFAULT_TABLE_SIZE;
     }
-    return n;
+    return pow2 ? next_pow2(table_size) : next_prime(table_size);
 }
 
 // Initialize Maglev table
-bool maglev_init(uint32_t table_size) {
+MaglevStatus maglev_init(uint32_t table_size, bool pow2) {
     // Clean up existing resources
     maglev_cleanup();
 
-    // Ensure table size is prime
-    if (table_size < 2) {
-        table_size = DEFAULT_TABLE_SIZE;
-    } else {
-        table_size = next_prime(table_size);
-    }
+    table_size = round_table_size(table_size, pow2);
 
     // Allocate lookup table memory
     g_maglev.lookup_table = calloc(table_size, sizeof(uint32_t));
-    if (!g_maglev.lookup_table) {
-        return false;
+    g_maglev.backup_table = calloc(table_size, sizeof(uint32_t));
+    bool indexed = slot_index_alloc(&g_maglev.slot_index, table_size);
+    if (!g_maglev.lookup_table || !g_maglev.backup_table || !indexed) {
+        free(g_maglev.lookup_table);
+        free(g_maglev.backup_table);
+        g_maglev.lookup_table = NULL;
+        g_maglev.backup_table = NULL;
+        slot_index_free(&g_maglev.slot_index);
+        return MAGLEV_ENOMEM;
     }
 
     // Initialize lookup table to invalid values
     for (uint32_t i = 0; i < table_size; i++) {
         g_maglev.lookup_table[i] = UINT32_MAX;
+        g_maglev.backup_table[i] = UINT32_MAX;
     }
+    memset(g_maglev.table_node_down, 0, sizeof(g_maglev.table_node_down));
 
     g_maglev.table_size = table_size;
+    g_maglev.kernel = table_kernel_select(table_size);
+    g_maglev.pow2 = pow2;
     g_maglev.node_count = 0;
+    g_maglev.table_node_count = 0;
+    g_maglev.generation = 0;
+    g_maglev.table_generation = 0;
+    g_maglev.slot_index_stale = false;
     g_maglev.is_initialized = true;
-
-    printf("Maglev table initialized with size: %u\n", table_size);
-    return true;
+    maglev_notify_published(false);
+    maglev_record_published();
+    return MAGLEV_OK;
 }
 
 // Clean up Maglev table
@@ -65,6 +156,11 @@ void maglev_cleanup(void) {
         return;
     }
 
+    // Let an in-flight background rebuild finish and release retired nodes
+    rebuild_worker_drain();
+    load_stats_fold();
+    table_history_clear();
+
     // Free all nodes
     for (uint32_t i = 0; i < g_maglev.node_count; i++) {
         if (g_maglev.nodes[i]) {
@@ -78,12 +174,129 @@ void maglev_cleanup(void) {
         free(g_maglev.lookup_table);
         g_maglev.lookup_table = NULL;
     }
+    free(g_maglev.backup_table);
+    g_maglev.backup_table = NULL;
+    slot_index_free(&g_maglev.slot_index);
 
     g_maglev.node_count = 0;
+    g_maglev.table_node_count = 0;
     g_maglev.table_size = 0;
     g_maglev.is_initialized = false;
 }
 
+// Owner of each sample key in the published table
+static void sample_owners(Node **owners) {
+    for (uint32_t i = 0; i < RESIZE_SAMPLE_KEYS; i++) {
+        // Not traffic: resolve directly so the load counters stay untouched
+        uint32_t owner = maglev_resolve_slot(maglev_slot(hash_key64(i), g_maglev.table_size));
+        owners[i] = owner < g_maglev.table_node_count ? g_maglev.table_nodes[owner] : NULL;
+    }
+}
+
+// Change the table size keeping every node and its state. Preference
+// lists are regenerated for the new size in parallel, then the table is
+// rebuilt once.
+MaglevStatus maglev_resize(uint32_t table_size, MaglevChange *change) {
+    MaglevChange scratch;
+    change = change_reset(change, &scratch);
+    if (!g_maglev.is_initialized) {
+        return MAGLEV_ENOTINIT;
+    }
+
+    table_size = round_table_size(table_size, g_maglev.pow2);
+    change->old_table_size = g_maglev.table_size;
+    change->node_count = g_maglev.node_count;
+    if (table_size == g_maglev.table_size) {
+        change->unchanged = true;
+        return MAGLEV_OK;
+    }
+
+    // The worker must not be filling from the preference lists we replace
+    rebuild_worker_drain();
+
+    uint32_t node_count = g_maglev.node_count;
+
+    // Allocate everything up front so a failure leaves the table untouched
+    Node **before = malloc(RESIZE_SAMPLE_KEYS * sizeof(Node *));
+    Node **after = malloc(RESIZE_SAMPLE_KEYS * sizeof(Node *));
+    uint32_t **lists = calloc(node_count ? node_count : 1, sizeof(uint32_t *));
+    uint32_t *lookup_table = malloc(table_size * sizeof(uint32_t));
+    uint32_t *backup_table = malloc(table_size * sizeof(uint32_t));
+    SlotIndex slot_index;
+    bool indexed = slot_index_alloc(&slot_index, table_size);
+    bool ok = before && after && lists && lookup_table && backup_table && indexed;
+    for (uint32_t i = 0; ok && i < node_count; i++) {
+        lists[i] = malloc(table_size * sizeof(uint32_t));
+        ok = lists[i] != NULL;
+    }
+
+    if (!ok) {
+        for (uint32_t i = 0; lists && i < node_count; i++) free(lists[i]);
+        free(lists);
+        free(before);
+        free(after);
+        free(lookup_table);
+        free(backup_table);
+        if (indexed) slot_index_free(&slot_index);
+        return MAGLEV_ENOMEM;
+    }
+
+    maglev_lock();
+    sample_owners(before);
+    maglev_unlock();
+
+    // Swap in the new lists; the old ones are freed once the table no longer uses them
+    for (uint32_t i = 0; i < node_count; i++) {
+        uint32_t *old_list = g_maglev.nodes[i]->preference_list;
+        g_maglev.nodes[i]->preference_list = lists[i];
+        lists[i] = old_list;
+    }
+
+    // Offsets and skips depend on the table size: regenerate all lists in one parallel pass
+    uint64_t lists_start = timer_now_ns();
+    change->threads = preference_pool_generate(g_maglev.nodes, node_count, table_size, 0);
+    change->lists_ns = timer_now_ns() - lists_start;
+
+    // One rebuild at the new size
+    uint64_t fill_start = timer_now_ns();
+    profile_phase_begin(PROFILE_FILL);
+    maglev_fill_table(lookup_table, backup_table, &slot_index, table_size, g_maglev.nodes, node_count);
+    profile_phase_end(PROFILE_FILL);
+
+    maglev_lock();
+    uint32_t *old_lookup = g_maglev.lookup_table;
+    uint32_t *old_backup = g_maglev.backup_table;
+    SlotIndex old_index = g_maglev.slot_index;
+    g_maglev.lookup_table = lookup_table;
+    g_maglev.backup_table = backup_table;
+    g_maglev.slot_index = slot_index;
+    g_maglev.table_size = table_size;
+    g_maglev.kernel = table_kernel_select(table_size);
+    maglev_bump_generation();
+    maglev_publish_snapshot();
+    change->rebuild_ns = timer_now_ns() - fill_start;
+    sample_owners(after);
+    maglev_unlock();
+    maglev_record_published();
+
+    uint32_t moved = 0;
+    for (uint32_t i = 0; i < RESIZE_SAMPLE_KEYS; i++) {
+        moved += before[i] != after[i];
+    }
+
+    for (uint32_t i = 0; i < node_count; i++) free(lists[i]);
+    free(lists);
+    free(old_lookup);
+    free(old_backup);
+    slot_index_free(&old_index);
+    free(before);
+    free(after);
+
+    change->moved = (double)moved / RESIZE_SAMPLE_KEYS;
+    change->sample_keys = RESIZE_SAMPLE_KEYS;
+    return MAGLEV_OK;
+}
+
 // Find node index
 int find_node_index(const char *node_name) {
     for (uint32_t i = 0; i < g_maglev.node_count; i++) {
@@ -117,400 +330,405 @@ int get_max_node_name_length(void) {
 }
 
 // Add node
-bool maglev_add_node(const char *node_name) {
+MaglevStatus maglev_add_node(const char *node_name) {
     if (!g_maglev.is_initialized) {
-        printf("Error: Maglev table not initialized\n");
-        return false;
+        return MAGLEV_ENOTINIT;
     }
 
     if (!node_name || strlen(node_name) == 0) {
-        printf("Error: Invalid node name\n");
-        return false;
+        return MAGLEV_EINVAL;
     }
 
     // Check if node already exists
     if (find_node_index(node_name) >= 0) {
-        printf("Error: Node '%s' already exists\n", node_name);
-        return false;
+        return MAGLEV_EEXIST;
     }
 
     // Check if maximum number of nodes is exceeded
     if (g_maglev.node_count >= MAX_NODES) {
-        printf("Error: Maximum number of nodes reached\n");
-        return false;
+        return MAGLEV_EFULL;
     }
 
     // Create new node
+    profile_phase_begin(PROFILE_PREFERENCE);
     Node *new_node = node_create(node_name, g_maglev.table_size);
+    profile_phase_end(PROFILE_PREFERENCE);
     if (!new_node) {
-        printf("Error: Failed to create node '%s'\n", node_name);
-        return false;
+        return MAGLEV_ENOMEM;
     }
 
     // Add to node array
+    maglev_lock();
     g_maglev.nodes[g_maglev.node_count] = new_node;
     g_maglev.node_count++;
+    maglev_bump_generation();
+    maglev_unlock();
 
     // Rebuild lookup table
     maglev_rebuild_table();
+    return MAGLEV_OK;
+}
 
-    printf("Node '%s' added successfully\n", node_name);
-    return true;
+// Add several nodes with one membership change: their preference lists are
+// generated in parallel, then the table is rebuilt once
+MaglevStatus maglev_add_nodes(const char *const *node_names, uint32_t count, MaglevChange *change) {
+    MaglevChange scratch;
+    change = change_reset(change, &scratch);
+    if (!g_maglev.is_initialized) {
+        return MAGLEV_ENOTINIT;
+    }
+
+    change->node_count = count;
+    if (count == 0) {
+        change->unchanged = true;
+        return MAGLEV_OK;
+    }
+
+    if (count > MAX_NODES - g_maglev.node_count) {
+        return MAGLEV_EFULL;
+    }
+
+    // Validate the whole batch before creating anything
+    for (uint32_t i = 0; i < count; i++) {
+        change->failed_index = i;
+        if (!node_names[i] || strlen(node_names[i]) == 0 || strlen(node_names[i]) >= MAX_NODE_NAME_LEN) {
+            return MAGLEV_EINVAL;
+        }
+        if (find_node_index(node_names[i]) >= 0) {
+            return MAGLEV_EEXIST;
+        }
+        for (uint32_t j = 0; j < i; j++) {
+            if (strcmp(node_names[i], node_names[j]) == 0) {
+                return MAGLEV_EDUP;
+            }
+        }
+    }
+    change->failed_index = 0;
+
+    Node **nodes = calloc(count, sizeof(Node *));
+    bool ok = nodes != NULL;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        nodes[i] = node_alloc(node_names[i], g_maglev.table_size);
+        ok = nodes[i] != NULL;
+    }
+    if (!ok) {
+        for (uint32_t i = 0; nodes && i < count; i++) node_destroy(nodes[i]);
+        free(nodes);
+        return MAGLEV_ENOMEM;
+    }
+
+    uint64_t lists_start = timer_now_ns();
+    change->threads = preference_pool_generate(nodes, count, g_maglev.table_size, 0);
+    change->lists_ns = timer_now_ns() - lists_start;
+
+    maglev_lock();
+    memcpy(&g_maglev.nodes[g_maglev.node_count], nodes, count * sizeof(Node *));
+    g_maglev.node_count += count;
+    maglev_bump_generation();
+    maglev_unlock();
+    free(nodes);
+
+    uint64_t fill_start = timer_now_ns();
+    maglev_rebuild_table();
+    change->rebuild_ns = timer_now_ns() - fill_start;
+    change->queued = rebuild_worker_is_running();
+    return MAGLEV_OK;
 }
 
 // Remove node
-bool maglev_remove_node(const char *node_name) {
+MaglevStatus maglev_remove_node(const char *node_name, MaglevChange *change) {
+    MaglevChange scratch;
+    change = change_reset(change, &scratch);
     if (!g_maglev.is_initialized) {
-        printf("Error: Maglev table not initialized\n");
-        return false;
+        return MAGLEV_ENOTINIT;
     }
 
     int index = find_node_index(node_name);
     if (index < 0) {
         // Ignore non-existent nodes (as required)
-        printf("Node '%s' does not exist (ignored)\n", node_name);
-        return true;
+        change->unchanged = true;
+        return MAGLEV_OK;
     }
 
-    // Destroy node
-    node_destroy(g_maglev.nodes[index]);
+    Node *removed = g_maglev.nodes[index];
 
     // Move array elements
+    maglev_lock();
     for (uint32_t i = index; i < g_maglev.node_count - 1; i++) {
         g_maglev.nodes[i] = g_maglev.nodes[i + 1];
     }
     g_maglev.nodes[g_maglev.node_count - 1] = NULL;
     g_maglev.node_count--;
+    maglev_bump_generation();
+    maglev_unlock();
 
     // Rebuild lookup table
     maglev_rebuild_table();
 
-    printf("Node '%s' removed successfully\n", node_name);
-    return true;
+    // The published table may still reference the node until the worker catches up
+    if (rebuild_worker_is_running()) {
+        rebuild_worker_retire_node(removed);
+    } else {
+        node_destroy(removed);
+    }
+    change->queued = rebuild_worker_is_running();
+    return MAGLEV_OK;
 }
 
-// Rebuild lookup table (Core Maglev algorithm)
-void maglev_rebuild_table(void) {
-    if (!g_maglev.is_initialized || g_maglev.node_count == 0) {
-        // Clear table
-        for (uint32_t i = 0; i < g_maglev.table_size; i++) {
-            g_maglev.lookup_table[i] = UINT32_MAX;
-        }
-        return;
+// Mark a node failed: its slots are redirected to their backup owners
+// immediately, then a full rebuild takes it out of the table
+MaglevStatus maglev_fail_node(const char *node_name, MaglevChange *change) {
+    MaglevChange scratch;
+    change = change_reset(change, &scratch);
+    if (!g_maglev.is_initialized) {
+        return MAGLEV_ENOTINIT;
     }
 
-    // Reset all nodes' index pointers
-    for (uint32_t i = 0; i < g_maglev.node_count; i++) {
-        node_reset_index(g_maglev.nodes[i]);
+    int index = find_node_index(node_name);
+    if (index < 0) {
+        return MAGLEV_ENOENT;
     }
 
-    // Clear lookup table
-    for (uint32_t i = 0; i < g_maglev.table_size; i++) {
-        g_maglev.lookup_table[i] = UINT32_MAX;
+    Node *node = g_maglev.nodes[index];
+    if (!node->is_active) {
+        change->unchanged = true;
+        return MAGLEV_OK;
     }
 
-    // Standard Maglev algorithm: round-robin assignment
-    uint32_t filled = 0;
-
-    // Keep polling until all positions are filled
-    while (filled < g_maglev.table_size) {
-        // In each round, every node tries to get the next position from its preference list
-        for (uint32_t i = 0; i < g_maglev.node_count; i++) {
-            Node *node = g_maglev.nodes[i];
-            if (!node || !node->is_active) continue;
-
-            // If this node still has untried preference positions
-            while (node->next_index < g_maglev.table_size) {
-                uint32_t preferred_slot = node->preference_list[node->next_index];
-                node->next_index++;
-
-                // If this position is free, assign it to the current node
-                if (g_maglev.lookup_table[preferred_slot] == UINT32_MAX) {
-                    g_maglev.lookup_table[preferred_slot] = i;
-                    filled++;
-                    break; // This node got a position in this round, move to next node
-                }
-            }
-
-            // If all positions are filled, exit early
-            if (filled >= g_maglev.table_size) {
-                break;
-            }
+    // Redirect: flip the published failure flag, no table rewrite needed
+    uint64_t start = timer_now_ns();
+    maglev_lock();
+    node->is_active = false;
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        if (g_maglev.table_nodes[i] == node) {
+            g_maglev.table_node_down[i] = 1;
         }
     }
+    maglev_bump_generation();
+    maglev_notify_published(true);
+    maglev_unlock();
+    uint64_t redirected = timer_now_ns();
+    change->redirect_ns = redirected - start;
+
+    // Full rebuild: inline when no worker runs (the old remove path), otherwise in the background
+    maglev_rebuild_table();
+    change->rebuild_ns = timer_now_ns() - redirected;
+    change->queued = rebuild_worker_is_running();
+    return MAGLEV_OK;
 }
 
-// Show current node status
-void maglev_show_nodes(void) {
+// Bring a failed node back; it keeps being redirected until the rebuild publishes
+MaglevStatus maglev_recover_node(const char *node_name, MaglevChange *change) {
+    MaglevChange scratch;
+    change = change_reset(change, &scratch);
     if (!g_maglev.is_initialized) {
-        printf("Maglev table not initialized\n");
-        return;
+        return MAGLEV_ENOTINIT;
     }
 
-    printf("Current nodes (%u total):\n", g_maglev.node_count);
-    if (g_maglev.node_count == 0) {
-        printf("  (no nodes)\n");
-        return;
+    int index = find_node_index(node_name);
+    if (index < 0) {
+        return MAGLEV_ENOENT;
     }
 
-    for (uint32_t i = 0; i < g_maglev.node_count; i++) {
-        if (g_maglev.nodes[i]) {
-            printf("  %u: %s\n", i, g_maglev.nodes[i]->name);
-        }
+    Node *node = g_maglev.nodes[index];
+    if (node->is_active) {
+        change->unchanged = true;
+        return MAGLEV_OK;
     }
-}
 
-// Show complete Maglev table status
-void maglev_show_table(void) {
-    if (!g_maglev.is_initialized) {
-        printf("Maglev table not initialized\n");
-        return;
-    }
+    maglev_lock();
+    node->is_active = true;
+    maglev_bump_generation();
+    maglev_unlock();
 
-    printf("Maglev lookup table (size: %u):\n", g_maglev.table_size);
+    maglev_rebuild_table();
+    change->queued = rebuild_worker_is_running();
+    return MAGLEV_OK;
+}
 
-    if (g_maglev.node_count == 0) {
-        printf("  (empty - no nodes)\n");
+// Rebuild lookup table, either inline or by handing off to the background worker
+void maglev_rebuild_table(void) {
+    if (!g_maglev.is_initialized) {
         return;
     }
 
-    // Count assignment for each node
-    uint32_t *node_counts = calloc(g_maglev.node_count, sizeof(uint32_t));
-    if (!node_counts) {
-        printf("Error: Memory allocation failed\n");
+    if (rebuild_worker_is_running()) {
+        rebuild_worker_request();
         return;
     }
 
-    uint32_t unassigned = 0;
+    maglev_generate_pending_lists(g_maglev.nodes, g_maglev.node_count);
+    profile_phase_begin(PROFILE_FILL);
+    maglev_fill_table(g_maglev.lookup_table, g_maglev.backup_table, &g_maglev.slot_index,
+                      g_maglev.table_size, g_maglev.nodes, g_maglev.node_count);
+    profile_phase_end(PROFILE_FILL);
+    maglev_publish_snapshot();
+    maglev_record_published();
+}
 
-    for (uint32_t i = 0; i < g_maglev.table_size; i++) {
-        if (g_maglev.lookup_table[i] == UINT32_MAX) {
-            unassigned++;
-        } else if (g_maglev.lookup_table[i] < g_maglev.node_count) {
-            node_counts[g_maglev.lookup_table[i]]++;
-        }
+// Republish a kept table version. Membership, failure flags and both tables
+// come back from the history: the tables are taken over (or materialized)
+// without the lock and swapped in by pointer. The slot index and the
+// preference lists of recreated nodes are rebuilt when first needed.
+MaglevStatus maglev_rollback(uint32_t steps, MaglevChange *change) {
+    MaglevChange scratch;
+    change = change_reset(change, &scratch);
+    if (!g_maglev.is_initialized) {
+        return MAGLEV_ENOTINIT;
     }
-
-    // Show statistics
-    printf("Distribution summary:\n");
-    for (uint32_t i = 0; i < g_maglev.node_count; i++) {
-        if (g_maglev.nodes[i]) {
-            printf("  %s: %u slots (%.2f%%)\n",
-                   g_maglev.nodes[i]->name,
-                   node_counts[i],
-                   100.0 * node_counts[i] / g_maglev.table_size);
-        }
+    if (table_history_depth() == 0) {
+        return MAGLEV_ENOHISTORY;
     }
 
-    if (unassigned > 0) {
-        printf("  Unassigned: %u slots (%.2f%%)\n",
-               unassigned, 100.0 * unassigned / g_maglev.table_size);
+    // The newest version must be the published table
+    if (rebuild_worker_is_running()) {
+        rebuild_worker_sync();
     }
 
-    // Show detailed assignment for first 100 slots (or all if table is smaller)
-    uint32_t show_count = (g_maglev.table_size < 100) ? g_maglev.table_size : 100;
-    int field_width = get_max_node_name_length();
-    int items_per_line = (field_width <= 10) ? 10 : 8;  // Adjust items per line based on name length
-
-    printf("\nFirst %u slots:\n", show_count);
-
-    for (uint32_t i = 0; i < show_count; i++) {
-        if (i % items_per_line == 0) {
-            printf("\n%4u: ", i);
-        }
-
-        if (g_maglev.lookup_table[i] == UINT32_MAX) {
-            printf("%*s ", field_width, "-");
-        } else if (g_maglev.lookup_table[i] < g_maglev.node_count && g_maglev.nodes[g_maglev.lookup_table[i]]) {
-            printf("%*s ", field_width, g_maglev.nodes[g_maglev.lookup_table[i]]->name);
-        } else {
-            printf("%*s ", field_width, "?");
-        }
+    const TableVersion *version = table_history_get(steps);
+    if (steps == 0 || !version) {
+        return MAGLEV_ERANGE;
     }
-    printf("\n");
-
-    if (g_maglev.table_size > 100) {
-        printf("... (showing first 100 out of %u total slots)\n", g_maglev.table_size);
+    if (version->table_size != g_maglev.table_size) {
+        return MAGLEV_ESIZE;
     }
 
-    free(node_counts);
-}
+    uint64_t start = timer_now_ns();
+    uint32_t node_count = version->node_count;
+    Node **nodes = malloc((node_count ? node_count : 1) * sizeof(Node *));
+    bool *fresh = calloc(node_count ? node_count : 1, sizeof(bool));
+    bool *kept = calloc(MAX_NODES, sizeof(bool));
+    bool ok = nodes && fresh && kept;
 
-// Predefined color array - includes more 256-color mode colors
-static int color_palette[] = {
-    // Standard 16 colors (avoid black and dark colors)
-    31, 32, 33, 34, 35, 36, 37,         // red, green, yellow, blue, magenta, cyan, white
-    91, 92, 93, 94, 95, 96, 97,         // bright red, bright green, bright yellow, bright blue, bright magenta, bright cyan, bright white
-
-    // Selected 256-color mode colors (using 38;5;n format)
-    // Red series
-    196, 197, 198, 199, 200, 201, 202, 203, 204, 205,
-    // Green series
-    46, 47, 48, 49, 50, 82, 83, 84, 85, 86,
-    // Yellow series
-    220, 221, 222, 223, 224, 225, 226, 227, 228, 229,
-    // Blue series
-    21, 26, 27, 32, 33, 38, 39, 44, 45, 75,
-    // Magenta/Pink series
-    207, 213, 219, 225, 165, 171, 177, 183, 189, 195,
-    // Cyan series
-    51, 87, 123, 159, 14, 80, 116, 152, 188, 194,
-    // Purple series
-    129, 135, 141, 147, 153, 93, 99, 105, 111, 117,
-    // Orange series
-    166, 172, 178, 184, 190, 208, 214, 215, 216, 217,
-    // Gray series
-    244, 245, 246, 247, 248, 249, 250, 251, 252, 253,
-    // Special colors
-    11, 12, 13, 14, 15, 76, 77, 78, 79, 118, 119, 120, 121, 122
-};
-
-// Assign unique color index
-int assign_unique_color_index(void) {
-    static bool seeded = false;
-    if (!seeded) {
-        srand((unsigned int)time(NULL));
-        seeded = true;
-    }
-
-    int color_count = sizeof(color_palette) / sizeof(color_palette[0]);
-
-    // Create array to mark used colors
-    bool used_colors[color_count];
-    for (int i = 0; i < color_count; i++) {
-        used_colors[i] = false;
-    }
-
-    // Check colors used by existing nodes
-    if (g_maglev.is_initialized) {
-        for (uint32_t i = 0; i < g_maglev.node_count; i++) {
-            if (g_maglev.nodes[i] && g_maglev.nodes[i]->color_index >= 0 && g_maglev.nodes[i]->color_index < color_count) {
-                used_colors[g_maglev.nodes[i]->color_index] = true;
-            }
+    // Reuse live nodes by name; recreate the ones removed since (lists pending)
+    uint32_t recreated = 0;
+    for (uint32_t i = 0; ok && i < node_count; i++) {
+        int j = find_node_index(version->names[i]);
+        if (j >= 0) {
+            nodes[i] = g_maglev.nodes[j];
+            kept[j] = true;
+            continue;
         }
-    }
-
-    // First try to assign unused colors
-    int available_colors[color_count];
-    int available_count = 0;
-
-    for (int i = 0; i < color_count; i++) {
-        if (!used_colors[i]) {
-            available_colors[available_count++] = i;
+        nodes[i] = node_alloc(version->names[i], g_maglev.table_size);
+        ok = nodes[i] != NULL;
+        fresh[i] = ok;
+        recreated += ok;
+    }
+
+    uint32_t *table = NULL, *backup = NULL;
+    bool instant = false;
+    ok = ok && table_history_checkout(steps, &table, &backup, &instant);
+    if (!ok) {
+        for (uint32_t i = 0; nodes && fresh && i < node_count; i++) {
+            if (fresh[i]) node_destroy(nodes[i]);
+        }
+        free(nodes);
+        free(fresh);
+        free(kept);
+        return MAGLEV_ENOMEM;
+    }
+    uint64_t prepared = timer_now_ns();
+
+    // Under the lock: pointer swaps and O(nodes) bookkeeping only
+    maglev_lock();
+    uint32_t *old_table = g_maglev.lookup_table;
+    uint32_t *old_backup = g_maglev.backup_table;
+    g_maglev.lookup_table = table;
+    g_maglev.backup_table = backup;
+
+    Node *dropped[MAX_NODES];
+    uint32_t dropped_count = 0;
+    for (uint32_t j = 0; j < g_maglev.node_count; j++) {
+        if (!kept[j]) {
+            dropped[dropped_count++] = g_maglev.nodes[j];
         }
     }
-
-    // If there are unused colors, randomly select one
-    if (available_count > 0) {
-        int chosen_index = available_colors[rand() % available_count];
-        return chosen_index;
-    }
-
-    // If all colors are used, randomly select one (when node count exceeds color count)
-    return rand() % color_count;
+    for (uint32_t i = node_count; i < g_maglev.node_count; i++) {
+        g_maglev.nodes[i] = NULL;
+    }
+    memcpy(g_maglev.nodes, nodes, node_count * sizeof(Node *));
+    g_maglev.node_count = node_count;
+    for (uint32_t i = 0; i < node_count; i++) {
+        g_maglev.nodes[i]->is_active = !version->down[i];
+    }
+
+    change->restored_generation = version->generation;
+    maglev_bump_generation();
+    maglev_publish_snapshot();
+    g_maglev.slot_index_stale = true;
+    maglev_unlock();
+    uint64_t published = timer_now_ns();
+    free(old_table);
+    free(old_backup);
+
+    // Derived from the restored version, so the record shares all of its chunks
+    table_history_set_base(version);
+    maglev_record_published();
+
+    // No table references the dropped nodes any more, and the worker is idle
+    for (uint32_t i = 0; i < dropped_count; i++) {
+        node_destroy(dropped[i]);
+    }
+    free(nodes);
+    free(fresh);
+    free(kept);
+
+    change->node_count = node_count;
+    change->recreated = recreated;
+    change->instant = instant;
+    change->checkout_ns = prepared - start;
+    change->rebuild_ns = published - prepared;
+    return MAGLEV_OK;
 }
 
-// Print colored text
-void print_colored_text(const char *text, int color_index) {
-    int color_count = sizeof(color_palette) / sizeof(color_palette[0]);
-
-    if (color_index < 0 || color_index >= color_count) {
-        printf("%s", text);  // If index is invalid, print text without color
-        return;
-    }
-
-    int color_code = color_palette[color_index];
-
-    // Determine if it's traditional 16-color or 256-color
-    if (color_code <= 97) {
-        // Traditional 16-color format
-        printf("\033[%dm%s\033[0m", color_code, text);
-    } else {
-        // 256-color format
-        printf("\033[38;5;%dm%s\033[0m", color_code, text);
+// Slot ownership index of the published table (lock held)
+const SlotIndex *maglev_slot_index(void) {
+    if (g_maglev.slot_index_stale) {
+        slot_index_build(&g_maglev.slot_index, g_maglev.lookup_table, g_maglev.table_size,
+                         g_maglev.table_node_count);
+        g_maglev.slot_index_stale = false;
     }
+    return &g_maglev.slot_index;
 }
 
-// Show colored Maglev table
-void maglev_show_table_colored(void) {
-    if (!g_maglev.is_initialized) {
-        printf("Maglev table not initialized\n");
-        return;
-    }
-
-    printf("Maglev lookup table (size: %u) - Colored:\n", g_maglev.table_size);
-
-    if (g_maglev.node_count == 0) {
-        printf("  (empty - no nodes)\n");
-        return;
-    }
-
-    // Count assignment for each node
-    uint32_t *node_counts = calloc(g_maglev.node_count, sizeof(uint32_t));
-    if (!node_counts) {
-        printf("Error: Memory allocation failed\n");
-        return;
-    }
-
-    uint32_t unassigned = 0;
-
-    for (uint32_t i = 0; i < g_maglev.table_size; i++) {
-        if (g_maglev.lookup_table[i] == UINT32_MAX) {
-            unassigned++;
-        } else if (g_maglev.lookup_table[i] < g_maglev.node_count) {
-            node_counts[g_maglev.lookup_table[i]]++;
+// Generate preference lists left pending by a rollback
+void maglev_generate_pending_lists(Node *const *nodes, uint32_t count) {
+    Node *pending[MAX_NODES];
+    uint32_t pending_count = 0;
+    for (uint32_t i = 0; i < count; i++) {
+        if (nodes[i]->list_pending) {
+            pending[pending_count++] = nodes[i];
         }
     }
-
-    // Show statistics (with colors)
-    printf("Distribution summary:\n");
-    for (uint32_t i = 0; i < g_maglev.node_count; i++) {
-        if (g_maglev.nodes[i]) {
-            printf("  ");
-            print_colored_text(g_maglev.nodes[i]->name, g_maglev.nodes[i]->color_index);
-            printf(": %u slots (%.2f%%)\n",
-                   node_counts[i],
-                   100.0 * node_counts[i] / g_maglev.table_size);
-        }
+    if (pending_count > 0) {
+        preference_pool_generate(pending, pending_count, g_maglev.table_size, 0);
     }
+}
 
-    if (unassigned > 0) {
-        printf("  Unassigned: %u slots (%.2f%%)\n",
-               unassigned, 100.0 * unassigned / g_maglev.table_size);
+// Refresh failure flags of the published node snapshot (lock held or no worker)
+void maglev_publish_down_flags(void) {
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        Node *node = g_maglev.table_nodes[i];
+        g_maglev.table_node_down[i] = (node && !node->is_active) ? 1 : 0;
     }
+}
 
-    // Show detailed assignment for first 100 slots (or all if table is smaller)
-    uint32_t show_count = (g_maglev.table_size < 100) ? g_maglev.table_size : 100;
-    int field_width = get_max_node_name_length();
-    int items_per_line = (field_width <= 10) ? 10 : 8;  // Adjust items per line based on name length
-
-    printf("\nFirst %u slots:\n", show_count);
-
-    for (uint32_t i = 0; i < show_count; i++) {
-        if (i % items_per_line == 0) {
-            printf("\n%4u: ", i);
-        }
+// Owner of a slot, redirected through the backup table if the owner is failed
+uint32_t maglev_resolve_slot(uint32_t slot) {
+    return maglev_resolve(g_maglev.lookup_table, g_maglev.backup_table, g_maglev.table_node_down,
+                          g_maglev.table_node_count, g_maglev.table_size, slot);
+}
 
-        if (g_maglev.lookup_table[i] == UINT32_MAX) {
-            printf("%*s ", field_width, "-");
-        } else if (g_maglev.lookup_table[i] < g_maglev.node_count && g_maglev.nodes[g_maglev.lookup_table[i]]) {
-            const char *node_name = g_maglev.nodes[g_maglev.lookup_table[i]]->name;
-            int name_len = strlen(node_name);
-            int left_padding = (field_width - name_len) / 2;
-            int right_padding = field_width - name_len - left_padding;
-
-            printf("%*s", left_padding, "");  // Left padding
-            print_colored_text(node_name, g_maglev.nodes[g_maglev.lookup_table[i]]->color_index);
-            printf("%*s ", right_padding, "");  // Right padding
-        } else {
-            printf("%*s ", field_width, "?");
-        }
+// Map a flow key hash to its owning node index
+uint32_t maglev_lookup(uint64_t key_hash) {
+    if (!g_maglev.is_initialized) {
+        return UINT32_MAX;
     }
-    printf("\n");
+    uint32_t owner = maglev_resolve_slot(maglev_slot(key_hash, g_maglev.table_size));
 
-    if (g_maglev.table_size > 100) {
-        printf("... (showing first 100 out of %u total slots)\n", g_maglev.table_size);
+    LoadShard *shard = load_stats_shard(LOAD_LOOKUP_SHARD);
+    if (shard) {
+        load_stats_count_one(shard, owner < g_maglev.table_node_count ? owner : g_maglev.table_node_count, key_hash);
     }
-
-    free(node_counts);
-}
\ No newline at end of file
+    return owner;
+}
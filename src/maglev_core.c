@@ -0,0 +1,228 @@
+#include "maglev_core.h"
+#include "node.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Check if a number is prime
+bool is_prime(uint32_t n) {
+    if (n < 2) return false;
+    if (n == 2) return true;
+    if (n % 2 == 0) return false;
+
+    for (uint32_t i = 3; i <= n / i; i += 2) {
+        if (n % i == 0) return false;
+    }
+    return true;
+}
+
+// Find the next prime number
+uint32_t next_prime(uint32_t n) {
+    while (!is_prime(n)) {
+        n++;
+    }
+    return n;
+}
+
+// Find the next power of two (sizes above 2^31 are clamped)
+uint32_t next_pow2(uint32_t n) {
+    if (n > (1u << 31)) {
+        return 1u << 31;
+    }
+    uint32_t p = 1;
+    while (p < n) {
+        p <<= 1;
+    }
+    return p;
+}
+
+bool slot_index_alloc(SlotIndex *index, uint32_t table_size) {
+    index->start = calloc(MAX_NODES + 1, sizeof(uint32_t));
+    index->slots = malloc((size_t)table_size * sizeof(uint32_t));
+    if (!index->start || !index->slots) {
+        slot_index_free(index);
+        return false;
+    }
+    return true;
+}
+
+void slot_index_free(SlotIndex *index) {
+    free(index->start);
+    free(index->slots);
+    index->start = NULL;
+    index->slots = NULL;
+}
+
+// Counting pass over the table: one pass for the counts, one to place slots
+void slot_index_build(SlotIndex *index, const uint32_t *table, uint32_t table_size, uint32_t node_count) {
+    memset(index->start, 0, (node_count + 1) * sizeof(uint32_t));
+    for (uint32_t slot = 0; slot < table_size; slot++) {
+        if (table[slot] < node_count) {
+            index->start[table[slot] + 1]++;
+        }
+    }
+
+    uint32_t cursor[MAX_NODES];
+    for (uint32_t i = 0; i < node_count; i++) {
+        index->start[i + 1] += index->start[i];
+        cursor[i] = index->start[i];
+    }
+    for (uint32_t slot = 0; slot < table_size; slot++) {
+        if (table[slot] < node_count) {
+            index->slots[cursor[table[slot]]++] = slot;
+        }
+    }
+}
+
+// Fill a lookup table from a node list (Core Maglev algorithm).
+// If backup is given, each slot also records the first other node that
+// wanted it, which is where the slot would most likely go without its owner.
+void maglev_fill_table(uint32_t *table, uint32_t *backup, SlotIndex *index,
+                       uint32_t table_size, Node *const *nodes, uint32_t node_count) {
+    // Clear lookup table
+    for (uint32_t i = 0; i < table_size; i++) {
+        table[i] = UINT32_MAX;
+    }
+    if (backup) {
+        for (uint32_t i = 0; i < table_size; i++) {
+            backup[i] = UINT32_MAX;
+        }
+    }
+
+    if (index) {
+        memset(index->start, 0, (node_count + 1) * sizeof(uint32_t));
+    }
+    if (node_count == 0) {
+        return;
+    }
+
+    // Reset all nodes' index pointers and latch their state, so a node
+    // failing mid-fill cannot leave the loop without active nodes
+    uint8_t active[MAX_NODES];
+    uint32_t active_count = 0;
+    for (uint32_t i = 0; i < node_count; i++) {
+        node_reset_index(nodes[i]);
+        active[i] = nodes[i] && nodes[i]->is_active;
+        active_count += active[i];
+    }
+
+    if (active_count == 0) {
+        return;
+    }
+
+    // Every round gives each active node exactly one slot, so the counts are
+    // known up front: the first table_size % active_count active nodes get
+    // one more. Lay the index out now and fill it as slots are claimed.
+    uint32_t cursor[MAX_NODES];
+    if (index) {
+        uint32_t per_node = table_size / active_count;
+        uint32_t extra = table_size % active_count;
+        uint32_t rank = 0;
+        for (uint32_t i = 0; i < node_count; i++) {
+            uint32_t count = 0;
+            if (active[i]) {
+                count = per_node + (rank < extra ? 1 : 0);
+                rank++;
+            }
+            cursor[i] = index->start[i];
+            index->start[i + 1] = index->start[i] + count;
+        }
+    }
+
+    // Standard Maglev algorithm: round-robin assignment
+    uint32_t filled = 0;
+
+    // Keep polling until all positions are filled
+    while (filled < table_size) {
+        // In each round, every node tries to get the next position from its preference list
+        for (uint32_t i = 0; i < node_count; i++) {
+            Node *node = nodes[i];
+            if (!active[i]) continue;
+
+            // If this node still has untried preference positions
+            while (node->next_index < table_size) {
+                uint32_t preferred_slot = node->preference_list[node->next_index];
+                node->next_index++;
+
+                // If this position is free, assign it to the current node
+                if (table[preferred_slot] == UINT32_MAX) {
+                    table[preferred_slot] = i;
+                    if (index) {
+                        index->slots[cursor[i]++] = preferred_slot;
+                    }
+                    filled++;
+                    break; // This node got a position in this round, move to next node
+                }
+
+                // Taken: the first contender becomes the slot's backup owner
+                if (backup && backup[preferred_slot] == UINT32_MAX) {
+                    backup[preferred_slot] = i;
+                }
+            }
+
+            // If all positions are filled, exit early
+            if (filled >= table_size) {
+                break;
+            }
+        }
+    }
+
+    if (!backup) {
+        return;
+    }
+
+    // Uncontested slots fall back to the next active node after the owner
+    for (uint32_t slot = 0; slot < table_size; slot++) {
+        if (backup[slot] != UINT32_MAX) continue;
+
+        uint32_t owner = table[slot];
+        for (uint32_t k = 1; k < node_count; k++) {
+            uint32_t candidate = (owner + k) % node_count;
+            if (active[candidate]) {
+                backup[slot] = candidate;
+                break;
+            }
+        }
+    }
+}
+
+// Compact fill: identical assignment to maglev_fill_table for a list of
+// active nodes, but permutations are stepped instead of read from lists
+void maglev_fill_compact(uint32_t *table, uint32_t table_size, const uint32_t *offset,
+                         const uint32_t *skip, uint32_t count, uint32_t *cursor) {
+    for (uint32_t i = 0; i < table_size; i++) {
+        table[i] = UINT32_MAX;
+    }
+    if (count == 0) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        cursor[i] = offset[i];
+    }
+
+    // A permutation visits every slot, so each turn finds a free one
+    uint32_t filled = 0;
+    for (;;) {
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t slot = cursor[i];
+            while (table[slot] != UINT32_MAX) {
+                slot += skip[i];
+                if (slot >= table_size) {
+                    slot -= table_size;
+                }
+            }
+
+            table[slot] = i;
+            slot += skip[i];
+            if (slot >= table_size) {
+                slot -= table_size;
+            }
+            cursor[i] = slot;
+
+            if (++filled == table_size) {
+                return;
+            }
+        }
+    }
+}
@@ -1,4 +1,22 @@
 #include "maglev.h"
+#include "cli.h"
+#include "simulate.h"
+#include "rebuild_worker.h"
+#include "timer.h"
+#include "table_export.h"
+#include "compare.h"
+#include "preference_pool.h"
+#include "shm_publish.h"
+#include "delta.h"
+#include "load_stats.h"
+#include "des.h"
+#include "bounded_load.h"
+#include "churn.h"
+#include "hier.h"
+#include "fleet.h"
+#include "profile.h"
+#include "table_history.h"
+#include "outbuf.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -12,10 +30,30 @@
 // Command type enumeration
 typedef enum {
     CMD_INIT,
+    CMD_RESIZE,
     CMD_ADD_NODE,
     CMD_DEL_NODE,
+    CMD_FAIL_NODE,
+    CMD_RECOVER_NODE,
     CMD_SHOW_NODES,
     CMD_SHOW_MAGLEV,
+    CMD_SIMULATE,
+    CMD_LOAD,
+    CMD_DES,
+    CMD_CHURN,
+    CMD_HIER,
+    CMD_FLEET,
+    CMD_PROFILE,
+    CMD_BOUNDED,
+    CMD_ASYNC,
+    CMD_SYNC,
+    CMD_HISTORY,
+    CMD_ROLLBACK,
+    CMD_EXPORT,
+    CMD_EXPORT_DELTA,
+    CMD_APPLY_DELTA,
+    CMD_COMPARE,
+    CMD_SHM,
     CMD_HELP,
     CMD_QUIT,
     CMD_UNKNOWN
@@ -24,15 +62,53 @@ typedef enum {
 // Candidate list for command completion
 static char *commands[] = {
     "init",
+    "resize",
     "add",
     "del",
+    "fail",
+    "recover",
     "show",
+    "simulate",
+    "load",
+    "des",
+    "churn",
+    "hier",
+    "fleet",
+    "profile",
+    "bounded",
+    "async",
+    "sync",
+    "history",
+    "rollback",
+    "keep",
+    "export",
+    "export-delta",
+    "apply-delta",
+    "compare",
+    "shm",
     "help",
     "quit",
     "exit",
     "nodes",
     "maglev",
     "maglev-color",
+    "load",
+    "on",
+    "reset",
+    "uniform",
+    "zipf",
+    "hotspot",
+    "all",
+    "csv",
+    "pow2",
+    "sizing",
+    "threads",
+    "kernels",
+    "json",
+    "publish",
+    "status",
+    "bench",
+    "off",
     NULL
 };
 
@@ -64,7 +140,9 @@ char **command_completion(const char *text, int start, int end) {
     (void)end;
 
     // Only provide command completion at the beginning of line or at certain specific positions
-    if (start == 0 || (start > 0 && strncmp(rl_line_buffer, "show ", 5) == 0)) {
+    if (start == 0 || (start > 0 && strncmp(rl_line_buffer, "show ", 5) == 0) ||
+        (start > 0 && strncmp(rl_line_buffer, "simulate ", 9) == 0) ||
+        (start > 0 && strncmp(rl_line_buffer, "shm ", 4) == 0)) {
         return rl_completion_matches(text, command_generator);
     }
 
@@ -108,12 +186,52 @@ int parse_arguments(char *input, char **args) {
 CommandType identify_command(const char *cmd) {
     if (strcmp(cmd, "init") == 0) {
         return CMD_INIT;
+    } else if (strcmp(cmd, "resize") == 0) {
+        return CMD_RESIZE;
     } else if (strcmp(cmd, "add") == 0) {
         return CMD_ADD_NODE;
     } else if (strcmp(cmd, "del") == 0) {
         return CMD_DEL_NODE;
+    } else if (strcmp(cmd, "fail") == 0) {
+        return CMD_FAIL_NODE;
+    } else if (strcmp(cmd, "recover") == 0) {
+        return CMD_RECOVER_NODE;
     } else if (strcmp(cmd, "show") == 0) {
         return CMD_SHOW_NODES;  // Needs further parsing
+    } else if (strcmp(cmd, "simulate") == 0) {
+        return CMD_SIMULATE;
+    } else if (strcmp(cmd, "bounded") == 0) {
+        return CMD_BOUNDED;
+    } else if (strcmp(cmd, "des") == 0) {
+        return CMD_DES;
+    } else if (strcmp(cmd, "churn") == 0) {
+        return CMD_CHURN;
+    } else if (strcmp(cmd, "hier") == 0) {
+        return CMD_HIER;
+    } else if (strcmp(cmd, "fleet") == 0) {
+        return CMD_FLEET;
+    } else if (strcmp(cmd, "profile") == 0) {
+        return CMD_PROFILE;
+    } else if (strcmp(cmd, "load") == 0) {
+        return CMD_LOAD;
+    } else if (strcmp(cmd, "async") == 0) {
+        return CMD_ASYNC;
+    } else if (strcmp(cmd, "sync") == 0) {
+        return CMD_SYNC;
+    } else if (strcmp(cmd, "history") == 0) {
+        return CMD_HISTORY;
+    } else if (strcmp(cmd, "rollback") == 0) {
+        return CMD_ROLLBACK;
+    } else if (strcmp(cmd, "export") == 0) {
+        return CMD_EXPORT;
+    } else if (strcmp(cmd, "export-delta") == 0) {
+        return CMD_EXPORT_DELTA;
+    } else if (strcmp(cmd, "apply-delta") == 0) {
+        return CMD_APPLY_DELTA;
+    } else if (strcmp(cmd, "compare") == 0) {
+        return CMD_COMPARE;
+    } else if (strcmp(cmd, "shm") == 0) {
+        return CMD_SHM;
     } else if (strcmp(cmd, "help") == 0) {
         return CMD_HELP;
     } else if (strcmp(cmd, "quit") == 0 || strcmp(cmd, "exit") == 0) {
@@ -126,12 +244,56 @@ CommandType identify_command(const char *cmd) {
 // Show help information
 void show_help(void) {
     printf("\nGoogle Maglev Simulator Commands:\n");
-    printf("  init <size>          - Initialize lookup table with given size\n");
+    printf("  init <size> [pow2]   - Initialize lookup table with given size (prime, or power of two)\n");
+    printf("  resize <size>        - Change the table size keeping all nodes, rebuild once\n");
     printf("  add <name>           - Add a new node (error if exists)\n");
+    printf("  add <name> <name>... - Add several nodes at once (web[01-64] adds a numbered range),\n");
+    printf("                         preference lists generated in parallel, one rebuild\n");
     printf("  del <name>           - Delete a node (ignore if not exists)\n");
+    printf("  fail <name>          - Mark a node failed, redirect its slots to backup owners\n");
+    printf("  recover <name>       - Bring a failed node back\n");
     printf("  show nodes           - Show current nodes\n");
+    printf("  show node <name>     - Show a node's slots and table share\n");
     printf("  show maglev          - Show complete maglev lookup table\n");
     printf("  show maglev-color    - Show maglev lookup table with colored nodes\n");
+    printf("  show maglev[-color] all - Show every slot, run-length encoded\n");
+    printf("  show load            - Show traffic counted per backend against its slot share\n");
+    printf("  export <file> [csv|json] - Export the full table, run-length encoded\n");
+    printf("  export-delta <file>  - Write the changes since the last export-delta, for syncing LBs\n");
+    printf("  apply-delta <file>   - Apply a delta to the local replica and verify its fingerprint\n");
+    printf("  simulate <uniform|zipf|hotspot> [keys] [flows] [param] [threads]\n");
+    printf("                       - Push a skewed key stream through the table and report load\n");
+    printf("                         (param: zipf exponent, or hotspot traffic share)\n");
+    printf("  bounded <uniform|zipf|hotspot> [keys] [inflight] [threads]\n");
+    printf("                       - Bounded-load lookup: max backend load and cost vs epsilon\n");
+    printf("  des <scenario>       - Discrete-event queueing simulation with a membership timeline\n");
+    printf("  churn gen <rolling|zone|steady> <file> [backends] [events] [table_size]\n");
+    printf("                       - Generate a membership churn command script\n");
+    printf("  churn run <file> [rate] - Replay it quietly: rebuild latency, CPU time, peak RSS\n");
+    printf("  load <on|off|reset>  - Count per-backend hits and bytes on the lookup path\n");
+    printf("  load bench [threads] [lookups]\n");
+    printf("                       - Lookup throughput with counters off vs on\n");
+    printf("  hier [pools] [backends_per_pool] [pool_table] [top_table]\n");
+    printf("                       - Two-level (pool, backend) Maglev vs a flat table of the same size\n");
+    printf("  fleet [instances] [changes] [delay_ms] [jitter_ms] [interval_ms] [threads]\n");
+    printf("                       - LB fleet with staggered change propagation: flow inconsistency per change\n");
+    printf("  profile <command>    - Run a command under hardware counters, split into\n");
+    printf("                         preference, fill and lookup phases\n");
+    printf("  compare [nodes] [table_size] [keys]\n");
+    printf("                       - Benchmark maglev, ring, rendezvous and jump hashing\n");
+    printf("                         (nodes 0 or omitted: use the current nodes)\n");
+    printf("  compare sizing [nodes] [table_size] [keys]\n");
+    printf("                       - Prime vs power-of-two table: balance and lookup cost\n");
+    printf("  compare threads [nodes] [table_size] [max_threads]\n");
+    printf("                       - Parallel preference list generation from 1 to all cores\n");
+    printf("  compare kernels [keys] - Generic vs size-specialized permutation and slot kernels\n");
+    printf("  shm publish <name>   - Mirror the table into POSIX shared memory (e.g. /maglev)\n");
+    printf("  shm status|off       - Show publishing statistics / stop publishing\n");
+    printf("  shm bench [seconds]  - Reader process lookup rate while membership churns\n");
+    printf("  async <on|off>       - Rebuild on a background worker, coalescing bursts of changes\n");
+    printf("  sync                 - Wait for the latest generation and show rebuild statistics\n");
+    printf("  history [keep <n>]   - Show kept table versions and their memory / keep the last n (0: off)\n");
+    printf("  rollback [n]         - Republish the table from n versions back (default 1)\n");
     printf("  help                 - Show this help message\n");
     printf("  quit/exit            - Exit the simulator\n");
     printf("\nExample:\n");
@@ -141,14 +303,40 @@ void show_help(void) {
     printf("  > show nodes\n");
     printf("  > show maglev\n");
     printf("  > show maglev-color\n");
+    printf("  > simulate zipf 10000000\n");
     printf("  > del server1\n");
     printf("\n");
 }
 
+// Parse an unsigned integer argument, returns false on garbage
+static bool parse_u64_arg(const char *arg, uint64_t *value) {
+    char *endptr;
+    unsigned long long v = strtoull(arg, &endptr, 10);
+    if (*arg == '\0' || *arg == '-' || *endptr != '\0') {
+        return false;
+    }
+    *value = v;
+    return true;
+}
+
+// Report a failed control-plane call; name is the node it concerns (may be NULL)
+static void report_status(MaglevStatus status, const char *name) {
+    if (name && status == MAGLEV_EEXIST) {
+        printf("Error: Node '%s' already exists\n", name);
+    } else if (name && status == MAGLEV_EDUP) {
+        printf("Error: Node '%s' given more than once\n", name);
+    } else if (name && status == MAGLEV_ENOENT) {
+        printf("Error: Node '%s' does not exist\n", name);
+    } else {
+        printf("Error: %s\n", maglev_strerror(status));
+    }
+}
+
 // Handle init command
 void handle_init_command(int argc, char **args) {
-    if (argc != 2) {
-        printf("Usage: init <table_size>\n");
+    bool pow2 = argc == 3 && strcmp(args[2], "pow2") == 0;
+    if (argc != 2 && !pow2) {
+        printf("Usage: init <table_size> [pow2]\n");
         return;
     }
 
@@ -160,19 +348,155 @@ void handle_init_command(int argc, char **args) {
         return;
     }
 
-    if (!maglev_init((uint32_t)table_size)) {
+    if (pow2 && table_size > (1l << 31)) {
+        printf("Error: Power-of-two tables are limited to 2^31 slots\n");
+        return;
+    }
+
+    if (maglev_init((uint32_t)table_size, pow2) != MAGLEV_OK) {
         printf("Error: Failed to initialize Maglev table\n");
+        return;
+    }
+    if (cli_is_verbose()) {
+        printf("Maglev table initialized with size: %u%s%s\n", g_maglev.table_size,
+               pow2 ? " (power of two: odd skips, mask lookup)" : "",
+               g_maglev.kernel->table_size ? " (size-specialized kernels)" : "");
     }
 }
 
-// Handle add command
-void handle_add_command(int argc, char **args) {
+// Handle resize command
+void handle_resize_command(int argc, char **args) {
+    uint64_t table_size;
     if (argc != 2) {
-        printf("Usage: add <node_name>\n");
+        printf("Usage: resize <table_size>\n");
         return;
     }
 
-    maglev_add_node(args[1]);
+    if (!parse_u64_arg(args[1], &table_size) || table_size == 0 || table_size > UINT32_MAX / 2) {
+        printf("Error: Invalid table size '%s'\n", args[1]);
+        return;
+    }
+
+    MaglevChange change;
+    MaglevStatus status = maglev_resize((uint32_t)table_size, &change);
+    if (status != MAGLEV_OK) {
+        report_status(status, NULL);
+        return;
+    }
+    if (change.unchanged) {
+        printf("Table size is already %u\n", g_maglev.table_size);
+        return;
+    }
+
+    printf("Table resized from %u to %u slots with %u nodes in %.2f ms\n",
+           change.old_table_size, g_maglev.table_size, change.node_count,
+           (change.lists_ns + change.rebuild_ns) / 1e6);
+    printf("  Preference lists: %.2f ms (%u thread%s), rebuild: %.2f ms\n",
+           change.lists_ns / 1e6, change.threads, change.threads == 1 ? "" : "s",
+           change.rebuild_ns / 1e6);
+    printf("  Keys moved: %.2f%% of %u sample keys\n", 100.0 * change.moved, change.sample_keys);
+}
+
+// Expand "name[first-last]" into numbered names (name01 .. name12 for
+// [01-12]: the width of first is kept). Anything else is a single name.
+// Returns the number of names written, 0 on error.
+static uint32_t expand_node_names(const char *arg, char names[][MAX_NODE_NAME_LEN], uint32_t capacity) {
+    const char *open = strchr(arg, '[');
+    size_t len = strlen(arg);
+    if (!open || len < 2 || arg[len - 1] != ']') {
+        if (capacity == 0 || len >= MAX_NODE_NAME_LEN) return 0;
+        strcpy(names[0], arg);
+        return 1;
+    }
+
+    char first_buf[16], last_buf[16];
+    const char *dash = strchr(open, '-');
+    size_t first_len = dash ? (size_t)(dash - open - 1) : 0;
+    size_t last_len = dash ? (size_t)(arg + len - 1 - dash - 1) : 0;
+    if (!dash || first_len == 0 || first_len >= sizeof(first_buf) ||
+        last_len == 0 || last_len >= sizeof(last_buf)) {
+        return 0;
+    }
+    memcpy(first_buf, open + 1, first_len);
+    first_buf[first_len] = '\0';
+    memcpy(last_buf, dash + 1, last_len);
+    last_buf[last_len] = '\0';
+
+    uint64_t first, last;
+    if (!parse_u64_arg(first_buf, &first) || !parse_u64_arg(last_buf, &last) ||
+        last < first || last - first >= capacity) {
+        return 0;
+    }
+
+    int prefix_len = (int)(open - arg);
+    for (uint64_t n = first; n <= last; n++) {
+        int written = snprintf(names[n - first], MAX_NODE_NAME_LEN, "%.*s%0*llu",
+                               prefix_len, arg, (int)first_len, (unsigned long long)n);
+        if (written < 0 || written >= MAX_NODE_NAME_LEN) return 0;
+    }
+    return (uint32_t)(last - first + 1);
+}
+
+// Handle add command: one node, or a batch whose preference lists are
+// generated in parallel before a single rebuild
+void handle_add_command(int argc, char **args) {
+    if (argc < 2) {
+        printf("Usage: add <node_name> [node_name...]  (name[first-last] adds a numbered range)\n");
+        return;
+    }
+
+    if (argc == 2 && !strchr(args[1], '[')) {
+        MaglevStatus status = maglev_add_node(args[1]);
+        if (status == MAGLEV_ENOMEM) {
+            printf("Error: Failed to create node '%s'\n", args[1]);
+        } else if (status != MAGLEV_OK) {
+            report_status(status, args[1]);
+        } else if (cli_is_verbose()) {
+            printf("Node '%s' added successfully\n", args[1]);
+        }
+        return;
+    }
+
+    char (*names)[MAX_NODE_NAME_LEN] = malloc(MAX_NODES * sizeof(*names));
+    const char **list = malloc(MAX_NODES * sizeof(char *));
+    if (!names || !list) {
+        printf("Error: Memory allocation failed\n");
+        free(names);
+        free(list);
+        return;
+    }
+
+    uint32_t count = 0;
+    for (int i = 1; i < argc; i++) {
+        uint32_t added = expand_node_names(args[i], names + count, MAX_NODES - count);
+        if (added == 0) {
+            printf("Error: Invalid node name or range '%s' (at most %d nodes)\n", args[i], MAX_NODES);
+            free(names);
+            free(list);
+            return;
+        }
+        count += added;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        list[i] = names[i];
+    }
+
+    MaglevChange change;
+    MaglevStatus status = maglev_add_nodes(list, count, &change);
+    if (status == MAGLEV_EFULL) {
+        printf("Error: Adding %u nodes would exceed the maximum of %d\n", count, MAX_NODES);
+    } else if (status != MAGLEV_OK) {
+        report_status(status, list[change.failed_index]);
+    } else if (cli_is_verbose()) {
+        printf("%u nodes added in %.2f ms\n", count, (change.lists_ns + change.rebuild_ns) / 1e6);
+        printf("  Preference lists: %.2f ms (%u thread%s), rebuild: %.2f ms%s\n",
+               change.lists_ns / 1e6, change.threads, change.threads == 1 ? "" : "s",
+               change.rebuild_ns / 1e6, change.queued ? " (requested from the async worker)" : "");
+    }
+
+    free(names);
+    free(list);
 }
 
 // Handle del command
@@ -182,24 +506,993 @@ void handle_del_command(int argc, char **args) {
         return;
     }
 
-    maglev_remove_node(args[1]);
+    MaglevChange change;
+    MaglevStatus status = maglev_remove_node(args[1], &change);
+    if (status != MAGLEV_OK) {
+        report_status(status, args[1]);
+    } else if (cli_is_verbose()) {
+        printf(change.unchanged ? "Node '%s' does not exist (ignored)\n"
+                                : "Node '%s' removed successfully\n", args[1]);
+    }
+}
+
+// Handle fail command
+void handle_fail_command(int argc, char **args) {
+    if (argc != 2) {
+        printf("Usage: fail <node_name>\n");
+        return;
+    }
+
+    MaglevChange change;
+    MaglevStatus status = maglev_fail_node(args[1], &change);
+    if (status != MAGLEV_OK) {
+        report_status(status, args[1]);
+        return;
+    }
+    if (change.unchanged) {
+        printf("Node '%s' is already failed\n", args[1]);
+        return;
+    }
+    if (!cli_is_verbose()) {
+        return;
+    }
+
+    printf("Node '%s' marked failed, traffic redirected in %.3f us\n", args[1], change.redirect_ns / 1e3);
+    if (change.queued) {
+        printf("Full rebuild queued on background worker (use 'sync' for latency)\n");
+    } else {
+        printf("Full rebuild (previous failure path) took %.3f ms\n", change.rebuild_ns / 1e6);
+    }
+}
+
+// Handle recover command
+void handle_recover_command(int argc, char **args) {
+    if (argc != 2) {
+        printf("Usage: recover <node_name>\n");
+        return;
+    }
+
+    MaglevChange change;
+    MaglevStatus status = maglev_recover_node(args[1], &change);
+    if (status != MAGLEV_OK) {
+        report_status(status, args[1]);
+    } else if (change.unchanged) {
+        printf("Node '%s' is not failed\n", args[1]);
+    } else if (cli_is_verbose()) {
+        printf("Node '%s' recovered\n", args[1]);
+    }
+}
+
+// Show current node status
+static void show_nodes(void) {
+    if (!g_maglev.is_initialized) {
+        printf("Maglev table not initialized\n");
+        return;
+    }
+
+    printf("Current nodes (%u total):\n", g_maglev.node_count);
+    if (g_maglev.node_count == 0) {
+        printf("  (no nodes)\n");
+        return;
+    }
+
+    for (uint32_t i = 0; i < g_maglev.node_count; i++) {
+        if (g_maglev.nodes[i]) {
+            printf("  %u: %s%s\n", i, g_maglev.nodes[i]->name,
+                   g_maglev.nodes[i]->is_active ? "" : " (failed)");
+        }
+    }
+}
+
+static int compare_slot(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Show one node's slots from the ownership index: cost follows the node's share
+static void show_node(const char *node_name) {
+    if (!g_maglev.is_initialized) {
+        printf("Maglev table not initialized\n");
+        return;
+    }
+
+    int index = -1;
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        if (strcmp(g_maglev.table_nodes[i]->name, node_name) == 0) {
+            index = (int)i;
+            break;
+        }
+    }
+    if (index < 0) {
+        if (find_node_index(node_name) >= 0) {
+            printf("Node '%s' is not in the published table yet (rebuild pending)\n", node_name);
+        } else {
+            printf("Error: Node '%s' does not exist\n", node_name);
+        }
+        return;
+    }
+
+    const SlotIndex *slot_index = maglev_slot_index();
+    uint32_t first = slot_index->start[index];
+    uint32_t count = slot_index->start[index + 1] - first;
+    uint32_t *slots = malloc((count ? count : 1) * sizeof(uint32_t));
+    if (!slots) {
+        printf("Error: Memory allocation failed\n");
+        return;
+    }
+    memcpy(slots, &slot_index->slots[first], count * sizeof(uint32_t));
+    qsort(slots, count, sizeof(uint32_t), compare_slot);
+
+    // Consecutive slots print as one range
+    OutBuf buf;
+    outbuf_init(&buf, (size_t)count * 8 + 256);
+    uint32_t ranges = 0;
+    size_t line_start = buf.len;
+    for (uint32_t i = 0; i < count; ) {
+        uint32_t j = i;
+        while (j + 1 < count && slots[j + 1] == slots[j] + 1) j++;
+
+        if (buf.len - line_start > 72) {
+            outbuf_putc(&buf, '\n');
+            line_start = buf.len;
+        }
+        outbuf_puts(&buf, buf.len == line_start ? "  " : " ");
+        outbuf_u64(&buf, slots[i]);
+        if (j > i) {
+            outbuf_putc(&buf, '-');
+            outbuf_u64(&buf, slots[j]);
+        }
+        ranges++;
+        i = j + 1;
+    }
+    if (count > 0) {
+        outbuf_putc(&buf, '\n');
+    }
+
+    uint32_t up = 0;
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        up += g_maglev.table_node_down[i] ? 0 : 1;
+    }
+    double ideal = up > 0 ? 100.0 / up : 0.0;
+
+    printf("Node '%s': %u of %u slots (%.2f%%, ideal %.2f%%) in %u range%s%s\n",
+           node_name, count, g_maglev.table_size, 100.0 * count / g_maglev.table_size,
+           g_maglev.table_node_down[index] ? 0.0 : ideal, ranges, ranges == 1 ? "" : "s",
+           g_maglev.table_node_down[index] ? ", failed: served by backup owners" : "");
+    fflush(stdout);
+    if (!outbuf_write(&buf, stdout)) {
+        printf("Error: Failed to write slot list\n");
+    }
+
+    outbuf_free(&buf);
+    free(slots);
+}
+
+// Show complete Maglev table status
+static void show_table(void) {
+    if (!g_maglev.is_initialized) {
+        printf("Maglev table not initialized\n");
+        return;
+    }
+
+    printf("Maglev lookup table (size: %u):\n", g_maglev.table_size);
+
+    if (g_maglev.table_node_count == 0) {
+        printf("  (empty - no nodes)\n");
+        return;
+    }
+
+    // Per-node counts come from the ownership index, no table scan
+    const uint32_t *start = maglev_slot_index()->start;
+    uint32_t unassigned = g_maglev.table_size - start[g_maglev.table_node_count];
+
+    // Show statistics
+    printf("Distribution summary:\n");
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        if (g_maglev.table_nodes[i]) {
+            printf("  %s: %u slots (%.2f%%)\n",
+                   g_maglev.table_nodes[i]->name,
+                   start[i + 1] - start[i],
+                   100.0 * (start[i + 1] - start[i]) / g_maglev.table_size);
+        }
+    }
+
+    if (unassigned > 0) {
+        printf("  Unassigned: %u slots (%.2f%%)\n",
+               unassigned, 100.0 * unassigned / g_maglev.table_size);
+    }
+
+    // Show detailed assignment for first 100 slots (or all if table is smaller)
+    uint32_t show_count = (g_maglev.table_size < 100) ? g_maglev.table_size : 100;
+    int field_width = get_max_node_name_length();
+    int items_per_line = (field_width <= 10) ? 10 : 8;  // Adjust items per line based on name length
+
+    printf("\nFirst %u slots:\n", show_count);
+
+    for (uint32_t i = 0; i < show_count; i++) {
+        if (i % items_per_line == 0) {
+            printf("\n%4u: ", i);
+        }
+
+        if (g_maglev.lookup_table[i] == UINT32_MAX) {
+            printf("%*s ", field_width, "-");
+        } else if (g_maglev.lookup_table[i] < g_maglev.table_node_count && g_maglev.table_nodes[g_maglev.lookup_table[i]]) {
+            printf("%*s ", field_width, g_maglev.table_nodes[g_maglev.lookup_table[i]]->name);
+        } else {
+            printf("%*s ", field_width, "?");
+        }
+    }
+    printf("\n");
+
+    if (g_maglev.table_size > 100) {
+        printf("... (showing first 100 out of %u total slots)\n", g_maglev.table_size);
+    }
+
+}
+
+// Print colored text
+static void print_colored_text(const char *text, int color_code) {
+    if (color_code < 0) {
+        printf("%s", text);  // No color assigned, print text without color
+        return;
+    }
+
+    // Determine if it's traditional 16-color or 256-color
+    if (color_code <= 97) {
+        // Traditional 16-color format
+        printf("\033[%dm%s\033[0m", color_code, text);
+    } else {
+        // 256-color format
+        printf("\033[38;5;%dm%s\033[0m", color_code, text);
+    }
+}
+
+// Show colored Maglev table
+static void show_table_colored(void) {
+    if (!g_maglev.is_initialized) {
+        printf("Maglev table not initialized\n");
+        return;
+    }
+
+    printf("Maglev lookup table (size: %u) - Colored:\n", g_maglev.table_size);
+
+    if (g_maglev.table_node_count == 0) {
+        printf("  (empty - no nodes)\n");
+        return;
+    }
+
+    // Per-node counts come from the ownership index, no table scan
+    const uint32_t *start = maglev_slot_index()->start;
+    uint32_t unassigned = g_maglev.table_size - start[g_maglev.table_node_count];
+
+    // Show statistics (with colors)
+    printf("Distribution summary:\n");
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        if (g_maglev.table_nodes[i]) {
+            printf("  ");
+            print_colored_text(g_maglev.table_nodes[i]->name, cli_node_color(g_maglev.table_nodes[i]));
+            printf(": %u slots (%.2f%%)\n",
+                   start[i + 1] - start[i],
+                   100.0 * (start[i + 1] - start[i]) / g_maglev.table_size);
+        }
+    }
+
+    if (unassigned > 0) {
+        printf("  Unassigned: %u slots (%.2f%%)\n",
+               unassigned, 100.0 * unassigned / g_maglev.table_size);
+    }
+
+    // Show detailed assignment for first 100 slots (or all if table is smaller)
+    uint32_t show_count = (g_maglev.table_size < 100) ? g_maglev.table_size : 100;
+    int field_width = get_max_node_name_length();
+    int items_per_line = (field_width <= 10) ? 10 : 8;  // Adjust items per line based on name length
+
+    printf("\nFirst %u slots:\n", show_count);
+
+    for (uint32_t i = 0; i < show_count; i++) {
+        if (i % items_per_line == 0) {
+            printf("\n%4u: ", i);
+        }
+
+        if (g_maglev.lookup_table[i] == UINT32_MAX) {
+            printf("%*s ", field_width, "-");
+        } else if (g_maglev.lookup_table[i] < g_maglev.table_node_count && g_maglev.table_nodes[g_maglev.lookup_table[i]]) {
+            const char *node_name = g_maglev.table_nodes[g_maglev.lookup_table[i]]->name;
+            int name_len = strlen(node_name);
+            int left_padding = (field_width - name_len) / 2;
+            int right_padding = field_width - name_len - left_padding;
+
+            printf("%*s", left_padding, "");  // Left padding
+            print_colored_text(node_name, cli_node_color(g_maglev.table_nodes[g_maglev.lookup_table[i]]));
+            printf("%*s ", right_padding, "");  // Right padding
+        } else {
+            printf("%*s ", field_width, "?");
+        }
+    }
+    printf("\n");
+
+    if (g_maglev.table_size > 100) {
+        printf("... (showing first 100 out of %u total slots)\n", g_maglev.table_size);
+    }
+
 }
 
 // Handle show command
 void handle_show_command(int argc, char **args) {
+    if (argc == 3 && strcmp(args[1], "node") == 0) {
+        maglev_lock();
+        show_node(args[2]);
+        maglev_unlock();
+        return;
+    }
+
+    if (argc == 3 && strcmp(args[2], "all") == 0 &&
+        (strcmp(args[1], "maglev") == 0 || strcmp(args[1], "maglev-color") == 0)) {
+        maglev_lock();
+        table_show_all(strcmp(args[1], "maglev-color") == 0);
+        maglev_unlock();
+        return;
+    }
+
     if (argc != 2) {
-        printf("Usage: show <nodes|maglev|maglev-color>\n");
+        printf("Usage: show <nodes|node <name>|maglev|maglev-color|load> [all]\n");
         return;
     }
 
     if (strcmp(args[1], "nodes") == 0) {
-        maglev_show_nodes();
+        show_nodes();
+    } else if (strcmp(args[1], "load") == 0) {
+        maglev_lock();
+        load_stats_show();
+        maglev_unlock();
     } else if (strcmp(args[1], "maglev") == 0) {
-        maglev_show_table();
+        maglev_lock();
+        show_table();
+        maglev_unlock();
     } else if (strcmp(args[1], "maglev-color") == 0) {
-        maglev_show_table_colored();
+        maglev_lock();
+        show_table_colored();
+        maglev_unlock();
+    } else {
+        printf("Usage: show <nodes|node <name>|maglev|maglev-color|load> [all]\n");
+    }
+}
+
+// Handle simulate command
+void handle_simulate_command(int argc, char **args) {
+    const char *usage = "Usage: simulate <uniform|zipf|hotspot> [keys] [flows] [param] [threads]\n";
+    if (argc < 2 || argc > 6) {
+        printf("%s", usage);
+        return;
+    }
+
+    KeyDistribution dist;
+    if (!keystream_parse_distribution(args[1], &dist)) {
+        printf("%s", usage);
+        return;
+    }
+
+    SimulateConfig config;
+    keystream_default_config(&config.keys, dist);
+    config.key_count = 10000000;
+    config.threads = 1;
+
+    uint64_t value;
+    if (argc > 2) {
+        if (!parse_u64_arg(args[2], &value) || value == 0) {
+            printf("Error: Invalid key count '%s'\n", args[2]);
+            return;
+        }
+        config.key_count = value;
+    }
+    if (argc > 3) {
+        if (!parse_u64_arg(args[3], &value) || value == 0 || value > UINT32_MAX) {
+            printf("Error: Invalid flow count '%s'\n", args[3]);
+            return;
+        }
+        config.keys.flow_count = (uint32_t)value;
+    }
+    if (argc > 4) {
+        char *endptr;
+        double param = strtod(args[4], &endptr);
+        if (*endptr != '\0' || param <= 0) {
+            printf("Error: Invalid distribution parameter '%s'\n", args[4]);
+            return;
+        }
+        if (dist == KEYDIST_ZIPF) {
+            config.keys.zipf_s = param;
+        } else if (dist == KEYDIST_HOTSPOT) {
+            if (param > 1.0) {
+                printf("Error: Hotspot traffic share must be in (0, 1]\n");
+                return;
+            }
+            config.keys.hot_traffic_share = param;
+        }
+    }
+    if (argc > 5) {
+        if (!parse_u64_arg(args[5], &value) || value == 0 || value > 64) {
+            printf("Error: Invalid thread count '%s'\n", args[5]);
+            return;
+        }
+        config.threads = (uint32_t)value;
+    }
+
+    maglev_lock();
+    simulate_run(&config);
+    maglev_unlock();
+}
+
+// Handle bounded command
+void handle_bounded_command(int argc, char **args) {
+    const char *usage = "Usage: bounded <uniform|zipf|hotspot> [keys] [inflight] [threads]\n";
+    if (argc < 2 || argc > 5) {
+        printf("%s", usage);
+        return;
+    }
+
+    BoundedSweepConfig config;
+    KeyDistribution dist;
+    if (!keystream_parse_distribution(args[1], &dist)) {
+        printf("%s", usage);
+        return;
+    }
+    keystream_default_config(&config.keys, dist);
+    config.key_count = 5000000;
+    config.inflight = 1000;
+    config.threads = 1;
+
+    uint64_t value;
+    if (argc > 2) {
+        if (!parse_u64_arg(args[2], &value) || value == 0) {
+            printf("Error: Invalid key count '%s'\n", args[2]);
+            return;
+        }
+        config.key_count = value;
+    }
+    if (argc > 3) {
+        if (!parse_u64_arg(args[3], &value) || value == 0 || value > 100000000) {
+            printf("Error: Invalid in-flight count '%s'\n", args[3]);
+            return;
+        }
+        config.inflight = (uint32_t)value;
+    }
+    if (argc > 4) {
+        if (!parse_u64_arg(args[4], &value) || value == 0 || value > 64) {
+            printf("Error: Invalid thread count '%s' (1-64)\n", args[4]);
+            return;
+        }
+        config.threads = (uint32_t)value;
+    }
+
+    maglev_lock();
+    bounded_load_sweep(&config);
+    maglev_unlock();
+}
+
+// Copy the current node names (and table size, 0 if not initialized) under
+// the lock, so long simulations can run without holding up the rebuild
+// worker or the shared-memory publisher. *names is NULL if there are none.
+static bool copy_node_names(char (**names)[MAX_NODE_NAME_LEN], uint32_t *count, uint32_t *table_size) {
+    maglev_lock();
+    *count = g_maglev.is_initialized ? g_maglev.node_count : 0;
+    if (table_size) {
+        *table_size = g_maglev.is_initialized ? g_maglev.table_size : 0;
+    }
+    *names = *count ? malloc(*count * sizeof(**names)) : NULL;
+    for (uint32_t i = 0; *names && i < *count; i++) {
+        memcpy((*names)[i], g_maglev.nodes[i]->name, MAX_NODE_NAME_LEN);
+    }
+    maglev_unlock();
+
+    if (*count && !*names) {
+        printf("Error: Memory allocation failed\n");
+        return false;
+    }
+    return true;
+}
+
+// Handle des command
+void handle_des_command(int argc, char **args) {
+    if (argc != 2) {
+        printf("Usage: des <scenario_file>\n");
+        return;
+    }
+
+    uint32_t count, table_size;
+    char (*nodes)[MAX_NODE_NAME_LEN];
+    if (!copy_node_names(&nodes, &count, &table_size)) {
+        return;
+    }
+
+    des_run_scenario(args[1], table_size, (const char (*)[MAX_NODE_NAME_LEN])nodes, count);
+    free(nodes);
+}
+
+// Handle hier command
+void handle_hier_command(int argc, char **args) {
+    if (argc > 5) {
+        printf("Usage: hier [pools] [backends_per_pool] [pool_table] [top_table]\n");
+        return;
+    }
+
+    HierConfig config = {
+        .pools = 100,
+        .backends_per_pool = 1000,
+        .pool_table_size = 0,
+        .top_table_size = 0,
+        .keys = 1000000,
+    };
+
+    uint64_t values[4] = { config.pools, config.backends_per_pool, 0, 0 };
+    static const char *const names[4] = { "pool count", "backends per pool", "pool table size", "top table size" };
+    for (int i = 0; i < 4 && i + 1 < argc; i++) {
+        if (!parse_u64_arg(args[i + 1], &values[i]) || values[i] > UINT32_MAX || (i < 2 && values[i] == 0)) {
+            printf("Error: Invalid %s '%s'\n", names[i], args[i + 1]);
+            return;
+        }
+    }
+    config.pools = (uint32_t)values[0];
+    config.backends_per_pool = (uint32_t)values[1];
+    config.pool_table_size = (uint32_t)values[2];
+    config.top_table_size = (uint32_t)values[3];
+
+    hier_compare(&config);
+}
+
+// Handle fleet command
+void handle_fleet_command(int argc, char **args) {
+    if (argc > 7) {
+        printf("Usage: fleet [instances] [changes] [delay_ms] [jitter_ms] [interval_ms] [threads]\n");
+        return;
+    }
+
+    FleetConfig config;
+    fleet_default_config(&config);
+    if (g_maglev.is_initialized) {
+        config.table_size = g_maglev.table_size;
+    }
+
+    uint64_t values[6] = { config.instances, config.changes, (uint64_t)config.delay_ms,
+                           (uint64_t)config.jitter_ms, (uint64_t)config.interval_ms, 0 };
+    static const char *const names[6] = { "instance count", "change count", "delay", "jitter",
+                                          "interval", "thread count" };
+    for (int i = 0; i < 6 && i + 1 < argc; i++) {
+        if (!parse_u64_arg(args[i + 1], &values[i]) || values[i] > 3600000 ||
+            ((i < 2 || i == 4) && values[i] == 0)) {
+            printf("Error: Invalid %s '%s'\n", names[i], args[i + 1]);
+            return;
+        }
+    }
+    config.instances = (uint32_t)values[0];
+    config.changes = (uint32_t)values[1];
+    config.delay_ms = (double)values[2];
+    config.jitter_ms = (double)values[3];
+    config.interval_ms = (double)values[4];
+    config.threads = (uint32_t)values[5];
+
+    uint32_t count;
+    char (*backends)[MAX_NODE_NAME_LEN];
+    if (!copy_node_names(&backends, &count, NULL)) {
+        return;
+    }
+
+    config.backends = (const char (*)[MAX_NODE_NAME_LEN])backends;
+    config.backend_count = count;
+    fleet_run(&config);
+    free(backends);
+}
+
+void process_command(char *input);
+
+// Handle churn command
+void handle_churn_command(int argc, char **args) {
+    const char *usage = "Usage: churn gen <rolling|zone|steady> <file> [backends] [events] [table_size]\n"
+                        "       churn run <file> [commands_per_second]\n";
+
+    if (argc >= 4 && argc <= 7 && strcmp(args[1], "gen") == 0) {
+        ChurnGenConfig config;
+        ChurnScenario scenario;
+        if (!churn_parse_scenario(args[2], &scenario)) {
+            printf("Error: Unknown scenario '%s' (rolling, zone or steady)\n", args[2]);
+            return;
+        }
+        churn_default_config(&config, scenario);
+
+        uint64_t backends = config.backends;
+        uint64_t events = config.events;
+        uint64_t table_size = config.table_size;
+        if (argc > 4 && (!parse_u64_arg(args[4], &backends) || backends == 0 || backends > MAX_NODES)) {
+            printf("Error: Invalid backend count '%s' (1-%d)\n", args[4], MAX_NODES);
+            return;
+        }
+        if (argc > 5 && (!parse_u64_arg(args[5], &events) || events > UINT32_MAX)) {
+            printf("Error: Invalid event count '%s'\n", args[5]);
+            return;
+        }
+        if (argc > 6 && (!parse_u64_arg(args[6], &table_size) || table_size == 0 || table_size > UINT32_MAX)) {
+            printf("Error: Invalid table size '%s'\n", args[6]);
+            return;
+        }
+        config.backends = (uint32_t)backends;
+        config.events = (uint32_t)events;
+        config.table_size = (uint32_t)table_size;
+        if (config.zones > config.backends) {
+            config.zones = config.backends;
+        }
+
+        churn_generate(args[3], &config);
+    } else if ((argc == 3 || argc == 4) && strcmp(args[1], "run") == 0) {
+        double rate = 0.0;
+        if (argc == 4) {
+            char *end;
+            rate = strtod(args[3], &end);
+            if (*end != '\0' || rate < 0) {
+                printf("Error: Invalid rate '%s'\n", args[3]);
+                return;
+            }
+        }
+
+        // Commands take the table lock themselves
+        churn_run(args[2], rate, process_command);
+    } else {
+        printf("%s", usage);
+    }
+}
+
+// Handle profile command: rerun the rest of the line under the counters
+void handle_profile_command(int argc, char **args) {
+    if (argc < 2) {
+        printf("Usage: profile <command> [args...]\n");
+        return;
+    }
+
+    CommandType inner = identify_command(args[1]);
+    if (inner == CMD_PROFILE || inner == CMD_QUIT || inner == CMD_UNKNOWN) {
+        printf("Error: Cannot profile '%s'\n", args[1]);
+        return;
+    }
+
+    // process_command splits its input in place, so keep a copy for the report
+    char line[MAX_INPUT_LEN];
+    char command[MAX_INPUT_LEN];
+    size_t len = 0;
+    for (int i = 1; i < argc; i++) {
+        int n = snprintf(line + len, sizeof(line) - len, "%s%s", i > 1 ? " " : "", args[i]);
+        if (n < 0 || (size_t)n >= sizeof(line) - len) {
+            printf("Error: Command too long\n");
+            return;
+        }
+        len += (size_t)n;
+    }
+    memcpy(command, line, len + 1);
+
+    if (!profile_begin()) {
+        printf("Error: A profile is already running\n");
+        return;
+    }
+    process_command(line);
+    profile_end(command);
+
+    if (rebuild_worker_is_running()) {
+        printf("  Note: rebuilds ran on the background worker and are not broken out (async off to include them)\n");
+    }
+}
+
+// Handle load command
+void handle_load_command(int argc, char **args) {
+    const char *usage = "Usage: load <on|off|reset|bench [threads] [lookups]>\n";
+    if (argc < 2) {
+        printf("%s", usage);
+        return;
+    }
+
+    if (strcmp(args[1], "on") == 0 && argc == 2) {
+        load_stats_set_enabled(true);
+        printf("Backend load counters enabled\n");
+    } else if (strcmp(args[1], "off") == 0 && argc == 2) {
+        load_stats_set_enabled(false);
+        printf("Backend load counters disabled\n");
+    } else if (strcmp(args[1], "reset") == 0 && argc == 2) {
+        maglev_lock();
+        load_stats_reset();
+        maglev_unlock();
+        printf("Backend load counters cleared\n");
+    } else if (strcmp(args[1], "bench") == 0 && argc <= 4) {
+        uint64_t threads = 8;
+        uint64_t lookups = 20000000;
+        if (argc > 2 && (!parse_u64_arg(args[2], &threads) || threads == 0 || threads > LOAD_MAX_SHARDS)) {
+            printf("Error: Invalid thread count '%s' (1-%d)\n", args[2], LOAD_MAX_SHARDS);
+            return;
+        }
+        if (argc > 3 && (!parse_u64_arg(args[3], &lookups) || lookups == 0)) {
+            printf("Error: Invalid lookup count '%s'\n", args[3]);
+            return;
+        }
+
+        maglev_lock();
+        load_stats_bench((uint32_t)threads, lookups);
+        maglev_unlock();
     } else {
-        printf("Usage: show <nodes|maglev|maglev-color>\n");
+        printf("%s", usage);
+    }
+}
+
+// Handle export command
+void handle_export_command(int argc, char **args) {
+    if (argc < 2 || argc > 3) {
+        printf("Usage: export <file> [csv|json]\n");
+        return;
+    }
+
+    ExportFormat format = EXPORT_CSV;
+    if (argc == 3 && !table_export_parse_format(args[2], &format)) {
+        printf("Usage: export <file> [csv|json]\n");
+        return;
+    }
+
+    maglev_lock();
+    table_export(args[1], format);
+    maglev_unlock();
+}
+
+// Handle export-delta and apply-delta commands
+void handle_delta_command(int argc, char **args, bool apply) {
+    if (argc != 2) {
+        printf("Usage: %s <file>\n", apply ? "apply-delta" : "export-delta");
+        return;
+    }
+
+    maglev_lock();
+    if (apply) {
+        delta_apply(args[1]);
+    } else {
+        delta_export(args[1]);
+    }
+    maglev_unlock();
+}
+
+// Handle compare command
+void handle_compare_command(int argc, char **args) {
+    const char *usage = "Usage: compare [sizing] [nodes] [table_size] [keys]\n"
+                        "       compare threads [nodes] [table_size] [max_threads]\n"
+                        "       compare kernels [keys]\n";
+    bool sizing = argc > 1 && strcmp(args[1], "sizing") == 0;
+    bool threads = argc > 1 && strcmp(args[1], "threads") == 0;
+    if (argc > 1 && strcmp(args[1], "kernels") == 0) {
+        CompareConfig config = { 0, 0, 1000000, 0 };
+        uint64_t keys;
+        if (argc > 3) {
+            printf("Usage: compare kernels [keys]\n");
+            return;
+        }
+        if (argc == 3) {
+            if (!parse_u64_arg(args[2], &keys) || keys == 0 || keys > UINT32_MAX) {
+                printf("Error: Invalid key count '%s'\n", args[2]);
+                return;
+            }
+            config.key_count = (uint32_t)keys;
+        }
+        compare_kernels(&config);
+        return;
+    }
+    if (sizing || threads) {
+        args++;
+        argc--;
+    }
+    if (argc > 4) {
+        printf("%s", usage);
+        return;
+    }
+
+    CompareConfig config;
+    config.node_count = 0;
+    config.table_size = g_maglev.is_initialized ? g_maglev.table_size : DEFAULT_TABLE_SIZE;
+    config.key_count = 1000000;
+    config.threads = 0;
+
+    uint64_t value;
+    if (argc > 1) {
+        if (!parse_u64_arg(args[1], &value) || value >= MAX_NODES) {
+            printf("Error: Invalid node count '%s'\n", args[1]);
+            return;
+        }
+        config.node_count = (uint32_t)value;
+    }
+    if (argc > 2) {
+        if (!parse_u64_arg(args[2], &value) || value < 2 || value > UINT32_MAX / 2) {
+            printf("Error: Invalid table size '%s'\n", args[2]);
+            return;
+        }
+        config.table_size = (uint32_t)value;
+    }
+    if (argc > 3 && threads) {
+        if (!parse_u64_arg(args[3], &value) || value == 0 || value > PREFERENCE_POOL_MAX_THREADS) {
+            printf("Error: Invalid thread count '%s' (1 to %d)\n", args[3], PREFERENCE_POOL_MAX_THREADS);
+            return;
+        }
+        config.threads = (uint32_t)value;
+    } else if (argc > 3) {
+        if (!parse_u64_arg(args[3], &value) || value == 0 || value > UINT32_MAX) {
+            printf("Error: Invalid key count '%s'\n", args[3]);
+            return;
+        }
+        config.key_count = (uint32_t)value;
+    }
+
+    if (threads) {
+        compare_threads(&config);
+    } else if (sizing) {
+        compare_sizing(&config);
+    } else {
+        compare_engines(&config);
+    }
+}
+
+// Handle shm command
+void handle_shm_command(int argc, char **args) {
+    const char *usage = "Usage: shm <publish <name>|status|off|bench [seconds]>\n";
+    if (argc < 2) {
+        printf("%s", usage);
+        return;
+    }
+
+    if (strcmp(args[1], "publish") == 0 && argc == 3) {
+        shm_publish_start(args[2]);
+    } else if (strcmp(args[1], "status") == 0 && argc == 2) {
+        shm_publish_show_status();
+    } else if (strcmp(args[1], "off") == 0 && argc == 2) {
+        shm_publish_stop();
+        printf("Shared-memory publishing stopped\n");
+    } else if (strcmp(args[1], "bench") == 0 && argc <= 3) {
+        double seconds = 2.0;
+        if (argc == 3) {
+            char *endptr;
+            seconds = strtod(args[2], &endptr);
+            if (*endptr != '\0' || seconds <= 0 || seconds > 3600) {
+                printf("Error: Invalid duration '%s'\n", args[2]);
+                return;
+            }
+        }
+        shm_publish_bench(seconds);
+    } else {
+        printf("%s", usage);
+    }
+}
+
+// Handle async command
+void handle_async_command(int argc, char **args) {
+    if (argc != 2 || (strcmp(args[1], "on") != 0 && strcmp(args[1], "off") != 0)) {
+        printf("Usage: async <on|off>\n");
+        return;
+    }
+
+    if (strcmp(args[1], "on") == 0) {
+        if (!rebuild_worker_start()) {
+            printf("Error: Failed to start rebuild worker\n");
+            return;
+        }
+        rebuild_worker_reset_stats();
+        if (cli_is_verbose()) {
+            printf("Background rebuild enabled\n");
+        }
+    } else {
+        rebuild_worker_stop();
+        if (cli_is_verbose()) {
+            printf("Background rebuild disabled\n");
+        }
+    }
+}
+
+// Handle sync command
+void handle_sync_command(void) {
+    if (!rebuild_worker_is_running()) {
+        printf("Background rebuild is off, table is always current\n");
+        return;
+    }
+
+    uint64_t start = timer_now_ns();
+    bool synced = rebuild_worker_sync();
+    uint64_t waited = timer_now_ns() - start;
+    if (!synced) {
+        printf("Error: Background rebuild failed (out of memory), table is at generation %llu of %llu\n",
+               (unsigned long long)g_maglev.table_generation, (unsigned long long)g_maglev.generation);
+        printf("  The worker retries on the next change; 'async off' rebuilds inline\n");
+        return;
+    }
+    if (!cli_is_verbose()) {
+        return;
+    }
+
+    RebuildStats stats;
+    rebuild_worker_get_stats(&stats);
+
+    printf("Synced to generation %llu (waited %.3f ms)\n",
+           (unsigned long long)g_maglev.table_generation, waited / 1e6);
+    printf("  Changes: %llu, rebuilds: %llu, saved by coalescing: %llu\n",
+           (unsigned long long)stats.changes, (unsigned long long)stats.rebuilds,
+           (unsigned long long)(stats.changes > stats.rebuilds ? stats.changes - stats.rebuilds : 0));
+    if (stats.rebuilds > 0) {
+        printf("  Rebuild time: avg %.3f ms\n", stats.rebuild_total_ns / 1e6 / stats.rebuilds);
+    }
+    if (stats.failed > 0) {
+        printf("  Failed rebuilds (out of memory): %llu\n", (unsigned long long)stats.failed);
+    }
+    if (stats.latency_count > 0) {
+        printf("  Change-to-publish latency: avg %.3f ms, max %.3f ms\n",
+               stats.latency_total_ns / 1e6 / stats.latency_count, stats.latency_max_ns / 1e6);
+    }
+}
+
+// Handle history command
+void handle_history_command(int argc, char **args) {
+    if (argc == 1) {
+        maglev_lock();
+        table_history_show();
+        maglev_unlock();
+        return;
+    }
+
+    uint64_t depth;
+    if (argc != 3 || strcmp(args[1], "keep") != 0) {
+        printf("Usage: history [keep <n>]\n");
+        return;
+    }
+    if (!parse_u64_arg(args[2], &depth) || depth > TABLE_HISTORY_MAX_DEPTH) {
+        printf("Error: Invalid version count '%s' (0-%d)\n", args[2], TABLE_HISTORY_MAX_DEPTH);
+        return;
+    }
+
+    maglev_lock();
+    table_history_set_depth((uint32_t)depth);
+    maglev_unlock();
+    if (depth == 0) {
+        printf("Table history off\n");
+    } else {
+        printf("Keeping the last %llu table versions\n", (unsigned long long)depth);
+    }
+}
+
+// Handle rollback command
+void handle_rollback_command(int argc, char **args) {
+    uint64_t steps = 1;
+    if (argc > 2 || (argc == 2 && (!parse_u64_arg(args[1], &steps) || steps == 0 || steps > TABLE_HISTORY_MAX_DEPTH))) {
+        printf("Usage: rollback [n] (1-%d versions back)\n", TABLE_HISTORY_MAX_DEPTH);
+        return;
+    }
+
+    MaglevChange change;
+    MaglevStatus status = maglev_rollback((uint32_t)steps, &change);
+    if (status == MAGLEV_ENOHISTORY) {
+        printf("Error: Table history is off (history keep <n> to enable)\n");
+        return;
+    }
+    if (status == MAGLEV_ERANGE) {
+        uint32_t earlier = table_history_count() > 0 ? table_history_count() - 1 : 0;
+        printf("Error: Cannot roll back %llu step%s, %u earlier version%s kept\n",
+               (unsigned long long)steps, steps == 1 ? "" : "s", earlier, earlier == 1 ? "" : "s");
+        return;
+    }
+    if (status == MAGLEV_ESIZE) {
+        const TableVersion *version = table_history_get((uint32_t)steps);
+        printf("Error: Generation %llu used table size %u, the table now has %u slots\n",
+               (unsigned long long)version->generation, version->table_size, g_maglev.table_size);
+        return;
+    }
+    if (status != MAGLEV_OK) {
+        report_status(status, NULL);
+        return;
+    }
+    if (cli_is_verbose()) {
+        printf("Rolled back to generation %llu, published as generation %llu (%u nodes)\n",
+               (unsigned long long)change.restored_generation, (unsigned long long)g_maglev.generation,
+               change.node_count);
+        printf("  Tables: %s in %.3f ms; republished in %.3f ms, no table fill\n",
+               change.instant ? "kept flat copy handed over" : "materialized from chunks",
+               change.checkout_ns / 1e6, change.rebuild_ns / 1e6);
+        if (change.recreated > 0) {
+            printf("  %u removed node%s recreated; preference lists follow with the next rebuild\n",
+                   change.recreated, change.recreated == 1 ? "" : "s");
+        }
     }
 }
 
@@ -219,6 +1512,10 @@ void process_command(char *input) {
             handle_init_command(argc, args);
             break;
 
+        case CMD_RESIZE:
+            handle_resize_command(argc, args);
+            break;
+
         case CMD_ADD_NODE:
             handle_add_command(argc, args);
             break;
@@ -227,16 +1524,93 @@ void process_command(char *input) {
             handle_del_command(argc, args);
             break;
 
+        case CMD_FAIL_NODE:
+            handle_fail_command(argc, args);
+            break;
+
+        case CMD_RECOVER_NODE:
+            handle_recover_command(argc, args);
+            break;
+
         case CMD_SHOW_NODES:
             handle_show_command(argc, args);
             break;
 
+        case CMD_SIMULATE:
+            handle_simulate_command(argc, args);
+            break;
+
+        case CMD_BOUNDED:
+            handle_bounded_command(argc, args);
+            break;
+
+        case CMD_DES:
+            handle_des_command(argc, args);
+            break;
+
+        case CMD_CHURN:
+            handle_churn_command(argc, args);
+            break;
+
+        case CMD_HIER:
+            handle_hier_command(argc, args);
+            break;
+
+        case CMD_FLEET:
+            handle_fleet_command(argc, args);
+            break;
+
+        case CMD_PROFILE:
+            handle_profile_command(argc, args);
+            break;
+
+        case CMD_LOAD:
+            handle_load_command(argc, args);
+            break;
+
+        case CMD_ASYNC:
+            handle_async_command(argc, args);
+            break;
+
+        case CMD_SYNC:
+            handle_sync_command();
+            break;
+
+        case CMD_HISTORY:
+            handle_history_command(argc, args);
+            break;
+
+        case CMD_ROLLBACK:
+            handle_rollback_command(argc, args);
+            break;
+
+        case CMD_EXPORT:
+            handle_export_command(argc, args);
+            break;
+
+        case CMD_EXPORT_DELTA:
+            handle_delta_command(argc, args, false);
+            break;
+
+        case CMD_APPLY_DELTA:
+            handle_delta_command(argc, args, true);
+            break;
+
+        case CMD_COMPARE:
+            handle_compare_command(argc, args);
+            break;
+
+        case CMD_SHM:
+            handle_shm_command(argc, args);
+            break;
+
         case CMD_HELP:
             show_help();
             break;
 
         case CMD_QUIT:
             printf("Goodbye!\n");
+            shm_publish_stop();
             exit(0);
             break;
 
@@ -387,6 +1761,7 @@ int main(int argc, char *argv[]) {
             process_command(command);
 
             // Exit after single command mode execution
+            shm_publish_stop();
             maglev_cleanup();
             return 0;
         }
@@ -405,10 +1780,12 @@ int main(int argc, char *argv[]) {
 
         if (result == FILE_EXEC_ERROR) {
             // File error, exit program
+            shm_publish_stop();
             maglev_cleanup();
             return 1;
         } else if (result == FILE_EXEC_QUIT) {
             // File ends with quit, exit normally
+            shm_publish_stop();
             maglev_cleanup();
             return 0;
         }
@@ -443,6 +1820,7 @@ int main(int argc, char *argv[]) {
 
     // Clean up resources
     cleanup_readline();
+    shm_publish_stop();
     maglev_cleanup();
     return 0;
 }
\ No newline at end of file
@@ -1,11 +1,11 @@
 #include "node.h"
 #include "hash.h"
+#include "table_kernel.h"
 #include <stdlib.h>
 #include <string.h>
-#include <stdio.h>
 
-// Create new node
-Node* node_create(const char *name, uint32_t table_size) {
+// Create new node with its preference list allocated but not generated
+Node* node_alloc(const char *name, uint32_t table_size) {
     if (!name || strlen(name) >= MAX_NODE_NAME_LEN) {
         return NULL;
     }
@@ -20,7 +20,8 @@ Node* node_create(const char *name, uint32_t table_size) {
     node->name[MAX_NODE_NAME_LEN - 1] = '\0';
     node->is_active = true;
     node->next_index = 0;
-    node->color_index = assign_unique_color_index();
+    node->color_index = -1;
+    node->list_pending = true;
 
     // Allocate preference list memory
     node->preference_list = malloc(table_size * sizeof(uint32_t));
@@ -29,9 +30,16 @@ Node* node_create(const char *name, uint32_t table_size) {
         return NULL;
     }
 
-    // Generate preference list
-    node_generate_preference_list(node, table_size);
+    return node;
+}
 
+// Create new node
+Node* node_create(const char *name, uint32_t table_size) {
+    Node *node = node_alloc(name, table_size);
+    if (node) {
+        node_generate_preference_list(node, table_size);
+        node->list_pending = false;
+    }
     return node;
 }
 
@@ -47,17 +55,20 @@ void node_destroy(Node *node) {
 
 // Generate node's preference list
 void node_generate_preference_list(Node *node, uint32_t table_size) {
-    if (!node || !node->preference_list) {
+    node_generate_preference_range(node, table_size, 0, table_size);
+}
+
+// Generate entries [begin, end) of node's preference list. Ranges are
+// independent, so one list can be split across threads.
+void node_generate_preference_range(Node *node, uint32_t table_size, uint32_t begin, uint32_t end) {
+    if (!node || !node->preference_list || end > table_size || begin >= end) {
         return;
     }
 
+    // Traverse the table from offset with skip step, through the kernel for this table size
     uint32_t offset = hash_offset(node->name, table_size);
     uint32_t skip = hash_skip(node->name, table_size);
-
-    // Generate preference list: traverse entire table starting from offset with skip step
-    for (uint32_t i = 0; i < table_size; i++) {
-        node->preference_list[i] = (offset + i * skip) % table_size;
-    }
+    table_kernel_select(table_size)->permutation(node->preference_list, table_size, offset, skip, begin, end);
 }
 
 // Reset node's index pointer
@@ -0,0 +1,114 @@
+#include "outbuf.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+void outbuf_init(OutBuf *buf, size_t initial_cap) {
+    buf->data = malloc(initial_cap ? initial_cap : 1);
+    buf->len = 0;
+    buf->cap = buf->data ? (initial_cap ? initial_cap : 1) : 0;
+    buf->failed = (buf->data == NULL);
+}
+
+void outbuf_free(OutBuf *buf) {
+    free(buf->data);
+    buf->data = NULL;
+    buf->len = 0;
+    buf->cap = 0;
+}
+
+// Make room for extra bytes, growing geometrically
+bool outbuf_reserve(OutBuf *buf, size_t extra) {
+    if (buf->failed) {
+        return false;
+    }
+
+    if (buf->len + extra <= buf->cap) {
+        return true;
+    }
+
+    size_t new_cap = buf->cap ? buf->cap : 64;
+    while (new_cap < buf->len + extra) {
+        new_cap *= 2;
+    }
+
+    char *data = realloc(buf->data, new_cap);
+    if (!data) {
+        buf->failed = true;
+        return false;
+    }
+
+    buf->data = data;
+    buf->cap = new_cap;
+    return true;
+}
+
+void outbuf_append(OutBuf *buf, const char *data, size_t len) {
+    if (!outbuf_reserve(buf, len)) return;
+    memcpy(buf->data + buf->len, data, len);
+    buf->len += len;
+}
+
+void outbuf_puts(OutBuf *buf, const char *str) {
+    outbuf_append(buf, str, strlen(str));
+}
+
+void outbuf_putc(OutBuf *buf, char c) {
+    if (!outbuf_reserve(buf, 1)) return;
+    buf->data[buf->len++] = c;
+}
+
+void outbuf_printf(OutBuf *buf, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int needed = vsnprintf(NULL, 0, fmt, ap);
+    va_end(ap);
+
+    if (needed < 0 || !outbuf_reserve(buf, (size_t)needed + 1)) return;
+
+    va_start(ap, fmt);
+    vsnprintf(buf->data + buf->len, (size_t)needed + 1, fmt, ap);
+    va_end(ap);
+    buf->len += (size_t)needed;
+}
+
+// Decimal formatting without going through printf (hot path for table dumps)
+void outbuf_u64(OutBuf *buf, uint64_t value) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    if (!outbuf_reserve(buf, (size_t)n)) return;
+    while (n > 0) {
+        buf->data[buf->len++] = tmp[--n];
+    }
+}
+
+// Right-aligned decimal in a field of the given width
+void outbuf_u64_padded(OutBuf *buf, uint64_t value, int width) {
+    char tmp[20];
+    int n = 0;
+    do {
+        tmp[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    int pad = width > n ? width - n : 0;
+    if (!outbuf_reserve(buf, (size_t)(pad + n))) return;
+    memset(buf->data + buf->len, ' ', (size_t)pad);
+    buf->len += (size_t)pad;
+    while (n > 0) {
+        buf->data[buf->len++] = tmp[--n];
+    }
+}
+
+// Write the buffered bytes to a stream
+bool outbuf_write(const OutBuf *buf, FILE *stream) {
+    if (buf->failed) {
+        return false;
+    }
+    return fwrite(buf->data, 1, buf->len, stream) == buf->len;
+}
@@ -0,0 +1,78 @@
+#include "preference_pool.h"
+#include "node.h"
+#include "profile.h"
+#include <pthread.h>
+#include <unistd.h>
+
+typedef struct {
+    Node *const *nodes;
+    uint32_t table_size;
+    uint32_t ranges_per_node;
+    uint64_t task_count;
+    uint64_t next_task;         // Claimed with an atomic add
+} PreferenceJob;
+
+static void *preference_worker(void *arg) {
+    PreferenceJob *job = arg;
+    for (;;) {
+        uint64_t task = __atomic_fetch_add(&job->next_task, 1, __ATOMIC_RELAXED);
+        if (task >= job->task_count) {
+            return NULL;
+        }
+
+        uint32_t node = (uint32_t)(task / job->ranges_per_node);
+        uint64_t begin = (task % job->ranges_per_node) * (uint64_t)PREFERENCE_POOL_TASK_ENTRIES;
+        uint64_t end = begin + PREFERENCE_POOL_TASK_ENTRIES;
+        if (end > job->table_size) end = job->table_size;
+        node_generate_preference_range(job->nodes[node], job->table_size, (uint32_t)begin, (uint32_t)end);
+    }
+}
+
+uint32_t preference_pool_default_threads(void) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    uint32_t threads = cpus > 0 ? (uint32_t)cpus : 1;
+    return threads > PREFERENCE_POOL_MAX_THREADS ? PREFERENCE_POOL_MAX_THREADS : threads;
+}
+
+uint32_t preference_pool_generate(Node *const *nodes, uint32_t count, uint32_t table_size,
+                                  uint32_t threads) {
+    if (count == 0 || table_size == 0) {
+        return 0;
+    }
+
+    PreferenceJob job;
+    job.nodes = nodes;
+    job.table_size = table_size;
+    job.ranges_per_node = (table_size + PREFERENCE_POOL_TASK_ENTRIES - 1) / PREFERENCE_POOL_TASK_ENTRIES;
+    job.task_count = (uint64_t)count * job.ranges_per_node;
+    job.next_task = 0;
+
+    // Starting a thread costs about as much as a few ten thousand entries
+    uint64_t entries = (uint64_t)count * table_size;
+    uint64_t useful = (entries + PREFERENCE_POOL_THREAD_ENTRIES - 1) / PREFERENCE_POOL_THREAD_ENTRIES;
+    if (threads == 0) threads = preference_pool_default_threads();
+    if (threads > PREFERENCE_POOL_MAX_THREADS) threads = PREFERENCE_POOL_MAX_THREADS;
+    if (threads > useful) threads = (uint32_t)useful;
+    if (threads > job.task_count) threads = (uint32_t)job.task_count;
+
+    profile_phase_begin(PROFILE_PREFERENCE);
+    pthread_t tids[PREFERENCE_POOL_MAX_THREADS];
+    uint32_t started = 0;
+    for (uint32_t t = 1; t < threads; t++) {
+        if (pthread_create(&tids[started], NULL, preference_worker, &job) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    // The caller works too; tasks a failed thread start would have taken are left to it
+    preference_worker(&job);
+    for (uint32_t t = 0; t < started; t++) {
+        pthread_join(tids[t], NULL);
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        nodes[i]->list_pending = false;
+    }
+    profile_phase_end(PROFILE_PREFERENCE);
+    return started + 1;
+}
@@ -0,0 +1,246 @@
+#include "profile.h"
+#include "timer.h"
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define PROFILE_COUNTERS 5
+
+#define CACHE_EVENT(cache, op, result) \
+    ((cache) | ((uint64_t)(op) << 8) | ((uint64_t)(result) << 16))
+
+typedef struct {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+} CounterSpec;
+
+static const CounterSpec counter_specs[PROFILE_COUNTERS] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"LLC-misses", PERF_TYPE_HW_CACHE,
+     CACHE_EVENT(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"dTLB-misses", PERF_TYPE_HW_CACHE,
+     CACHE_EVENT(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+static const char *phase_names[PROFILE_PHASES] = {
+    "preference",
+    "fill",
+    "lookup",
+};
+
+typedef struct {
+    uint64_t calls;
+    uint64_t wall_ns;
+    double cpu_seconds;
+    double counts[PROFILE_COUNTERS];
+
+    // Open interval; nested markers of the same phase extend it
+    uint32_t depth;
+    uint64_t start_ns;
+    double start_cpu;
+    double start_counts[PROFILE_COUNTERS];
+} PhaseTotal;
+
+static struct {
+    bool active;
+    pthread_t owner;
+    int fds[PROFILE_COUNTERS];
+    uint32_t open_count;
+    int open_errno;                         // Why the first counter failed to open
+    PhaseTotal phases[PROFILE_PHASES + 1];  // The last one spans the whole command
+} g_profile;
+
+static int perf_event_open(struct perf_event_attr *attr) {
+    return (int)syscall(SYS_perf_event_open, attr, 0, -1, -1, 0);
+}
+
+// Counting (not sampling) event on this thread and the threads it starts.
+// User space only, which unprivileged processes may count at
+// perf_event_paranoid <= 2.
+static int open_counter(const CounterSpec *spec) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec->type;
+    attr.config = spec->config;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return perf_event_open(&attr);
+}
+
+// Current value, scaled up if the kernel had to multiplex the counter
+static double read_counter(int fd) {
+    uint64_t values[3];
+    if (fd < 0 || read(fd, values, sizeof(values)) != (ssize_t)sizeof(values) || values[2] == 0) {
+        return 0.0;
+    }
+    return (double)values[0] * ((double)values[1] / (double)values[2]);
+}
+
+static void phase_start(PhaseTotal *p) {
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+        p->start_counts[c] = read_counter(g_profile.fds[c]);
+    }
+    p->start_cpu = timer_cpu_seconds();
+    p->start_ns = timer_now_ns();
+}
+
+static void phase_stop(PhaseTotal *p) {
+    uint64_t now = timer_now_ns();
+    double cpu = timer_cpu_seconds();
+    p->wall_ns += now - p->start_ns;
+    p->cpu_seconds += cpu - p->start_cpu;
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+        p->counts[c] += read_counter(g_profile.fds[c]) - p->start_counts[c];
+    }
+    p->calls++;
+}
+
+bool profile_begin(void) {
+    if (g_profile.active) {
+        return false;
+    }
+
+    memset(g_profile.phases, 0, sizeof(g_profile.phases));
+    g_profile.open_count = 0;
+    g_profile.open_errno = 0;
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+        g_profile.fds[c] = open_counter(&counter_specs[c]);
+        if (g_profile.fds[c] >= 0) {
+            g_profile.open_count++;
+        } else if (g_profile.open_errno == 0) {
+            g_profile.open_errno = errno;
+        }
+    }
+
+    g_profile.owner = pthread_self();
+    __atomic_store_n(&g_profile.active, true, __ATOMIC_RELEASE);
+    phase_start(&g_profile.phases[PROFILE_PHASES]);
+    return true;
+}
+
+bool profile_is_active(void) {
+    return __atomic_load_n(&g_profile.active, __ATOMIC_ACQUIRE);
+}
+
+// Only the starting thread may mark phases: counters are read through its fds
+static PhaseTotal *marked_phase(ProfilePhase phase) {
+    if (!profile_is_active() || phase >= PROFILE_PHASES ||
+        !pthread_equal(pthread_self(), g_profile.owner)) {
+        return NULL;
+    }
+    return &g_profile.phases[phase];
+}
+
+void profile_phase_begin(ProfilePhase phase) {
+    PhaseTotal *p = marked_phase(phase);
+    if (p && p->depth++ == 0) {
+        phase_start(p);
+    }
+}
+
+void profile_phase_end(ProfilePhase phase) {
+    PhaseTotal *p = marked_phase(phase);
+    if (p && p->depth > 0 && --p->depth == 0) {
+        phase_stop(p);
+    }
+}
+
+static void describe_unavailable(int err) {
+    if (err == EACCES || err == EPERM) {
+        int level = -1;
+        FILE *f = fopen("/proc/sys/kernel/perf_event_paranoid", "r");
+        if (f) {
+            if (fscanf(f, "%d", &level) != 1) level = -1;
+            fclose(f);
+        }
+        printf("not permitted (kernel.perf_event_paranoid = %d)", level);
+    } else if (err == ENOENT || err == ENODEV || err == EOPNOTSUPP) {
+        printf("no hardware PMU exposed (common in containers and VMs)");
+    } else if (err == ENOSYS) {
+        printf("perf_event_open not supported by this kernel");
+    } else {
+        printf("%s", strerror(err));
+    }
+}
+
+static void print_count(int c, double value) {
+    if (g_profile.fds[c] < 0) {
+        printf(" %13s", "-");
+    } else {
+        printf(" %13.0f", value);
+    }
+}
+
+static void print_row(const char *name, const PhaseTotal *p) {
+    printf("  %-10s %7llu %10.3f %10.3f", name, (unsigned long long)p->calls,
+           p->wall_ns / 1e6, p->cpu_seconds * 1e3);
+    if (g_profile.open_count == 0) {
+        printf("\n");
+        return;
+    }
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+        print_count(c, p->counts[c]);
+    }
+    if (g_profile.fds[0] >= 0 && g_profile.fds[1] >= 0 && p->counts[0] > 0) {
+        printf(" %6.2f", p->counts[1] / p->counts[0]);
+    } else {
+        printf(" %6s", "-");
+    }
+    printf("\n");
+}
+
+void profile_end(const char *command) {
+    if (!g_profile.active) {
+        return;
+    }
+
+    phase_stop(&g_profile.phases[PROFILE_PHASES]);
+    __atomic_store_n(&g_profile.active, false, __ATOMIC_RELEASE);
+
+    printf("\nProfile of '%s'\n", command);
+    if (g_profile.open_count == PROFILE_COUNTERS) {
+        printf("  Hardware counters: all %d (user space, threads included)\n", PROFILE_COUNTERS);
+    } else if (g_profile.open_count > 0) {
+        printf("  Hardware counters: %u of %d, the rest unavailable: ", g_profile.open_count, PROFILE_COUNTERS);
+        describe_unavailable(g_profile.open_errno);
+        printf("\n");
+    } else {
+        printf("  Hardware counters unavailable: ");
+        describe_unavailable(g_profile.open_errno);
+        printf("\n  Falling back to software clocks (wall and process CPU time)\n");
+    }
+
+    printf("  %-10s %7s %10s %10s", "phase", "calls", "wall_ms", "cpu_ms");
+    if (g_profile.open_count > 0) {
+        for (int c = 0; c < PROFILE_COUNTERS; c++) {
+            printf(" %13s", counter_specs[c].name);
+        }
+        printf(" %6s", "IPC");
+    }
+    printf("\n");
+
+    for (int p = 0; p < PROFILE_PHASES; p++) {
+        if (g_profile.phases[p].calls > 0) {
+            print_row(phase_names[p], &g_profile.phases[p]);
+        }
+    }
+    print_row("total", &g_profile.phases[PROFILE_PHASES]);
+
+    for (int c = 0; c < PROFILE_COUNTERS; c++) {
+        if (g_profile.fds[c] >= 0) {
+            close(g_profile.fds[c]);
+        }
+        g_profile.fds[c] = -1;
+    }
+}
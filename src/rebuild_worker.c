@@ -0,0 +1,324 @@
+#include "rebuild_worker.h"
+#include "load_stats.h"
+#include "node.h"
+#include "timer.h"
+#include "table_history.h"
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#define CHANGE_RING_SIZE 4096   // Change timestamps kept for latency accounting
+#define LATENCY_SAMPLES 65536   // Latest change-to-publish latencies kept for percentiles
+
+typedef struct RetiredNode {
+    Node *node;
+    uint64_t generation;        // Membership generation that no longer contains the node
+    struct RetiredNode *next;
+} RetiredNode;
+
+typedef struct {
+    pthread_t thread;
+    pthread_cond_t work_cond;   // Signalled on new changes and on stop
+    pthread_cond_t done_cond;   // Signalled after each publish
+    bool running;
+    bool stopping;
+    bool busy;                  // A rebuild is in flight or being recorded
+    uint32_t *spare_table;      // Back buffer the worker fills
+    uint32_t *spare_backup;     // Back buffer for the backup owners
+    SlotIndex spare_index;      // Back buffer for the slot ownership index
+    uint32_t spare_size;
+    Node *snapshot[MAX_NODES];  // Membership snapshot for the in-flight rebuild
+    uint8_t snapshot_down[MAX_NODES];   // Failure flags of that snapshot
+    RetiredNode *retired;       // Removed nodes waiting to be freed
+    uint64_t failed_generation; // Latest generation whose rebuild could not run
+    uint64_t change_ns[CHANGE_RING_SIZE];   // Change timestamp indexed by generation
+    uint64_t latency_ns[LATENCY_SAMPLES];   // Change-to-publish samples indexed by latency_count
+    RebuildStats stats;
+} RebuildWorker;
+
+static RebuildWorker g_worker = {
+    .work_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+};
+
+// Free retired nodes whose removal is reflected in the published table (lock held)
+static void free_retired_nodes(uint64_t published_generation) {
+    RetiredNode **link = &g_worker.retired;
+    while (*link) {
+        RetiredNode *r = *link;
+        if (r->generation <= published_generation) {
+            *link = r->next;
+            node_destroy(r->node);
+            free(r);
+        } else {
+            link = &r->next;
+        }
+    }
+}
+
+// Account change-to-publish latency for generations (from, to] (lock held)
+static void record_publish(uint64_t from, uint64_t to, uint64_t now) {
+    // Older changes than the ring can hold are folded into the oldest kept entry
+    if (to - from > CHANGE_RING_SIZE) {
+        from = to - CHANGE_RING_SIZE;
+    }
+
+    for (uint64_t gen = from + 1; gen <= to; gen++) {
+        uint64_t latency = now - g_worker.change_ns[gen % CHANGE_RING_SIZE];
+        g_worker.latency_ns[g_worker.stats.latency_count % LATENCY_SAMPLES] = latency;
+        g_worker.stats.latency_count++;
+        g_worker.stats.latency_total_ns += latency;
+        if (latency > g_worker.stats.latency_max_ns) {
+            g_worker.stats.latency_max_ns = latency;
+        }
+    }
+}
+
+static void *rebuild_worker_main(void *arg) {
+    (void)arg;
+
+    maglev_lock();
+    while (!g_worker.stopping) {
+        // Idle, or the latest rebuild failed: wait for the next change to retry
+        if (!g_maglev.is_initialized || g_maglev.table_generation >= g_maglev.generation ||
+            g_worker.failed_generation >= g_maglev.generation) {
+            maglev_wait(&g_worker.work_cond);
+            continue;
+        }
+
+        // Snapshot membership; everything that arrived so far is covered by this rebuild
+        uint64_t from_generation = g_maglev.table_generation;
+        uint64_t generation = g_maglev.generation;
+        uint32_t table_size = g_maglev.table_size;
+        uint32_t node_count = g_maglev.node_count;
+        memcpy(g_worker.snapshot, g_maglev.nodes, node_count * sizeof(Node *));
+        for (uint32_t i = 0; i < node_count; i++) {
+            g_worker.snapshot_down[i] = !g_maglev.nodes[i]->is_active;
+        }
+
+        if (g_worker.spare_size != table_size) {
+            free(g_worker.spare_table);
+            free(g_worker.spare_backup);
+            slot_index_free(&g_worker.spare_index);
+            g_worker.spare_table = malloc(table_size * sizeof(uint32_t));
+            g_worker.spare_backup = malloc(table_size * sizeof(uint32_t));
+            bool indexed = slot_index_alloc(&g_worker.spare_index, table_size);
+            g_worker.spare_size = (g_worker.spare_table && g_worker.spare_backup && indexed) ? table_size : 0;
+            if (!g_worker.spare_size) {
+                // Out of memory: report the failure to sync waiters instead of parking them
+                g_worker.stats.failed++;
+                g_worker.failed_generation = generation;
+                pthread_cond_broadcast(&g_worker.done_cond);
+                continue;
+            }
+        }
+        g_worker.busy = true;
+        maglev_unlock();
+
+        // Fill the back buffer without holding the lock
+        uint64_t start = timer_now_ns();
+        maglev_generate_pending_lists(g_worker.snapshot, node_count);
+        maglev_fill_table(g_worker.spare_table, g_worker.spare_backup, &g_worker.spare_index,
+                          table_size, g_worker.snapshot, node_count);
+        uint64_t end = timer_now_ns();
+
+        maglev_lock();
+        g_worker.busy = false;
+        g_worker.stats.rebuilds++;
+        g_worker.stats.rebuild_total_ns += end - start;
+
+        // Publish by swapping buffers (discard if the table was re-initialized meanwhile)
+        if (g_maglev.is_initialized && g_maglev.table_size == table_size &&
+            g_maglev.table_generation == from_generation) {
+            uint32_t *old_table = g_maglev.lookup_table;
+            uint32_t *old_backup = g_maglev.backup_table;
+            g_maglev.lookup_table = g_worker.spare_table;
+            g_maglev.backup_table = g_worker.spare_backup;
+            g_worker.spare_table = old_table;
+            g_worker.spare_backup = old_backup;
+
+            SlotIndex old_index = g_maglev.slot_index;
+            g_maglev.slot_index = g_worker.spare_index;
+            g_worker.spare_index = old_index;
+            g_maglev.slot_index_stale = false;
+
+            load_stats_fold();
+            memcpy(g_maglev.table_nodes, g_worker.snapshot, node_count * sizeof(Node *));
+            g_maglev.table_node_count = node_count;
+            g_maglev.table_generation = generation;
+            maglev_publish_down_flags();
+            maglev_notify_published(false);
+
+            record_publish(from_generation, generation, timer_now_ns());
+            free_retired_nodes(generation);
+
+            // Record the version outside the lock so failure redirects are
+            // not held up; busy keeps the control plane from replacing the
+            // published table meanwhile
+            TableSnapshot snapshot = {
+                .generation = generation,
+                .table_size = table_size,
+                .table = g_maglev.lookup_table,
+                .backup = g_maglev.backup_table,
+                .nodes = g_worker.snapshot,
+                .down = g_worker.snapshot_down,
+                .node_count = node_count,
+            };
+            g_worker.busy = true;
+            maglev_unlock();
+            table_history_record(&snapshot);
+            maglev_lock();
+            g_worker.busy = false;
+        }
+
+        pthread_cond_broadcast(&g_worker.done_cond);
+    }
+    maglev_unlock();
+    return NULL;
+}
+
+// Start the background rebuild worker
+bool rebuild_worker_start(void) {
+    if (g_worker.running) {
+        return true;
+    }
+
+    g_worker.stopping = false;
+    if (pthread_create(&g_worker.thread, NULL, rebuild_worker_main, NULL) != 0) {
+        return false;
+    }
+
+    g_worker.running = true;
+    return true;
+}
+
+// Stop the worker after it has published the latest generation
+void rebuild_worker_stop(void) {
+    if (!g_worker.running) {
+        return;
+    }
+
+    bool synced = rebuild_worker_sync();
+
+    maglev_lock();
+    g_worker.stopping = true;
+    pthread_cond_signal(&g_worker.work_cond);
+    maglev_unlock();
+
+    pthread_join(g_worker.thread, NULL);
+    g_worker.running = false;
+
+    maglev_lock();
+    free_retired_nodes(UINT64_MAX);
+    maglev_unlock();
+
+    free(g_worker.spare_table);
+    free(g_worker.spare_backup);
+    slot_index_free(&g_worker.spare_index);
+    g_worker.spare_table = NULL;
+    g_worker.spare_backup = NULL;
+    g_worker.spare_size = 0;
+
+    // The worker could not publish the latest generation: rebuild inline
+    if (!synced) {
+        maglev_rebuild_table();
+    }
+}
+
+bool rebuild_worker_is_running(void) {
+    return g_worker.running;
+}
+
+// Timestamp a membership generation (lock held)
+void rebuild_worker_note_change(uint64_t generation) {
+    g_worker.change_ns[generation % CHANGE_RING_SIZE] = timer_now_ns();
+}
+
+// Signal that membership changed
+void rebuild_worker_request(void) {
+    maglev_lock();
+    g_worker.stats.changes++;
+    pthread_cond_signal(&g_worker.work_cond);
+    maglev_unlock();
+}
+
+// Wait until the published table reflects the latest membership generation
+// and the worker is done with it. Returns false if the worker could not
+// rebuild it (out of memory); it retries on the next change.
+bool rebuild_worker_sync(void) {
+    if (!g_worker.running) {
+        return true;
+    }
+
+    maglev_lock();
+    while (g_maglev.is_initialized &&
+           ((g_maglev.table_generation < g_maglev.generation &&
+             g_worker.failed_generation < g_maglev.generation) || g_worker.busy)) {
+        maglev_wait(&g_worker.done_cond);
+    }
+    bool synced = !g_maglev.is_initialized || g_maglev.table_generation >= g_maglev.generation;
+    maglev_unlock();
+    return synced;
+}
+
+// Wait for idle and free retired nodes. Once synced the worker holds no
+// snapshot, and only the control plane can hand it new work.
+void rebuild_worker_drain(void) {
+    if (!g_worker.running) {
+        return;
+    }
+
+    // The caller replaces the table next, so a failed rebuild is dropped
+    bool synced = rebuild_worker_sync();
+
+    maglev_lock();
+    g_worker.failed_generation = 0;
+    // Unless synced, nodes removed since the last publish may still be in the table
+    free_retired_nodes(synced ? UINT64_MAX : g_maglev.table_generation);
+    maglev_unlock();
+}
+
+// Defer freeing a removed node
+void rebuild_worker_retire_node(Node *node) {
+    RetiredNode *r = malloc(sizeof(RetiredNode));
+
+    maglev_lock();
+    if (!r) {
+        // Cannot track it: wait for the worker to publish past it instead
+        maglev_unlock();
+        rebuild_worker_sync();
+        node_destroy(node);
+        return;
+    }
+
+    r->node = node;
+    r->generation = g_maglev.generation;
+    r->next = g_worker.retired;
+    g_worker.retired = r;
+
+    // Already published (the worker may have been quicker than us)
+    free_retired_nodes(g_maglev.table_generation);
+    maglev_unlock();
+}
+
+void rebuild_worker_get_stats(RebuildStats *stats) {
+    maglev_lock();
+    *stats = g_worker.stats;
+    maglev_unlock();
+}
+
+// Copy up to max of the latest change-to-publish latencies (unordered)
+uint64_t rebuild_worker_latency_samples(uint64_t *samples, uint64_t max) {
+    maglev_lock();
+    uint64_t count = g_worker.stats.latency_count < LATENCY_SAMPLES ? g_worker.stats.latency_count : LATENCY_SAMPLES;
+    if (count > max) count = max;
+    memcpy(samples, g_worker.latency_ns, count * sizeof(uint64_t));
+    maglev_unlock();
+    return count;
+}
+
+void rebuild_worker_reset_stats(void) {
+    maglev_lock();
+    memset(&g_worker.stats, 0, sizeof(g_worker.stats));
+    maglev_unlock();
+}
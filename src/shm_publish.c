@@ -0,0 +1,415 @@
+#include "shm_publish.h"
+#include "shm_table.h"
+#include "maglev.h"
+#include "cli.h"
+#include "rebuild_worker.h"
+#include "hash.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+typedef struct {
+    char name[SHM_NAME_LEN];
+    ShmTableHeader *header;
+    size_t size;
+    ShmPublishStats stats;
+} ShmPublisher;
+
+static ShmPublisher g_publisher = {0};
+
+#define SHM_DIR "/dev/shm"             // Where shm_open keeps its objects
+#define SHM_NEXT_SUFFIX ".next"         // Name a replacement segment is built under
+
+static void next_segment_name(char *out, size_t len) {
+    snprintf(out, len, "%s" SHM_NEXT_SUFFIX, g_publisher.name);
+}
+
+// Create a stamped segment with room for table_capacity slots under the
+// replacement name; readers cannot see it until install_segment
+static ShmTableHeader *create_segment(uint32_t table_capacity, size_t *size_out) {
+    size_t size = shm_table_segment_size(table_capacity, MAX_NODES);
+    char next_name[SHM_NAME_LEN + sizeof(SHM_NEXT_SUFFIX)];
+    next_segment_name(next_name, sizeof(next_name));
+
+    // A leftover from an interrupted replace
+    shm_unlink(next_name);
+    int fd = shm_open(next_name, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0) {
+        return NULL;
+    }
+
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        shm_unlink(next_name);
+        return NULL;
+    }
+
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        shm_unlink(next_name);
+        return NULL;
+    }
+
+    ShmTableHeader *header = map;
+    size_t table_bytes = (size_t)table_capacity * sizeof(uint32_t);
+    size_t names_bytes = (size_t)MAX_NODES * SHM_NAME_LEN;
+    size_t slot_bytes = 2 * table_bytes + names_bytes + MAX_NODES;
+
+    header->segment_size = size;
+    header->table_capacity = table_capacity;
+    header->node_capacity = MAX_NODES;
+    for (int i = 0; i < 2; i++) {
+        ShmTableSlot *slot = &header->slots[i];
+        slot->table_offset = sizeof(ShmTableHeader) + i * slot_bytes;
+        slot->backup_offset = slot->table_offset + table_bytes;
+        slot->names_offset = slot->backup_offset + table_bytes;
+        slot->down_offset = slot->names_offset + names_bytes;
+    }
+    header->version = SHM_TABLE_VERSION;
+    __atomic_store_n(&header->magic, SHM_TABLE_MAGIC, __ATOMIC_RELEASE);
+
+    *size_out = size;
+    return header;
+}
+
+// Rename a created segment over the published name, then retire the old
+// one: a reader following the retired flag always finds a stamped segment
+static bool install_segment(ShmTableHeader *header, size_t size) {
+    char next_name[SHM_NAME_LEN + sizeof(SHM_NEXT_SUFFIX)];
+    char from[sizeof(SHM_DIR) + sizeof(next_name)];
+    char to[sizeof(SHM_DIR) + SHM_NAME_LEN];
+    next_segment_name(next_name, sizeof(next_name));
+    snprintf(from, sizeof(from), SHM_DIR "%s", next_name);
+    snprintf(to, sizeof(to), SHM_DIR "%s", g_publisher.name);
+
+    if (rename(from, to) != 0) {
+        munmap(header, size);
+        shm_unlink(next_name);
+        return false;
+    }
+
+    if (g_publisher.header) {
+        __atomic_store_n(&g_publisher.header->retired, 1, __ATOMIC_RELEASE);
+        munmap(g_publisher.header, g_publisher.size);
+    }
+    g_publisher.header = header;
+    g_publisher.size = size;
+    return true;
+}
+
+// Copy the current table into the inactive slot, then flip
+static void write_table(ShmTableHeader *header) {
+    uint32_t target = (header->active + 1) & 1;
+    ShmTableSlot *slot = &header->slots[target];
+    char *base = (char *)header;
+
+    // Open the write window: readers that land here will retry
+    uint64_t seq = slot->seq;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    // Owners and backups as published; readers resolve failed owners themselves
+    memcpy(base + slot->table_offset, g_maglev.lookup_table, g_maglev.table_size * sizeof(uint32_t));
+    memcpy(base + slot->backup_offset, g_maglev.backup_table, g_maglev.table_size * sizeof(uint32_t));
+    memcpy(base + slot->down_offset, g_maglev.table_node_down, g_maglev.table_node_count);
+
+    char *names = base + slot->names_offset;
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        memcpy(names + (size_t)i * SHM_NAME_LEN, g_maglev.table_nodes[i]->name, SHM_NAME_LEN);
+    }
+
+    slot->table_size = g_maglev.table_size;
+    slot->node_count = g_maglev.table_node_count;
+    slot->generation = g_maglev.table_generation;
+
+    // Close the window, then point readers at the fresh slot
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+    __atomic_store_n(&header->active, target, __ATOMIC_RELEASE);
+    header->publish_count++;
+}
+
+// Refresh the failure flags of the active slot in place. Only valid while
+// the slot holds the current table; the other slot is rewritten in full on
+// the next publish anyway.
+static void write_down_flags(ShmTableHeader *header) {
+    ShmTableSlot *slot = &header->slots[header->active & 1];
+
+    uint64_t seq = slot->seq;
+    __atomic_store_n(&slot->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    uint8_t *down = (uint8_t *)header + slot->down_offset;
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        __atomic_store_n(&down[i], g_maglev.table_node_down[i], __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&slot->seq, seq + 2, __ATOMIC_RELEASE);
+    header->publish_count++;
+}
+
+// Build a segment for the current table size holding the current table and
+// put it in place of the published one (if any)
+static bool replace_segment(void) {
+    size_t size;
+    ShmTableHeader *header = create_segment(g_maglev.table_size, &size);
+    if (!header) {
+        return false;
+    }
+    write_table(header);
+    return install_segment(header, size);
+}
+
+// Publish hook: write the table into the segment, growing it if needed.
+// A failure flips only the flags when the active slot holds this table.
+static void shm_publish_table(bool down_only) {
+    if (!g_publisher.header || !g_maglev.is_initialized) {
+        return;
+    }
+
+    uint64_t start = timer_now_ns();
+    ShmTableHeader *header = g_publisher.header;
+    const ShmTableSlot *active = &header->slots[header->active & 1];
+
+    if (down_only && active->generation == g_maglev.table_generation &&
+        active->table_size == g_maglev.table_size && active->node_count == g_maglev.table_node_count) {
+        write_down_flags(header);
+        g_publisher.stats.flag_updates++;
+    } else if (g_maglev.table_size > header->table_capacity) {
+        if (!replace_segment()) {
+            // Readers keep the last table; the next publish retries the grow
+            g_publisher.stats.grow_failures++;
+            return;
+        }
+    } else {
+        write_table(header);
+    }
+
+    uint64_t elapsed = timer_now_ns() - start;
+    g_publisher.stats.publishes++;
+    g_publisher.stats.total_ns += elapsed;
+    if (elapsed > g_publisher.stats.max_ns) {
+        g_publisher.stats.max_ns = elapsed;
+    }
+}
+
+bool shm_publish_start(const char *name) {
+    if (!g_maglev.is_initialized) {
+        printf("Error: Maglev table not initialized\n");
+        return false;
+    }
+
+    if (name[0] != '/' || strchr(name + 1, '/') || strlen(name) >= SHM_NAME_LEN - sizeof(SHM_NEXT_SUFFIX)) {
+        printf("Error: Shared-memory name must look like '/maglev'\n");
+        return false;
+    }
+
+    shm_publish_stop();
+    snprintf(g_publisher.name, sizeof(g_publisher.name), "%s", name);
+    memset(&g_publisher.stats, 0, sizeof(g_publisher.stats));
+
+    maglev_lock();
+    bool ok = replace_segment();
+    if (ok) {
+        g_publisher.stats.publishes++;
+        maglev_set_publish_hook(shm_publish_table);
+    }
+    maglev_unlock();
+
+    if (!ok) {
+        printf("Error: Failed to create shared-memory segment '%s'\n", name);
+        return false;
+    }
+
+    printf("Publishing lookup table to shared memory '%s' (%zu bytes)\n", name, g_publisher.size);
+    return true;
+}
+
+void shm_publish_stop(void) {
+    if (!g_publisher.header) {
+        return;
+    }
+
+    maglev_lock();
+    maglev_set_publish_hook(NULL);
+    // Unlink first so readers that see the retired flag do not reopen this segment
+    shm_unlink(g_publisher.name);
+    __atomic_store_n(&g_publisher.header->retired, 1, __ATOMIC_RELEASE);
+    munmap(g_publisher.header, g_publisher.size);
+    g_publisher.header = NULL;
+    g_publisher.size = 0;
+    maglev_unlock();
+}
+
+bool shm_publish_is_active(void) {
+    return g_publisher.header != NULL;
+}
+
+void shm_publish_get_stats(ShmPublishStats *stats) {
+    maglev_lock();
+    *stats = g_publisher.stats;
+    maglev_unlock();
+}
+
+void shm_publish_show_status(void) {
+    if (!g_publisher.header) {
+        printf("Shared-memory publishing is off\n");
+        return;
+    }
+
+    ShmPublishStats stats;
+    shm_publish_get_stats(&stats);
+
+    const ShmTableSlot *slot = &g_publisher.header->slots[g_publisher.header->active & 1];
+    printf("Shared memory '%s': %zu bytes, generation %llu, %u slots, %u nodes\n",
+           g_publisher.name, g_publisher.size, (unsigned long long)slot->generation,
+           slot->table_size, slot->node_count);
+    if (stats.publishes > 0) {
+        printf("  Publishes: %llu (%llu failure-flag updates), avg %.3f ms, max %.3f ms\n",
+               (unsigned long long)stats.publishes, (unsigned long long)stats.flag_updates,
+               stats.total_ns / 1e6 / stats.publishes, stats.max_ns / 1e6);
+    }
+    if (stats.grow_failures > 0) {
+        printf("  Failed to grow the segment %llu time%s; readers see generation %llu, the table is at %llu\n",
+               (unsigned long long)stats.grow_failures, stats.grow_failures == 1 ? "" : "s",
+               (unsigned long long)slot->generation, (unsigned long long)g_maglev.table_generation);
+    }
+}
+
+typedef struct {
+    uint64_t lookups;
+    uint64_t retries;
+    uint64_t generations;       // Distinct generations observed
+    double seconds;
+    bool ok;
+} ReaderResult;
+
+// Child process: lookups against the mapping until the deadline
+static void run_bench_reader(const char *name, double seconds, int fd) {
+    ReaderResult result = {0};
+    ShmReader reader;
+
+    if (shm_reader_open(&reader, name)) {
+        uint64_t deadline = timer_now_ns() + (uint64_t)(seconds * 1e9);
+        uint64_t last_generation = UINT64_MAX;
+        uint64_t key = 0;
+        uint32_t retries = 0;
+        uint64_t start = timer_now_ns();
+        uint64_t now = start;
+
+        while (now < deadline) {
+            for (int i = 0; i < 4096; i++) {
+                uint64_t generation;
+                shm_reader_lookup(&reader, hash_key64(key++), NULL, &generation, &retries);
+                if (generation != last_generation) {
+                    result.generations++;
+                    last_generation = generation;
+                }
+            }
+            result.lookups += 4096;
+            now = timer_now_ns();
+        }
+
+        result.retries = retries;
+        result.seconds = (now - start) / 1e9;
+        result.ok = true;
+        shm_reader_close(&reader);
+    }
+
+    if (write(fd, &result, sizeof(result)) != (ssize_t)sizeof(result)) {
+        _exit(1);
+    }
+    _exit(0);
+}
+
+// Fork a reader process that hammers the segment while this process churns membership
+bool shm_publish_bench(double seconds) {
+    if (!g_publisher.header) {
+        printf("Error: Shared-memory publishing is off (use 'shm publish <name>')\n");
+        return false;
+    }
+
+    if (g_maglev.node_count == 0) {
+        printf("Error: No nodes in Maglev table\n");
+        return false;
+    }
+
+    int fds[2];
+    if (pipe(fds) != 0) {
+        printf("Error: Failed to create pipe\n");
+        return false;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        printf("Error: Failed to fork reader\n");
+        return false;
+    }
+    if (pid == 0) {
+        close(fds[0]);
+        run_bench_reader(g_publisher.name, seconds, fds[1]);
+    }
+    close(fds[1]);
+
+    // Churn: add and remove a probe node until the reader is done
+    ShmPublishStats before;
+    shm_publish_get_stats(&before);
+
+    bool verbose = cli_set_verbose(false);
+    uint64_t deadline = timer_now_ns() + (uint64_t)(seconds * 1e9);
+    uint64_t changes = 0;
+    while (timer_now_ns() < deadline) {
+        if (changes % 2 == 0) {
+            maglev_add_node("shm-bench-churn");
+        } else {
+            maglev_remove_node("shm-bench-churn", NULL);
+        }
+        changes++;
+        if (!rebuild_worker_sync()) {
+            printf("Error: Background rebuild failed (out of memory)\n");
+            break;
+        }
+    }
+    if (changes % 2 == 1) {
+        maglev_remove_node("shm-bench-churn", NULL);
+        rebuild_worker_sync();
+    }
+    cli_set_verbose(verbose);
+
+    ReaderResult result = {0};
+    ssize_t got = read(fds[0], &result, sizeof(result));
+    close(fds[0]);
+    waitpid(pid, NULL, 0);
+
+    ShmPublishStats after;
+    shm_publish_get_stats(&after);
+
+    if (got != (ssize_t)sizeof(result) || !result.ok) {
+        printf("Error: Reader process failed\n");
+        return false;
+    }
+
+    uint64_t publishes = after.publishes - before.publishes;
+    printf("Shared-memory benchmark (%.1f s, %llu membership changes):\n",
+           seconds, (unsigned long long)changes);
+    if (publishes > 0) {
+        printf("  Publish: %llu tables, avg %.3f ms, max %.3f ms (%u slots)\n",
+               (unsigned long long)publishes,
+               (after.total_ns - before.total_ns) / 1e6 / publishes,
+               after.max_ns / 1e6, g_maglev.table_size);
+    }
+    printf("  Reader: %.1f M lookups/s, %llu retries, %llu generations observed\n",
+           result.seconds > 0 ? result.lookups / result.seconds / 1e6 : 0.0,
+           (unsigned long long)result.retries, (unsigned long long)result.generations);
+    return true;
+}
@@ -0,0 +1,123 @@
+#include "shm_table.h"
+#include "maglev_core.h"
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+size_t shm_table_segment_size(uint32_t table_capacity, uint32_t node_capacity) {
+    size_t per_slot = 2 * (size_t)table_capacity * sizeof(uint32_t) + (size_t)node_capacity * (SHM_NAME_LEN + 1);
+    return sizeof(ShmTableHeader) + 2 * per_slot;
+}
+
+bool shm_reader_open(ShmReader *reader, const char *name) {
+    memset(reader, 0, sizeof(*reader));
+    snprintf(reader->name, sizeof(reader->name), "%s", name);
+
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ShmTableHeader)) {
+        close(fd);
+        return false;
+    }
+
+    void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return false;
+    }
+
+    ShmTableHeader *header = map;
+    if (header->magic != SHM_TABLE_MAGIC || header->version != SHM_TABLE_VERSION ||
+        header->segment_size != (uint64_t)st.st_size) {
+        munmap(map, (size_t)st.st_size);
+        return false;
+    }
+
+    reader->header = header;
+    reader->size = (size_t)st.st_size;
+    return true;
+}
+
+void shm_reader_close(ShmReader *reader) {
+    if (reader->header) {
+        munmap(reader->header, reader->size);
+        reader->header = NULL;
+        reader->size = 0;
+    }
+}
+
+// Consistent lookup without syscalls
+uint32_t shm_reader_lookup(ShmReader *reader, uint64_t key_hash, char *name_out,
+                           uint64_t *generation, uint32_t *retries) {
+    uint32_t attempts = 0;
+
+    for (;;) {
+        ShmTableHeader *header = reader->header;
+        if (!header) {
+            return UINT32_MAX;
+        }
+
+        // Writer swapped in a bigger segment: follow it. Until the new one
+        // opens, keep serving the last table and retry on later calls.
+        if (__atomic_load_n(&header->retired, __ATOMIC_ACQUIRE)) {
+            ShmReader next;
+            if (shm_reader_open(&next, reader->name)) {
+                if (!__atomic_load_n(&next.header->retired, __ATOMIC_ACQUIRE)) {
+                    shm_reader_close(reader);
+                    *reader = next;
+                    continue;
+                }
+                shm_reader_close(&next);
+            }
+        }
+
+        uint32_t active = __atomic_load_n(&header->active, __ATOMIC_ACQUIRE) & 1;
+        const ShmTableSlot *slot = &header->slots[active];
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq & 1) {
+            attempts++;
+            continue;
+        }
+
+        uint32_t table_size = slot->table_size;
+        uint32_t node_count = slot->node_count;
+        uint64_t gen = slot->generation;
+        uint32_t owner = UINT32_MAX;
+
+        if (table_size > 0 && table_size <= header->table_capacity && node_count <= header->node_capacity) {
+            const char *base = (const char *)header;
+            owner = maglev_resolve((const uint32_t *)(base + slot->table_offset),
+                                   (const uint32_t *)(base + slot->backup_offset),
+                                   (const uint8_t *)(base + slot->down_offset),
+                                   node_count, table_size, maglev_slot(key_hash, table_size));
+        }
+
+        if (name_out) {
+            if (owner != UINT32_MAX) {
+                const char *names = (const char *)header + slot->names_offset;
+                memcpy(name_out, names + (size_t)owner * SHM_NAME_LEN, SHM_NAME_LEN);
+                name_out[SHM_NAME_LEN - 1] = '\0';
+            } else {
+                name_out[0] = '\0';
+            }
+        }
+
+        // Validate: nothing may have been rewritten under us
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) {
+            attempts++;
+            continue;
+        }
+
+        if (generation) *generation = gen;
+        if (retries) *retries += attempts;
+        return owner;
+    }
+}
@@ -0,0 +1,212 @@
+#include "simulate.h"
+#include "maglev.h"
+#include "load_stats.h"
+#include "timer.h"
+#include "profile.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#define SIM_BATCH_SIZE 4096
+#define SIM_HIST_LANES 4        // Independent sub-histograms to break store-to-load dependencies
+#define SIM_MAX_THREADS 64
+
+typedef struct {
+    KeyStream ks;               // Forked from the shared stream: own RNG, shared alias table
+    uint64_t key_count;
+    uint32_t bucket_count;      // node_count + 1 (last bucket collects unassigned slots)
+    uint64_t *histogram;        // Private, cache-line aligned: no sharing between threads
+    LoadShard *load;            // Backend traffic counter shard, NULL when counting is off
+} SimulateWorker;
+
+static void *simulate_worker(void *arg) {
+    SimulateWorker *w = arg;
+    uint64_t keys[SIM_BATCH_SIZE];
+    uint32_t owners[SIM_BATCH_SIZE];
+    uint32_t slots[SIM_BATCH_SIZE];
+    const uint32_t *table = g_maglev.lookup_table;
+    const uint8_t *down = g_maglev.table_node_down;
+    uint32_t table_size = g_maglev.table_size;
+    const TableKernel *kernel = g_maglev.kernel;
+    uint32_t unassigned_bucket = w->bucket_count - 1;
+    uint64_t *lanes[SIM_HIST_LANES];
+
+    for (uint32_t l = 0; l < SIM_HIST_LANES; l++) {
+        lanes[l] = w->histogram + (size_t)l * w->bucket_count;
+    }
+
+    uint64_t remaining = w->key_count;
+    while (remaining > 0) {
+        uint32_t batch = remaining < SIM_BATCH_SIZE ? (uint32_t)remaining : SIM_BATCH_SIZE;
+        keystream_fill(&w->ks, keys, batch);
+
+        // Gather owners first so the table reads can overlap
+        kernel->slots(keys, slots, batch, table_size);
+        for (uint32_t i = 0; i < batch; i++) {
+            uint32_t owner = table[slots[i]];
+            if (owner < unassigned_bucket && down[owner]) {
+                owner = maglev_resolve_slot(slots[i]);
+            }
+            owners[i] = owner < unassigned_bucket ? owner : unassigned_bucket;
+        }
+
+        // Round-robin over the lanes so consecutive hits on the same node do not serialize
+        uint32_t i = 0;
+        for (; i + SIM_HIST_LANES <= batch; i += SIM_HIST_LANES) {
+            lanes[0][owners[i]]++;
+            lanes[1][owners[i + 1]]++;
+            lanes[2][owners[i + 2]]++;
+            lanes[3][owners[i + 3]]++;
+        }
+        for (; i < batch; i++) {
+            lanes[0][owners[i]]++;
+        }
+
+        if (w->load) {
+            load_stats_count_batch(w->load, owners, keys, batch);
+        }
+
+        remaining -= batch;
+    }
+
+    return NULL;
+}
+
+// Push a generated key stream through the current Maglev table and report per-node load
+bool simulate_run(const SimulateConfig *config) {
+    if (!g_maglev.is_initialized) {
+        printf("Error: Maglev table not initialized\n");
+        return false;
+    }
+
+    if (g_maglev.table_node_count == 0) {
+        printf("Error: No nodes in Maglev table\n");
+        return false;
+    }
+
+    uint32_t threads = config->threads;
+    if (threads == 0) threads = 1;
+    if (threads > SIM_MAX_THREADS) threads = SIM_MAX_THREADS;
+
+    uint32_t bucket_count = g_maglev.table_node_count + 1;
+    size_t hist_bytes = (size_t)SIM_HIST_LANES * bucket_count * sizeof(uint64_t);
+
+    SimulateWorker workers[SIM_MAX_THREADS];
+    pthread_t tids[SIM_MAX_THREADS];
+
+    // One alias table for all threads; only the RNG state is per thread
+    KeyStream base;
+    if (!keystream_init(&base, &config->keys)) {
+        printf("Error: Failed to build key stream\n");
+        return false;
+    }
+
+    for (uint32_t t = 0; t < threads; t++) {
+        keystream_fork(&workers[t].ks, &base, t);
+        workers[t].key_count = config->key_count / threads + (t < config->key_count % threads ? 1 : 0);
+        workers[t].bucket_count = bucket_count;
+        workers[t].load = load_stats_shard(t);
+        if (posix_memalign((void **)&workers[t].histogram, 64, hist_bytes) != 0) {
+            for (uint32_t j = 0; j < t; j++) free(workers[j].histogram);
+            keystream_free(&base);
+            printf("Error: Memory allocation failed\n");
+            return false;
+        }
+        memset(workers[t].histogram, 0, hist_bytes);
+    }
+
+    printf("Simulating %llu %s keys over %u flows (%u thread%s)...\n",
+           (unsigned long long)config->key_count,
+           keystream_distribution_name(config->keys.dist),
+           config->keys.flow_count, threads, threads == 1 ? "" : "s");
+
+    profile_phase_begin(PROFILE_LOOKUP);
+    uint64_t start = timer_now_ns();
+    for (uint32_t t = 0; t < threads; t++) {
+        if (pthread_create(&tids[t], NULL, simulate_worker, &workers[t]) != 0) {
+            simulate_worker(&workers[t]);
+            tids[t] = 0;
+        }
+    }
+    for (uint32_t t = 0; t < threads; t++) {
+        if (tids[t]) pthread_join(tids[t], NULL);
+    }
+    uint64_t elapsed = timer_now_ns() - start;
+    profile_phase_end(PROFILE_LOOKUP);
+    keystream_free(&base);
+
+    // Merge per-thread, per-lane histograms
+    uint64_t *hits = calloc(bucket_count, sizeof(uint64_t));
+    uint32_t *slots = calloc(bucket_count, sizeof(uint32_t));
+    if (!hits || !slots) {
+        printf("Error: Memory allocation failed\n");
+        free(hits);
+        free(slots);
+        for (uint32_t t = 0; t < threads; t++) free(workers[t].histogram);
+        return false;
+    }
+
+    for (uint32_t t = 0; t < threads; t++) {
+        for (uint32_t l = 0; l < SIM_HIST_LANES; l++) {
+            const uint64_t *lane = workers[t].histogram + (size_t)l * bucket_count;
+            for (uint32_t b = 0; b < bucket_count; b++) {
+                hits[b] += lane[b];
+            }
+        }
+        free(workers[t].histogram);
+    }
+
+    for (uint32_t i = 0; i < g_maglev.table_size; i++) {
+        uint32_t owner = g_maglev.lookup_table[i];
+        slots[owner < g_maglev.table_node_count ? owner : g_maglev.table_node_count]++;
+    }
+
+    double seconds = elapsed / 1e9;
+    printf("Processed %llu keys in %.3f s (%.1f Mkeys/s)\n",
+           (unsigned long long)config->key_count, seconds,
+           seconds > 0 ? config->key_count / seconds / 1e6 : 0.0);
+
+    // Per-node load and balance statistics (failed nodes excluded)
+    uint32_t nodes = g_maglev.table_node_count;
+    uint32_t healthy = 0;
+    for (uint32_t i = 0; i < nodes; i++) {
+        if (!g_maglev.table_node_down[i]) healthy++;
+    }
+    if (healthy == 0) healthy = nodes;
+
+    double mean = (double)(config->key_count - hits[nodes]) / healthy;
+    double variance = 0.0;
+    uint32_t hottest = 0;
+
+    printf("Per-node load:\n");
+    for (uint32_t i = 0; i < nodes; i++) {
+        if (hits[i] > hits[hottest]) hottest = i;
+        if (!g_maglev.table_node_down[i]) {
+            double diff = hits[i] - mean;
+            variance += diff * diff;
+        }
+
+        printf("  %-*s %12llu hits (%6.2f%%)  slots %6.2f%%%s\n",
+               get_max_node_name_length(), g_maglev.table_nodes[i]->name,
+               (unsigned long long)hits[i],
+               config->key_count ? 100.0 * hits[i] / config->key_count : 0.0,
+               100.0 * slots[i] / g_maglev.table_size,
+               g_maglev.table_node_down[i] ? "  (failed)" : "");
+    }
+
+    if (hits[nodes] > 0) {
+        printf("  Unassigned: %llu hits\n", (unsigned long long)hits[nodes]);
+    }
+
+    double cv = mean > 0 ? sqrt(variance / healthy) / mean : 0.0;
+    printf("Mean load: %.1f hits/node\n", mean);
+    printf("Coefficient of variation: %.4f\n", cv);
+    printf("Hottest backend: %s (overload factor %.3fx)\n",
+           g_maglev.table_nodes[hottest]->name, mean > 0 ? hits[hottest] / mean : 0.0);
+
+    free(hits);
+    free(slots);
+    return true;
+}
@@ -0,0 +1,258 @@
+#include "table_export.h"
+#include "maglev.h"
+#include "cli.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Rough bytes per run, used to size the buffer up front
+#define BYTES_PER_RUN_HINT 32
+
+bool table_export_parse_format(const char *name, ExportFormat *format) {
+    if (strcmp(name, "csv") == 0) {
+        *format = EXPORT_CSV;
+    } else if (strcmp(name, "json") == 0) {
+        *format = EXPORT_JSON;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Owner name of a table entry ("-" if unassigned)
+static const char *owner_name(uint32_t owner) {
+    if (owner == UINT32_MAX) {
+        return "-";
+    }
+    if (owner < g_maglev.table_node_count && g_maglev.table_nodes[owner]) {
+        return g_maglev.table_nodes[owner]->name;
+    }
+    return "?";
+}
+
+// Length of the run of identical owners starting at slot
+static uint32_t run_length(uint32_t slot) {
+    const uint32_t *table = g_maglev.lookup_table;
+    uint32_t owner = table[slot];
+    uint32_t end = slot + 1;
+    while (end < g_maglev.table_size && table[end] == owner) {
+        end++;
+    }
+    return end - slot;
+}
+
+static int decimal_width(uint32_t value) {
+    int width = 1;
+    while (value >= 10) {
+        value /= 10;
+        width++;
+    }
+    return width;
+}
+
+static void append_colored(OutBuf *buf, const char *text, int code) {
+    if (code < 0) {
+        outbuf_puts(buf, text);
+        return;
+    }
+
+    if (code <= 97) {
+        outbuf_puts(buf, "\033[");
+    } else {
+        outbuf_puts(buf, "\033[38;5;");
+    }
+    outbuf_u64(buf, (uint64_t)code);
+    outbuf_putc(buf, 'm');
+    outbuf_puts(buf, text);
+    outbuf_puts(buf, "\033[0m");
+}
+
+// Render the full table as run-length encoded owner ranges
+void table_render_runs(OutBuf *buf, bool colored) {
+    uint32_t size = g_maglev.table_size;
+    int slot_width = decimal_width(size);
+
+    uint32_t runs = 0;
+    for (uint32_t slot = 0; slot < size; ) {
+        uint32_t len = run_length(slot);
+        uint32_t owner = g_maglev.lookup_table[slot];
+
+        outbuf_u64_padded(buf, slot, slot_width + 2);
+        if (len > 1) {
+            outbuf_putc(buf, '-');
+            outbuf_u64(buf, slot + len - 1);
+            for (int i = decimal_width(slot + len - 1); i < slot_width; i++) outbuf_putc(buf, ' ');
+        } else {
+            for (int i = 0; i <= slot_width; i++) outbuf_putc(buf, ' ');
+        }
+        outbuf_puts(buf, "  ");
+
+        if (colored && owner < g_maglev.table_node_count && g_maglev.table_nodes[owner]) {
+            append_colored(buf, owner_name(owner), cli_node_color(g_maglev.table_nodes[owner]));
+        } else {
+            outbuf_puts(buf, owner_name(owner));
+        }
+
+        if (len > 1) {
+            outbuf_puts(buf, " x");
+            outbuf_u64(buf, len);
+        }
+        outbuf_putc(buf, '\n');
+
+        runs++;
+        slot += len;
+    }
+
+    outbuf_printf(buf, "(%u slots in %u runs)\n", size, runs);
+}
+
+// CSV: one row per run
+void table_render_csv(OutBuf *buf) {
+    outbuf_puts(buf, "start,end,node\n");
+
+    for (uint32_t slot = 0; slot < g_maglev.table_size; ) {
+        uint32_t len = run_length(slot);
+        const char *name = owner_name(g_maglev.lookup_table[slot]);
+
+        outbuf_u64(buf, slot);
+        outbuf_putc(buf, ',');
+        outbuf_u64(buf, slot + len - 1);
+        outbuf_putc(buf, ',');
+
+        // Quote names containing separators, doubling embedded quotes
+        if (strpbrk(name, ",\"\n")) {
+            outbuf_putc(buf, '"');
+            for (const char *p = name; *p; p++) {
+                if (*p == '"') outbuf_putc(buf, '"');
+                outbuf_putc(buf, *p);
+            }
+            outbuf_putc(buf, '"');
+        } else {
+            outbuf_puts(buf, name);
+        }
+        outbuf_putc(buf, '\n');
+
+        slot += len;
+    }
+}
+
+static void append_json_string(OutBuf *buf, const char *str) {
+    outbuf_putc(buf, '"');
+    for (const unsigned char *p = (const unsigned char *)str; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            outbuf_putc(buf, '\\');
+            outbuf_putc(buf, (char)*p);
+        } else if (*p < 0x20) {
+            outbuf_printf(buf, "\\u%04x", *p);
+        } else {
+            outbuf_putc(buf, (char)*p);
+        }
+    }
+    outbuf_putc(buf, '"');
+}
+
+// JSON: node names once, then [start, end, node_index] runs (-1 = unassigned)
+void table_render_json(OutBuf *buf) {
+    outbuf_puts(buf, "{\n  \"table_size\": ");
+    outbuf_u64(buf, g_maglev.table_size);
+    outbuf_puts(buf, ",\n  \"generation\": ");
+    outbuf_u64(buf, g_maglev.table_generation);
+    outbuf_puts(buf, ",\n  \"nodes\": [");
+
+    for (uint32_t i = 0; i < g_maglev.table_node_count; i++) {
+        if (i > 0) outbuf_puts(buf, ", ");
+        append_json_string(buf, g_maglev.table_nodes[i] ? g_maglev.table_nodes[i]->name : "?");
+    }
+
+    outbuf_puts(buf, "],\n  \"runs\": [");
+
+    bool first = true;
+    for (uint32_t slot = 0; slot < g_maglev.table_size; ) {
+        uint32_t len = run_length(slot);
+        uint32_t owner = g_maglev.lookup_table[slot];
+
+        outbuf_puts(buf, first ? "\n    [" : ",\n    [");
+        outbuf_u64(buf, slot);
+        outbuf_puts(buf, ", ");
+        outbuf_u64(buf, slot + len - 1);
+        outbuf_puts(buf, ", ");
+        if (owner == UINT32_MAX) {
+            outbuf_puts(buf, "-1");
+        } else {
+            outbuf_u64(buf, owner);
+        }
+        outbuf_putc(buf, ']');
+
+        first = false;
+        slot += len;
+    }
+
+    outbuf_puts(buf, "\n  ]\n}\n");
+}
+
+// Print the full table to stdout
+void table_show_all(bool colored) {
+    if (!g_maglev.is_initialized) {
+        printf("Maglev table not initialized\n");
+        return;
+    }
+
+    uint64_t start = timer_now_ns();
+
+    OutBuf buf;
+    outbuf_init(&buf, (size_t)g_maglev.table_size * BYTES_PER_RUN_HINT / 2);
+    outbuf_printf(&buf, "Maglev lookup table (size: %u)%s - all slots:\n",
+                  g_maglev.table_size, colored ? " - Colored" : "");
+    table_render_runs(&buf, colored);
+
+    fflush(stdout);
+    if (!outbuf_write(&buf, stdout)) {
+        printf("Error: Failed to render table\n");
+    }
+    fflush(stdout);
+
+    printf("Rendered %zu bytes in %.3f ms\n", buf.len, (timer_now_ns() - start) / 1e6);
+    outbuf_free(&buf);
+}
+
+// Write the full table to a file
+bool table_export(const char *filename, ExportFormat format) {
+    if (!g_maglev.is_initialized) {
+        printf("Error: Maglev table not initialized\n");
+        return false;
+    }
+
+    uint64_t start = timer_now_ns();
+
+    OutBuf buf;
+    outbuf_init(&buf, (size_t)g_maglev.table_size * BYTES_PER_RUN_HINT / 2);
+    if (format == EXPORT_JSON) {
+        table_render_json(&buf);
+    } else {
+        table_render_csv(&buf);
+    }
+    uint64_t rendered = timer_now_ns();
+
+    FILE *file = fopen(filename, "w");
+    if (!file) {
+        printf("Error: Cannot open file '%s'\n", filename);
+        outbuf_free(&buf);
+        return false;
+    }
+
+    bool ok = outbuf_write(&buf, file);
+    ok = (fclose(file) == 0) && ok;
+    uint64_t end = timer_now_ns();
+
+    if (!ok) {
+        printf("Error: Failed to write '%s'\n", filename);
+    } else {
+        printf("Exported %u slots to '%s' (%s, %zu bytes): render %.3f ms, write %.3f ms\n",
+               g_maglev.table_size, filename, format == EXPORT_JSON ? "json" : "csv",
+               buf.len, (rendered - start) / 1e6, (end - rendered) / 1e6);
+    }
+
+    outbuf_free(&buf);
+    return ok;
+}
@@ -0,0 +1,429 @@
+#include "table_history.h"
+#include "hash.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+static struct {
+    pthread_mutex_t lock;               // Recording runs outside the table lock
+    TableVersion *versions[TABLE_HISTORY_MAX_DEPTH];    // Oldest first
+    uint32_t count;
+    uint32_t depth;
+    uint32_t next_id;                   // Next stable member id
+    const TableVersion *base;         // Set by table_history_set_base for one record
+    size_t chunks;                      // Live chunks across all versions
+    size_t member_bytes;
+} g_table_history = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .depth = TABLE_HISTORY_DEFAULT_DEPTH,
+};
+
+// Open-addressing map from a name to its position in a name list
+typedef struct {
+    uint32_t *slots;            // Position + 1, 0 if empty
+    uint32_t mask;
+} NameMap;
+
+static bool name_map_build(NameMap *map, char *const *names, uint32_t count) {
+    uint32_t capacity = 16;
+    while (capacity < count * 2) {
+        capacity <<= 1;
+    }
+    map->slots = calloc(capacity, sizeof(uint32_t));
+    map->mask = capacity - 1;
+    if (!map->slots) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t h = djb2_hash(names[i]) & map->mask;
+        while (map->slots[h]) {
+            h = (h + 1) & map->mask;
+        }
+        map->slots[h] = i + 1;
+    }
+    return true;
+}
+
+static int name_map_find(const NameMap *map, char *const *names, const char *name) {
+    uint32_t h = djb2_hash(name) & map->mask;
+    while (map->slots[h]) {
+        uint32_t i = map->slots[h] - 1;
+        if (strcmp(names[i], name) == 0) {
+            return (int)i;
+        }
+        h = (h + 1) & map->mask;
+    }
+    return -1;
+}
+
+static void chunk_release(TableChunk *chunk) {
+    if (chunk && --chunk->refs == 0) {
+        free(chunk);
+        g_table_history.chunks--;
+    }
+}
+
+static void version_free(TableVersion *v) {
+    if (!v) {
+        return;
+    }
+    for (uint32_t c = 0; c < v->chunk_count; c++) {
+        if (v->owner) chunk_release(v->owner[c]);
+        if (v->backup) chunk_release(v->backup[c]);
+    }
+    for (uint32_t i = 0; v->names && i < v->node_count; i++) {
+        g_table_history.member_bytes -= strlen(v->names[i]) + 1;
+        free(v->names[i]);
+    }
+    g_table_history.member_bytes -= (size_t)v->node_count * (sizeof(char *) + sizeof(uint32_t) + 1);
+    free(v->names);
+    free(v->ids);
+    free(v->down);
+    free(v->owner);
+    free(v->backup);
+    free(v->flat_owner);
+    free(v->flat_backup);
+    free(v);
+}
+
+static void drop_flat(TableVersion *v) {
+    free(v->flat_owner);
+    free(v->flat_backup);
+    v->flat_owner = NULL;
+    v->flat_backup = NULL;
+}
+
+// Share the base chunk if its entries are unchanged, otherwise copy (NULL if out of memory)
+static TableChunk *chunk_share_or_copy(TableChunk *base, const uint32_t *slots, uint32_t *new_chunks) {
+    if (base && memcmp(base->slots, slots, sizeof(base->slots)) == 0) {
+        base->refs++;
+        return base;
+    }
+
+    TableChunk *chunk = malloc(sizeof(TableChunk));
+    if (!chunk) {
+        return NULL;
+    }
+    chunk->refs = 1;
+    memcpy(chunk->slots, slots, sizeof(chunk->slots));
+    g_table_history.chunks++;
+    (*new_chunks)++;
+    return chunk;
+}
+
+// Translate one chunk of table entries (node indices) into member ids
+static void chunk_entries(uint32_t *out, const uint32_t *table, uint32_t first,
+                          uint32_t table_size, const uint32_t *ids, uint32_t node_count) {
+    for (uint32_t k = 0; k < TABLE_HISTORY_CHUNK_SLOTS; k++) {
+        uint32_t slot = first + k;
+        uint32_t index = slot < table_size ? table[slot] : UINT32_MAX;
+        out[k] = index < node_count ? ids[index] : UINT32_MAX;
+    }
+}
+
+static void record_locked(const TableSnapshot *snap) {
+    const TableVersion *base = g_table_history.base;
+    g_table_history.base = NULL;
+    if (g_table_history.depth == 0) {
+        return;
+    }
+    if (!base && g_table_history.count > 0) {
+        base = g_table_history.versions[g_table_history.count - 1];
+    }
+
+    uint32_t node_count = snap->node_count;
+    uint32_t table_size = snap->table_size;
+    uint32_t alloc_count = node_count ? node_count : 1;
+
+    TableVersion *v = calloc(1, sizeof(TableVersion));
+    if (!v) {
+        return;
+    }
+    v->generation = snap->generation;
+    v->published_ns = timer_now_ns();
+    v->table_size = table_size;
+    v->chunk_count = (table_size + TABLE_HISTORY_CHUNK_SLOTS - 1) / TABLE_HISTORY_CHUNK_SLOTS;
+    v->names = calloc(alloc_count, sizeof(char *));
+    v->ids = malloc(alloc_count * sizeof(uint32_t));
+    v->down = malloc(alloc_count);
+    v->owner = calloc(v->chunk_count, sizeof(TableChunk *));
+    v->backup = calloc(v->chunk_count, sizeof(TableChunk *));
+    NameMap base_names = {0};
+    bool ok = v->names && v->ids && v->down && v->owner && v->backup &&
+              (!base || name_map_build(&base_names, base->names, base->node_count));
+
+    // Members keep the id they had in the base version
+    for (uint32_t i = 0; ok && i < node_count; i++) {
+        const char *name = snap->nodes[i]->name;
+        v->names[i] = strdup(name);
+        if (!v->names[i]) {
+            ok = false;
+            break;
+        }
+        v->node_count = i + 1;
+        g_table_history.member_bytes += strlen(name) + 1 + sizeof(char *) + sizeof(uint32_t) + 1;
+
+        int j = base ? name_map_find(&base_names, base->names, name) : -1;
+        v->ids[i] = j >= 0 ? base->ids[j] : g_table_history.next_id++;
+        v->down[i] = snap->down[i];
+    }
+    free(base_names.slots);
+
+    // Chunks are only comparable between tables of the same size
+    if (base && base->table_size != table_size) {
+        base = NULL;
+    }
+
+    uint32_t entries[TABLE_HISTORY_CHUNK_SLOTS];
+    for (uint32_t c = 0; ok && c < v->chunk_count; c++) {
+        uint32_t first = c * TABLE_HISTORY_CHUNK_SLOTS;
+        chunk_entries(entries, snap->table, first, table_size, v->ids, node_count);
+        v->owner[c] = chunk_share_or_copy(base ? base->owner[c] : NULL, entries, &v->new_chunks);
+        chunk_entries(entries, snap->backup, first, table_size, v->ids, node_count);
+        v->backup[c] = chunk_share_or_copy(base ? base->backup[c] : NULL, entries, &v->new_chunks);
+        ok = v->owner[c] && v->backup[c];
+    }
+
+    // Out of memory: keep the older versions rather than a partial one
+    if (!ok) {
+        version_free(v);
+        return;
+    }
+
+    // Flat copy for a rollback by pointer; without one the chunks still serve
+    size_t table_bytes = (size_t)table_size * sizeof(uint32_t);
+    v->flat_owner = malloc(table_bytes);
+    v->flat_backup = malloc(table_bytes);
+    if (v->flat_owner && v->flat_backup) {
+        memcpy(v->flat_owner, snap->table, table_bytes);
+        memcpy(v->flat_backup, snap->backup, table_bytes);
+    } else {
+        drop_flat(v);
+    }
+
+    if (g_table_history.count == g_table_history.depth) {
+        version_free(g_table_history.versions[0]);
+        memmove(&g_table_history.versions[0], &g_table_history.versions[1],
+                (g_table_history.count - 1) * sizeof(TableVersion *));
+        g_table_history.count--;
+    }
+    g_table_history.versions[g_table_history.count++] = v;
+
+    if (g_table_history.count > TABLE_HISTORY_FLAT_VERSIONS) {
+        drop_flat(g_table_history.versions[g_table_history.count - 1 - TABLE_HISTORY_FLAT_VERSIONS]);
+    }
+}
+
+void table_history_record(const TableSnapshot *snapshot) {
+    pthread_mutex_lock(&g_table_history.lock);
+    record_locked(snapshot);
+    pthread_mutex_unlock(&g_table_history.lock);
+}
+
+void table_history_clear(void) {
+    pthread_mutex_lock(&g_table_history.lock);
+    for (uint32_t i = 0; i < g_table_history.count; i++) {
+        version_free(g_table_history.versions[i]);
+    }
+    g_table_history.count = 0;
+    g_table_history.base = NULL;
+    pthread_mutex_unlock(&g_table_history.lock);
+}
+
+bool table_history_set_depth(uint32_t depth) {
+    if (depth > TABLE_HISTORY_MAX_DEPTH) {
+        return false;
+    }
+
+    // Keep the newest versions that still fit
+    pthread_mutex_lock(&g_table_history.lock);
+    uint32_t drop = g_table_history.count > depth ? g_table_history.count - depth : 0;
+    for (uint32_t i = 0; i < drop; i++) {
+        version_free(g_table_history.versions[i]);
+    }
+    memmove(&g_table_history.versions[0], &g_table_history.versions[drop],
+            (g_table_history.count - drop) * sizeof(TableVersion *));
+    g_table_history.count -= drop;
+    g_table_history.depth = depth;
+    pthread_mutex_unlock(&g_table_history.lock);
+    return true;
+}
+
+uint32_t table_history_depth(void) {
+    return g_table_history.depth;
+}
+
+uint32_t table_history_count(void) {
+    return g_table_history.count;
+}
+
+const TableVersion *table_history_get(uint32_t steps) {
+    if (steps >= g_table_history.count) {
+        return NULL;
+    }
+    return g_table_history.versions[g_table_history.count - 1 - steps];
+}
+
+void table_history_set_base(const TableVersion *version) {
+    g_table_history.base = version;
+}
+
+// Chunked member ids back to a flat table of positions
+static void materialize_entries(TableChunk *const *chunks, uint32_t table_size, const uint32_t *position,
+                                uint32_t min_id, uint32_t *out) {
+    for (uint32_t slot = 0; slot < table_size; slot++) {
+        uint32_t id = chunks[slot / TABLE_HISTORY_CHUNK_SLOTS]->slots[slot % TABLE_HISTORY_CHUNK_SLOTS];
+        out[slot] = id == UINT32_MAX ? UINT32_MAX : position[id - min_id];
+    }
+}
+
+static bool materialize(const TableVersion *v, uint32_t *table, uint32_t *backup) {
+    // Member ids to positions; the ids of one version span a narrow range
+    uint32_t min_id = UINT32_MAX, max_id = 0;
+    for (uint32_t i = 0; i < v->node_count; i++) {
+        if (v->ids[i] < min_id) min_id = v->ids[i];
+        if (v->ids[i] > max_id) max_id = v->ids[i];
+    }
+    if (v->node_count == 0) {
+        min_id = max_id = 0;
+    }
+
+    uint32_t *position = malloc(((size_t)max_id - min_id + 1) * sizeof(uint32_t));
+    if (!position) {
+        return false;
+    }
+    for (uint32_t i = 0; i < v->node_count; i++) {
+        position[v->ids[i] - min_id] = i;
+    }
+
+    materialize_entries(v->owner, v->table_size, position, min_id, table);
+    materialize_entries(v->backup, v->table_size, position, min_id, backup);
+    free(position);
+    return true;
+}
+
+bool table_history_checkout(uint32_t steps, uint32_t **table, uint32_t **backup, bool *instant) {
+    pthread_mutex_lock(&g_table_history.lock);
+    TableVersion *v = steps < g_table_history.count ? g_table_history.versions[g_table_history.count - 1 - steps] : NULL;
+    bool ok = v != NULL;
+
+    *instant = ok && v->flat_owner;
+    if (*instant) {
+        // Hand the kept copy over; the republished table is recorded afresh
+        *table = v->flat_owner;
+        *backup = v->flat_backup;
+        v->flat_owner = NULL;
+        v->flat_backup = NULL;
+    } else if (ok) {
+        *table = malloc(v->table_size * sizeof(uint32_t));
+        *backup = malloc(v->table_size * sizeof(uint32_t));
+        ok = *table && *backup && materialize(v, *table, *backup);
+        if (!ok) {
+            free(*table);
+            free(*backup);
+        }
+    }
+    pthread_mutex_unlock(&g_table_history.lock);
+    return ok;
+}
+
+size_t table_history_memory(void) {
+    size_t bytes = g_table_history.chunks * sizeof(TableChunk) + g_table_history.member_bytes;
+    for (uint32_t i = 0; i < g_table_history.count; i++) {
+        const TableVersion *v = g_table_history.versions[i];
+        bytes += sizeof(TableVersion) + 2 * (size_t)v->chunk_count * sizeof(TableChunk *);
+        if (v->flat_owner) {
+            bytes += 2 * (size_t)v->table_size * sizeof(uint32_t);
+        }
+    }
+    return bytes;
+}
+
+size_t table_history_full_copy_memory(void) {
+    size_t bytes = 0;
+    for (uint32_t i = 0; i < g_table_history.count; i++) {
+        bytes += 2 * (size_t)g_table_history.versions[i]->table_size * sizeof(uint32_t);
+    }
+    return bytes;
+}
+
+// Members added and removed relative to an older version
+static void member_changes(const TableVersion *v, const TableVersion *older,
+                           uint32_t *added, uint32_t *removed) {
+    *added = 0;
+    *removed = 0;
+    NameMap map;
+    if (!name_map_build(&map, older->names, older->node_count)) {
+        return;
+    }
+    uint32_t kept = 0;
+    for (uint32_t i = 0; i < v->node_count; i++) {
+        if (name_map_find(&map, older->names, v->names[i]) >= 0) {
+            kept++;
+        } else {
+            (*added)++;
+        }
+    }
+    *removed = older->node_count - kept;
+    free(map.slots);
+}
+
+static void show_locked(void) {
+    if (g_table_history.depth == 0) {
+        printf("Table history is off (history keep <n> to enable)\n");
+        return;
+    }
+    if (g_table_history.count == 0) {
+        printf("No table versions recorded\n");
+        return;
+    }
+
+    uint64_t now = timer_now_ns();
+    printf("Table history (%u of %u kept, newest first, %u-slot chunks):\n",
+           g_table_history.count, g_table_history.depth, TABLE_HISTORY_CHUNK_SLOTS);
+    printf("  %4s %12s %10s %6s %6s %9s %10s %9s\n",
+           "back", "generation", "table_size", "nodes", "down", "members", "new_chunks", "age_s");
+
+    for (uint32_t steps = 0; steps < g_table_history.count; steps++) {
+        const TableVersion *v = table_history_get(steps);
+        const TableVersion *older = table_history_get(steps + 1);
+
+        uint32_t down = 0;
+        for (uint32_t i = 0; i < v->node_count; i++) {
+            down += v->down[i];
+        }
+
+        char members[32] = "-";
+        if (older) {
+            uint32_t added, removed;
+            member_changes(v, older, &added, &removed);
+            snprintf(members, sizeof(members), "+%u -%u", added, removed);
+        }
+
+        printf("  %4u %12llu %10u %6u %6u %9s %10u %9.1f%s\n",
+               steps, (unsigned long long)v->generation, v->table_size, v->node_count, down,
+               members, v->new_chunks, (now - v->published_ns) / 1e9,
+               steps == 0 ? "  (published)" : "");
+    }
+
+    uint32_t flat = 0;
+    for (uint32_t i = 0; i < g_table_history.count; i++) {
+        flat += g_table_history.versions[i]->flat_owner != NULL;
+    }
+
+    size_t used = table_history_memory();
+    size_t full = table_history_full_copy_memory();
+    printf("Memory: %.1f KiB in %zu shared chunks, member lists and %u flat cop%s for instant rollback "
+           "(full copies: %.1f KiB, %.1f%%)\n",
+           used / 1024.0, g_table_history.chunks, flat, flat == 1 ? "y" : "ies",
+           full / 1024.0, full ? 100.0 * used / full : 0.0);
+}
+
+void table_history_show(void) {
+    pthread_mutex_lock(&g_table_history.lock);
+    show_locked();
+    pthread_mutex_unlock(&g_table_history.lock);
+}
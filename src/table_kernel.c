@@ -0,0 +1,110 @@
+#include "table_kernel.h"
+#include "maglev_core.h"
+#include <stddef.h>
+
+// Entry i of the permutation offset, offset + skip, ... (mod size)
+static inline uint32_t permutation_entry(uint32_t offset, uint32_t skip, uint64_t i, uint32_t size) {
+    return (uint32_t)((offset + i * skip) % size);
+}
+
+// Offsets and steps are below size <= 2^31, so one conditional subtract wraps
+static inline uint32_t permutation_step(uint32_t slot, uint32_t step, uint32_t size) {
+    slot += step;
+    return slot >= size ? slot - size : slot;
+}
+
+// Both kernels for table size SIZE. The generic instantiation passes the
+// table_size parameter itself; the specialized ones pass a literal and
+// ignore the parameter.
+//
+// The permutation is written as 8 interleaved chains: entry i + c comes
+// from chain c, which steps by 8 * skip, so the add and wrap of one entry
+// no longer wait for the previous one.
+#define DEFINE_TABLE_KERNEL(suffix, SIZE)                                                       \
+    static void permutation_##suffix(uint32_t *list, uint32_t table_size, uint32_t offset,      \
+                                     uint32_t skip, uint32_t begin, uint32_t end) {             \
+        (void)table_size;                                                                       \
+        uint32_t step = permutation_entry(0, skip, 8, (SIZE));                                  \
+        uint32_t c0 = permutation_entry(offset, skip, (uint64_t)begin + 0, (SIZE));             \
+        uint32_t c1 = permutation_entry(offset, skip, (uint64_t)begin + 1, (SIZE));             \
+        uint32_t c2 = permutation_entry(offset, skip, (uint64_t)begin + 2, (SIZE));             \
+        uint32_t c3 = permutation_entry(offset, skip, (uint64_t)begin + 3, (SIZE));             \
+        uint32_t c4 = permutation_entry(offset, skip, (uint64_t)begin + 4, (SIZE));             \
+        uint32_t c5 = permutation_entry(offset, skip, (uint64_t)begin + 5, (SIZE));             \
+        uint32_t c6 = permutation_entry(offset, skip, (uint64_t)begin + 6, (SIZE));             \
+        uint32_t c7 = permutation_entry(offset, skip, (uint64_t)begin + 7, (SIZE));             \
+        uint32_t i = begin;                                                                     \
+        for (; end - i >= 8; i += 8) {                                                          \
+            list[i] = c0;                                                                       \
+            list[i + 1] = c1;                                                                   \
+            list[i + 2] = c2;                                                                   \
+            list[i + 3] = c3;                                                                   \
+            list[i + 4] = c4;                                                                   \
+            list[i + 5] = c5;                                                                   \
+            list[i + 6] = c6;                                                                   \
+            list[i + 7] = c7;                                                                   \
+            c0 = permutation_step(c0, step, (SIZE));                                            \
+            c1 = permutation_step(c1, step, (SIZE));                                            \
+            c2 = permutation_step(c2, step, (SIZE));                                            \
+            c3 = permutation_step(c3, step, (SIZE));                                            \
+            c4 = permutation_step(c4, step, (SIZE));                                            \
+            c5 = permutation_step(c5, step, (SIZE));                                            \
+            c6 = permutation_step(c6, step, (SIZE));                                            \
+            c7 = permutation_step(c7, step, (SIZE));                                            \
+        }                                                                                       \
+        const uint32_t tail[7] = { c0, c1, c2, c3, c4, c5, c6 };                                \
+        for (uint32_t c = 0; i < end; i++, c++) {                                               \
+            list[i] = tail[c];                                                                  \
+        }                                                                                       \
+    }                                                                                           \
+                                                                                                \
+    static void slots_##suffix(const uint64_t *keys, uint32_t *slots, uint32_t count,          \
+                               uint32_t table_size) {                                           \
+        (void)table_size;                                                                       \
+        for (uint32_t i = 0; i < count; i++) {                                                  \
+            slots[i] = maglev_slot(keys[i], (SIZE));                                            \
+        }                                                                                       \
+    }
+
+#define TABLE_KERNEL(suffix, SIZE) { (SIZE), permutation_##suffix, slots_##suffix }
+
+DEFINE_TABLE_KERNEL(generic, table_size)
+
+// The default size and the next primes after 2^17, 2^18, 640K, 10^6 and 2^20
+DEFINE_TABLE_KERNEL(65537, 65537u)
+DEFINE_TABLE_KERNEL(131101, 131101u)
+DEFINE_TABLE_KERNEL(262147, 262147u)
+DEFINE_TABLE_KERNEL(655373, 655373u)
+DEFINE_TABLE_KERNEL(1000003, 1000003u)
+DEFINE_TABLE_KERNEL(1048583, 1048583u)
+
+static const TableKernel generic_kernel = { 0, permutation_generic, slots_generic };
+
+static const TableKernel specialized_kernels[] = {
+    TABLE_KERNEL(65537, 65537u),
+    TABLE_KERNEL(131101, 131101u),
+    TABLE_KERNEL(262147, 262147u),
+    TABLE_KERNEL(655373, 655373u),
+    TABLE_KERNEL(1000003, 1000003u),
+    TABLE_KERNEL(1048583, 1048583u),
+};
+
+#define SPECIALIZED_COUNT (sizeof(specialized_kernels) / sizeof(specialized_kernels[0]))
+
+const TableKernel *table_kernel_select(uint32_t table_size) {
+    for (size_t k = 0; k < SPECIALIZED_COUNT; k++) {
+        if (specialized_kernels[k].table_size == table_size) {
+            return &specialized_kernels[k];
+        }
+    }
+    return &generic_kernel;
+}
+
+const TableKernel *table_kernel_generic(void) {
+    return &generic_kernel;
+}
+
+const TableKernel *table_kernel_specialized(uint32_t *count) {
+    *count = (uint32_t)SPECIALIZED_COUNT;
+    return specialized_kernels;
+}
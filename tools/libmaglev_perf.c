@@ -0,0 +1,242 @@
+#include "libmaglev.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+
+// Performance test for libmaglev: commit cost, single-thread lookup cost,
+// and lookup throughput of concurrent readers with and without a writer
+// churning membership. Every lookup result is checked against the set of
+// ids that can legitimately be returned; exits non-zero on a bad result.
+
+#define PERF_MAX_THREADS 64
+#define PERF_BATCH 4096
+
+typedef struct {
+    libmaglev_t *lm;
+    uint32_t backends;
+    uint64_t seed;
+    volatile int *stop;
+    uint64_t lookups;
+    uint64_t invalid;
+    uint64_t checksum;
+} ReaderJob;
+
+typedef struct {
+    libmaglev_t *lm;
+    uint32_t backends;
+    volatile int *stop;
+    uint64_t *commit_ns;
+    uint64_t commits;
+    uint64_t capacity;
+    uint64_t failures;
+} WriterJob;
+
+static void show_usage(const char *program_name) {
+    printf("Usage: %s [backends] [table_size] [threads] [seconds] [pow2]\n", program_name);
+    printf("\n");
+    printf("  backends    Backends in the table (default 1000)\n");
+    printf("  table_size  Slots, rounded up to a prime (default 65537)\n");
+    printf("  threads     Concurrent lookup threads (default 4)\n");
+    printf("  seconds     Duration of each concurrent phase (default 2)\n");
+    printf("  pow2        Round table_size up to a power of two instead (mask lookups)\n");
+}
+
+static void *reader_thread(void *arg) {
+    ReaderJob *job = arg;
+    uint64_t key = job->seed;
+
+    while (!*job->stop) {
+        for (int i = 0; i < PERF_BATCH; i++) {
+            uint32_t id = libmaglev_lookup(job->lm, libmaglev_hash_key(key++));
+            if (id >= job->backends) {
+                job->invalid++;
+            }
+            job->checksum += id;
+        }
+        job->lookups += PERF_BATCH;
+    }
+    return NULL;
+}
+
+// Take a backend out and put it back, committing after each change
+static void *writer_thread(void *arg) {
+    WriterJob *job = arg;
+    char name[64];
+    uint32_t victim = 0;
+
+    while (!*job->stop) {
+        snprintf(name, sizeof(name), "backend-%05u", victim);
+        for (int step = 0; step < 2; step++) {
+            libmaglev_status status = step == 0 ? libmaglev_remove_backend(job->lm, victim)
+                                                : libmaglev_add_backend(job->lm, victim, name);
+            if (status != LIBMAGLEV_OK) {
+                job->failures++;
+            }
+
+            uint64_t start = timer_now_ns();
+            libmaglev_commit(job->lm);
+            uint64_t elapsed = timer_now_ns() - start;
+
+            if (job->commits < job->capacity) {
+                job->commit_ns[job->commits] = elapsed;
+            }
+            job->commits++;
+        }
+        victim = (victim + 1) % job->backends;
+    }
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Run readers for the given time, optionally against a churning writer
+static uint64_t run_phase(libmaglev_t *lm, uint32_t backends, uint32_t threads,
+                          double seconds, WriterJob *writer, double *rate) {
+    pthread_t reader_ids[PERF_MAX_THREADS], writer_id;
+    ReaderJob jobs[PERF_MAX_THREADS];
+    volatile int stop = 0;
+    uint32_t started = 0;
+
+    memset(jobs, 0, sizeof(jobs));
+    for (uint32_t t = 0; t < threads; t++) {
+        jobs[t].lm = lm;
+        jobs[t].backends = backends;
+        jobs[t].seed = (uint64_t)t << 40;
+        jobs[t].stop = &stop;
+        if (pthread_create(&reader_ids[t], NULL, reader_thread, &jobs[t]) != 0) {
+            break;
+        }
+        started++;
+    }
+
+    bool writing = false;
+    if (writer) {
+        writer->stop = &stop;
+        writing = pthread_create(&writer_id, NULL, writer_thread, writer) == 0;
+    }
+
+    uint64_t start = timer_now_ns();
+    struct timespec ts = { (time_t)seconds, (long)((seconds - (time_t)seconds) * 1e9) };
+    nanosleep(&ts, NULL);
+    stop = 1;
+
+    uint64_t lookups = 0, invalid = 0;
+    for (uint32_t t = 0; t < started; t++) {
+        pthread_join(reader_ids[t], NULL);
+        lookups += jobs[t].lookups;
+        invalid += jobs[t].invalid;
+    }
+    if (writing) {
+        pthread_join(writer_id, NULL);
+    }
+
+    *rate = lookups / ((timer_now_ns() - start) / 1e9);
+    return invalid;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 6 || (argc > 1 && strcmp(argv[1], "-h") == 0)) {
+        show_usage(argv[0]);
+        return argc > 6 ? 1 : 0;
+    }
+
+    uint32_t backends = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 10) : 1000;
+    uint32_t table_size = argc > 2 ? (uint32_t)strtoul(argv[2], NULL, 10) : 65537;
+    uint32_t threads = argc > 3 ? (uint32_t)strtoul(argv[3], NULL, 10) : 4;
+    double seconds = argc > 4 ? strtod(argv[4], NULL) : 2.0;
+    bool pow2 = argc > 5 && strcmp(argv[5], "pow2") == 0;
+    if ((argc > 5 && !pow2) || backends == 0 || backends > LIBMAGLEV_MAX_BACKENDS ||
+        threads == 0 || threads > PERF_MAX_THREADS || seconds <= 0) {
+        show_usage(argv[0]);
+        return 1;
+    }
+
+    libmaglev_t *lm;
+    libmaglev_status status = pow2 ? libmaglev_create_pow2(table_size, &lm)
+                                   : libmaglev_create(table_size, &lm);
+    if (status != LIBMAGLEV_OK) {
+        printf("Error: %s: %s\n", pow2 ? "libmaglev_create_pow2" : "libmaglev_create",
+               libmaglev_strerror(status));
+        return 1;
+    }
+
+    // Build
+    char name[64];
+    uint64_t start = timer_now_ns();
+    for (uint32_t id = 0; id < backends; id++) {
+        snprintf(name, sizeof(name), "backend-%05u", id);
+        status = libmaglev_add_backend(lm, id, name);
+        if (status != LIBMAGLEV_OK) {
+            printf("Error: libmaglev_add_backend: %s\n", libmaglev_strerror(status));
+            libmaglev_destroy(lm);
+            return 1;
+        }
+    }
+    uint64_t added = timer_now_ns();
+    libmaglev_commit(lm);
+    uint64_t committed = timer_now_ns();
+
+    libmaglev_info info;
+    libmaglev_get_info(lm, &info);
+    printf("libmaglev: %u backends, %u slots, %.1f MB\n",
+           backends, info.table_size, info.memory_bytes / (1024.0 * 1024.0));
+    printf("  Add (preference lists): %.2f ms, first commit: %.2f ms\n",
+           (added - start) / 1e6, (committed - added) / 1e6);
+
+    // Single-thread lookup cost
+    uint64_t checksum = 0, invalid = 0;
+    const uint64_t lookups = 20000000;
+    start = timer_now_ns();
+    for (uint64_t key = 0; key < lookups; key++) {
+        uint32_t id = libmaglev_lookup(lm, libmaglev_hash_key(key));
+        invalid += id >= backends;
+        checksum += id;
+    }
+    double lookup_ns = (double)(timer_now_ns() - start) / lookups;
+    printf("  Lookup, 1 thread: %.2f ns (%.1f M/s, checksum %llx)\n",
+           lookup_ns, 1e3 / lookup_ns, (unsigned long long)checksum);
+
+    // Concurrent readers, quiet then churning
+    double quiet_rate, churn_rate;
+    invalid += run_phase(lm, backends, threads, seconds, NULL, &quiet_rate);
+
+    WriterJob writer;
+    memset(&writer, 0, sizeof(writer));
+    writer.lm = lm;
+    writer.backends = backends;
+    writer.capacity = 1 << 20;
+    writer.commit_ns = malloc(writer.capacity * sizeof(uint64_t));
+    if (!writer.commit_ns) {
+        printf("Error: Memory allocation failed\n");
+        libmaglev_destroy(lm);
+        return 1;
+    }
+    invalid += run_phase(lm, backends, threads, seconds, &writer, &churn_rate);
+
+    printf("  Lookup, %u thread%s: %.1f M/s quiet, %.1f M/s while membership churns (%.1f%%)\n",
+           threads, threads == 1 ? "" : "s", quiet_rate / 1e6, churn_rate / 1e6,
+           quiet_rate > 0 ? 100.0 * churn_rate / quiet_rate : 0.0);
+
+    uint64_t recorded = writer.commits < writer.capacity ? writer.commits : writer.capacity;
+    if (recorded > 0) {
+        qsort(writer.commit_ns, recorded, sizeof(uint64_t), compare_u64);
+        printf("  Commit under load: %llu commits, p50 %.2f ms, p99 %.2f ms, max %.2f ms\n",
+               (unsigned long long)writer.commits,
+               writer.commit_ns[recorded / 2] / 1e6,
+               writer.commit_ns[(uint64_t)(recorded * 0.99)] / 1e6,
+               writer.commit_ns[recorded - 1] / 1e6);
+    }
+    free(writer.commit_ns);
+
+    printf("  Invalid lookups: %llu, failed membership calls: %llu\n",
+           (unsigned long long)invalid, (unsigned long long)writer.failures);
+
+    libmaglev_destroy(lm);
+    return invalid == 0 && writer.failures == 0 ? 0 : 1;
+}
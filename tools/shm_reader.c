@@ -0,0 +1,78 @@
+#include "shm_table.h"
+#include "hash.h"
+#include "timer.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Standalone data-plane reader for a table published with 'shm publish <name>'
+static void show_usage(const char *program_name) {
+    printf("Usage: %s <shm_name> [seconds] [key]\n", program_name);
+    printf("\n");
+    printf("  shm_name   Segment name passed to 'shm publish', e.g. /maglev\n");
+    printf("  seconds    Run a lookup loop for this long and report the rate (default 0)\n");
+    printf("  key        Look up a single flow key and print its backend\n");
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2 || argc > 4 || strcmp(argv[1], "-h") == 0) {
+        show_usage(argv[0]);
+        return argc < 2 ? 1 : 0;
+    }
+
+    ShmReader reader;
+    if (!shm_reader_open(&reader, argv[1])) {
+        printf("Error: Cannot attach to shared-memory table '%s'\n", argv[1]);
+        return 1;
+    }
+
+    double seconds = argc > 2 ? strtod(argv[2], NULL) : 0.0;
+    const ShmTableSlot *slot = &reader.header->slots[reader.header->active & 1];
+    printf("Attached to '%s': %zu bytes, generation %llu, %u slots, %u nodes\n",
+           argv[1], reader.size, (unsigned long long)slot->generation,
+           slot->table_size, slot->node_count);
+
+    if (argc > 3) {
+        char name[SHM_NAME_LEN];
+        uint64_t generation = 0;
+        uint64_t key = strtoull(argv[3], NULL, 10);
+        uint32_t owner = shm_reader_lookup(&reader, hash_key64(key), name, &generation, NULL);
+        if (owner == UINT32_MAX) {
+            printf("Key %llu: unassigned (generation %llu)\n",
+                   (unsigned long long)key, (unsigned long long)generation);
+        } else {
+            printf("Key %llu -> %s (node %u, generation %llu)\n",
+                   (unsigned long long)key, name, owner, (unsigned long long)generation);
+        }
+    }
+
+    if (seconds > 0) {
+        uint64_t lookups = 0, generations = 0, checksum = 0;
+        uint64_t last_generation = UINT64_MAX, key = 0;
+        uint32_t retries = 0;
+        uint64_t start = timer_now_ns();
+        uint64_t deadline = start + (uint64_t)(seconds * 1e9);
+        uint64_t now = start;
+
+        while (now < deadline) {
+            for (int i = 0; i < 4096; i++) {
+                uint64_t generation;
+                checksum += shm_reader_lookup(&reader, hash_key64(key++), NULL, &generation, &retries);
+                if (generation != last_generation) {
+                    generations++;
+                    last_generation = generation;
+                }
+            }
+            lookups += 4096;
+            now = timer_now_ns();
+        }
+
+        double elapsed = (now - start) / 1e9;
+        printf("%llu lookups in %.2f s: %.1f M lookups/s, %u retries, %llu generations observed (checksum %llu)\n",
+               (unsigned long long)lookups, elapsed, lookups / elapsed / 1e6, retries,
+               (unsigned long long)generations, (unsigned long long)checksum);
+    }
+
+    shm_reader_close(&reader);
+    return 0;
+}